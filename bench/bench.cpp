@@ -0,0 +1,448 @@
+// SwitchU benchmark suite, built with `make bench` (Linux only).
+//
+// Runs the launcher's real code paths against a generated title library and
+// writes one JSON object per benchmark. Pass --compare with a previous
+// result file to see the change in median time per benchmark. The run fails
+// if a frame benchmark allocates once its view has settled.
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "library_fixture.hpp"
+
+#include "accounts.hpp"
+#include "alloc_count.hpp"
+#include "audio.hpp"
+#include "font.hpp"
+#include "frame_arena.hpp"
+#include "input/CombinedInput.h"
+#include "log.hpp"
+#include "menu.hpp"
+#include "scan_arena.hpp"
+#include "sd_watch.hpp"
+#include "title_extractor.hpp"
+#include "util.hpp"
+#include "wuhb.hpp"
+
+int initialize();
+void load_view_assets();
+void load_deferred_assets();
+void main_loop_step(CombinedInput& baseInput, Uint32 now);
+void open_menu(int menu);
+void close_menu();
+extern TTFText* textRenderer;
+extern SDL_Renderer* main_renderer;
+extern bool load_homebrew_titles;
+
+// Bytes this process has read through read()-like syscalls
+static uint64_t bytes_read() {
+    FILE* io = fopen("/proc/self/io", "r");
+    if (!io) return 0;
+
+    unsigned long long rchar = 0;
+    char line[128];
+    while (fgets(line, sizeof(line), io)) {
+        if (sscanf(line, "rchar: %llu", &rchar) == 1) break;
+    }
+    fclose(io);
+    return rchar;
+}
+
+// === Runner ===
+
+struct BenchResult {
+    std::string name;
+    int iterations;
+    double median_ns;
+    double p95_ns;
+    double allocations; // per iteration
+    double bytes_read;  // per iteration
+};
+
+struct BenchOptions {
+    std::string out_path = "bench_results.json";
+    std::string compare_path;
+    std::string filter;
+    std::string data_dir = "copytosd/switchU";
+    std::string font_path;
+    double threshold = 10.0;
+    bool quick = false;
+};
+
+static BenchOptions options;
+static std::vector<BenchResult> results;
+
+static void run_bench(const std::string& name, int iterations, const std::function<void()>& fn) {
+    if (!options.filter.empty() && name.find(options.filter) == std::string::npos) return;
+    if (options.quick) iterations = std::max(3, iterations / 10);
+
+    fn(); // warm caches so the first sample isn't an outlier
+
+    std::vector<double> samples;
+    samples.reserve(iterations);
+
+    // The /proc read itself allocates, keep it outside the counted window
+    uint64_t read_before = bytes_read();
+    uint64_t allocs_before = alloc_count();
+
+    for (int i = 0; i < iterations; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto end = std::chrono::steady_clock::now();
+        samples.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+    }
+
+    uint64_t allocs = alloc_count() - allocs_before;
+    uint64_t read = bytes_read() - read_before;
+
+    std::sort(samples.begin(), samples.end());
+    BenchResult result;
+    result.name = name;
+    result.iterations = iterations;
+    result.median_ns = samples[samples.size() / 2];
+    result.p95_ns = samples[(size_t)((samples.size() - 1) * 0.95)];
+    result.allocations = (double)allocs / iterations;
+    result.bytes_read = (double)read / iterations;
+    results.push_back(result);
+
+    fprintf(stderr, "%-32s median %12.0f ns  p95 %12.0f ns  %10.1f allocs  %12.0f bytes read\n",
+            name.c_str(), result.median_ns, result.p95_ns, result.allocations, result.bytes_read);
+}
+
+// === Output ===
+
+static bool write_results(const std::string& path) {
+    FILE* out = fopen(path.c_str(), "w");
+    if (!out) {
+        fprintf(stderr, "Failed to open %s for writing\n", path.c_str());
+        return false;
+    }
+
+    // One benchmark per line keeps --compare's reader trivial
+    fprintf(out, "{\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        fprintf(out, "    {\"name\": \"%s\", \"iterations\": %d, \"median_ns\": %.0f, \"p95_ns\": %.0f, \"allocations\": %.1f, \"bytes_read\": %.0f}%s\n",
+                r.name.c_str(), r.iterations, r.median_ns, r.p95_ns, r.allocations, r.bytes_read,
+                i + 1 < results.size() ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+    fclose(out);
+    return true;
+}
+
+static std::map<std::string, BenchResult> read_results(const std::string& path) {
+    std::map<std::string, BenchResult> baseline;
+
+    FILE* in = fopen(path.c_str(), "r");
+    if (!in) {
+        fprintf(stderr, "Failed to open baseline %s\n", path.c_str());
+        return baseline;
+    }
+
+    char line[1024];
+    while (fgets(line, sizeof(line), in)) {
+        char name[256];
+        BenchResult r;
+        if (sscanf(line, " {\"name\": \"%255[^\"]\", \"iterations\": %d, \"median_ns\": %lf, \"p95_ns\": %lf, \"allocations\": %lf, \"bytes_read\": %lf",
+                   name, &r.iterations, &r.median_ns, &r.p95_ns, &r.allocations, &r.bytes_read) == 6) {
+            r.name = name;
+            baseline[r.name] = r;
+        }
+    }
+    fclose(in);
+    return baseline;
+}
+
+// Returns the number of benchmarks whose median regressed past the threshold
+static int compare_results(const std::string& path) {
+    std::map<std::string, BenchResult> baseline = read_results(path);
+    int regressions = 0;
+
+    fprintf(stderr, "\n%-32s %14s %14s %9s %12s\n", "benchmark", "base median", "new median", "change", "allocs");
+    for (const BenchResult& r : results) {
+        auto it = baseline.find(r.name);
+        if (it == baseline.end()) {
+            fprintf(stderr, "%-32s %14s %14.0f %9s %12.1f\n", r.name.c_str(), "-", r.median_ns, "new", r.allocations);
+            continue;
+        }
+
+        double change = (r.median_ns - it->second.median_ns) * 100.0 / it->second.median_ns;
+        bool regressed = change > options.threshold;
+        if (regressed) regressions++;
+
+        fprintf(stderr, "%-32s %14.0f %14.0f %+8.1f%% %5.1f -> %-5.1f%s\n",
+                r.name.c_str(), it->second.median_ns, r.median_ns, change,
+                it->second.allocations, r.allocations, regressed ? "  REGRESSED" : "");
+    }
+    return regressions;
+}
+
+// === Benchmarks ===
+
+static void bench_scan(int titles) {
+    std::string name = "scan_apps/" + std::to_string(titles);
+    std::string root = LibraryFixture::root_for(titles);
+    if (chdir(root.c_str()) != 0) {
+        fprintf(stderr, "Missing fixture %s\n", root.c_str());
+        return;
+    }
+
+    load_homebrew_titles = true;
+    run_bench(name, titles >= 1000 ? 10 : 30, [] {
+        scan_apps(main_renderer);
+    });
+
+    // What the scan put in its arena instead of the heap
+    fprintf(stderr, "%-32s arena  %8u allocs %12u bytes %4u overflow blocks\n", name.c_str(),
+            (unsigned)last_scan_arena_stats.allocations, (unsigned)last_scan_arena_stats.peak_bytes,
+            (unsigned)last_scan_arena_stats.overflow_blocks);
+}
+
+static void bench_meta() {
+    std::string meta = LibraryFixture::root_for(10) + "/" + LibraryFixture::meta_path(0);
+    run_bench("meta/longname", 2000, [&] {
+        auto title = get_longname_from_meta(meta.c_str());
+    });
+
+    // The first generated app is a bundle
+    std::string wuhb = LibraryFixture::root_for(10) + "/fs/vol/external01/wiiu/apps/homebrew_launcher/homebrew_launcher.wuhb";
+    run_bench("meta/wuhb", 2000, [&] {
+        WuhbFile bundle;
+        WuhbMeta meta;
+        if (bundle.open(wuhb.c_str())) bundle.read_meta(meta);
+    });
+}
+
+static void bench_sanitize() {
+    const char* titles[] = {
+        "MARIO KART 8",
+        "Captain Toad: Treasure Tracker",
+        "Minecraft: Wii U Edition",
+        "The Legend of Zelda: Breath of the Wild",
+    };
+    run_bench("sanitize_title_for_path", 20000, [&] {
+        for (const char* title : titles) {
+            auto safe = sanitize_title_for_path(title);
+        }
+    });
+}
+
+static void bench_decode() {
+    std::string png = options.data_dir + "/custom_icons/MARIO KART 8/icon.png";
+    run_bench("decode/png_icon", 200, [&] {
+        SDL_Surface* surface = IMG_Load_RW(SDL_RWFromFile(png.c_str(), "rb"), 1);
+        if (surface) SDL_FreeSurface(surface);
+    });
+
+    std::string tga = LibraryFixture::root_for(10) + "/" + LibraryFixture::icon_path(0);
+    run_bench("decode/tga_icon", 200, [&] {
+        SDL_RWops* rw = SDL_RWFromFile(tga.c_str(), "rb");
+        SDL_Surface* surface = IMG_LoadTGA_RW(rw);
+        if (surface) SDL_FreeSurface(surface);
+        if (rw) SDL_RWclose(rw);
+    });
+}
+
+static void bench_text() {
+    run_bench("text/renderTextAt", 500, [] {
+        textRenderer->renderTextAt("The Legend of Zelda: Breath of the Wild", {255, 255, 255, 255}, 640, 100, TextAlign::Center);
+    });
+
+    // What the first frame showing a title pays
+    run_bench("text/layout_uncached", 500, [] {
+        textRenderer->clearCache();
+        textRenderer->renderTextAt("The Legend of Zelda: Breath of the Wild", {255, 255, 255, 255}, 640, 100, TextAlign::Center, 256, 2);
+        frame_arena_reset();
+    });
+}
+
+static void bench_audio() {
+    // Mixed here instead of by the output device, the same 256 frames it asks for
+    audio_shutdown();
+    audio_init(false);
+
+    static int16_t out[256 * 2];
+    run_bench("audio/mix_idle", 20000, [] {
+        audio_mix(out, 256);
+    });
+    run_bench("audio/mix_3_sounds", 20000, [] {
+        audio_play(SOUND_NAVIGATE);
+        audio_play(SOUND_SELECT);
+        audio_play(SOUND_BACK);
+        audio_mix(out, 256);
+    });
+    audio_shutdown();
+}
+
+// Frames are steady state once none has allocated for this long, e.g. after
+// the thumbnails a view opened with are in
+constexpr Uint32 STEADY_MS = 250;
+constexpr Uint32 MAX_WARMUP_MS = 5000;
+
+static int allocating_frame_benches = 0;
+
+// One main loop pass per iteration from steady state on, with nothing
+// pressed: the pollers, input() and update(). Such a frame has no reason to
+// touch the heap, an allocation on the main thread fails the run. Workers,
+// e.g. the thumbnail loader, aren't counted.
+static void bench_frame(const char* name) {
+    if (!options.filter.empty() && std::string(name).find(options.filter) == std::string::npos) return;
+
+    static CombinedInput idle;
+    auto step = [] {
+        idle.reset();
+        idle.sampleTime = SDL_GetPerformanceCounter();
+        main_loop_step(idle, SDL_GetTicks());
+    };
+
+    Uint32 start = SDL_GetTicks();
+    Uint32 quiet_since = start;
+    while (SDL_GetTicks() - quiet_since < STEADY_MS && SDL_GetTicks() - start < MAX_WARMUP_MS) {
+        uint64_t before = alloc_count_thread();
+        step();
+        if (alloc_count_thread() != before) quiet_since = SDL_GetTicks();
+    }
+
+    static uint64_t frame_allocations;
+    frame_allocations = 0;
+    run_bench(name, 300, [&step] {
+        uint64_t before = alloc_count_thread();
+        step();
+        frame_allocations += alloc_count_thread() - before;
+    });
+    if (frame_allocations > 0) {
+        fprintf(stderr, "%s: %llu allocations in steady-state frames\n", name, (unsigned long long)frame_allocations);
+        allocating_frame_benches++;
+    }
+}
+
+static void bench_frames() {
+    struct { const char* name; int menu; } menus[] = {
+        { "frame/main", MENU_MAIN },
+        { "frame/apps", MENU_APPS },
+        { "frame/user", MENU_USER },
+        { "frame/settings", MENU_SETTINGS },
+    };
+
+    for (auto& menu : menus) {
+        open_menu(menu.menu);
+        bench_frame(menu.name);
+        close_menu();
+    }
+    cur_menu = MENU_MAIN;
+
+    // All Software over the largest library, should cost what it does over the small one
+    if (chdir(LibraryFixture::root_for(1000).c_str()) != 0) return;
+    scan_apps(main_renderer);
+    open_menu(MENU_APPS);
+    bench_frame("frame/apps_1000");
+    close_menu();
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --out FILE        write results here (default bench_results.json)\n"
+            "  --compare FILE    compare against a previous result file\n"
+            "  --threshold PCT   median slowdown that counts as a regression (default 10)\n"
+            "  --filter TEXT     only run benchmarks whose name contains TEXT\n"
+            "  --data DIR        SwitchU SD folder with assets/ and custom_icons/ (default copytosd/switchU)\n"
+            "  --font FILE       TTF font to use (default: first DejaVu/Liberation font found)\n"
+            "  --quick           a tenth of the iterations\n",
+            argv0);
+}
+
+int main(int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--out" && has_value) options.out_path = argv[++i];
+        else if (arg == "--compare" && has_value) options.compare_path = argv[++i];
+        else if (arg == "--threshold" && has_value) options.threshold = atof(argv[++i]);
+        else if (arg == "--filter" && has_value) options.filter = argv[++i];
+        else if (arg == "--data" && has_value) options.data_dir = argv[++i];
+        else if (arg == "--font" && has_value) options.font_path = argv[++i];
+        else if (arg == "--quick") options.quick = true;
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    char cwd[4096];
+    if (!getcwd(cwd, sizeof(cwd))) return 1;
+    std::string base = cwd;
+    auto absolute = [&](std::string& path) {
+        if (!path.empty() && path[0] != '/') path = base + "/" + path;
+    };
+    absolute(options.out_path);
+    absolute(options.compare_path);
+    absolute(options.data_dir);
+    absolute(options.font_path);
+
+    const int library_sizes[] = { 10, 100, 1000 };
+    if (!LibraryFixture::create(library_sizes, 3, options.data_dir, options.font_path)) {
+        return 1;
+    }
+
+    // Scans log a line per title, keep the output to what goes wrong
+    log_init();
+    log_set_level(LOG_LEVEL_WARN);
+
+    // Frames shouldn't wait for vsync, we want the work not the refresh rate
+    SDL_SetHint(SDL_HINT_RENDER_VSYNC, "0");
+
+    if (chdir(LibraryFixture::root_for(10).c_str()) != 0 || initialize() != EXIT_SUCCESS) {
+        fprintf(stderr, "initialize() failed\n");
+        return 1;
+    }
+    load_view_assets();
+    load_deferred_assets();
+    sd_watch_start();
+
+    for (int titles : library_sizes) bench_scan(titles);
+    if (chdir(LibraryFixture::root_for(10).c_str()) != 0) return 1;
+    scan_apps(main_renderer);
+
+    bench_meta();
+    bench_sanitize();
+    bench_decode();
+    bench_text();
+    bench_audio();
+    bench_frames();
+
+    if (!write_results(options.out_path)) return 1;
+    fprintf(stderr, "Wrote %s\n", options.out_path.c_str());
+
+    int status = 0;
+    if (!options.compare_path.empty()) {
+        int regressions = compare_results(options.compare_path);
+        if (regressions > 0) {
+            fprintf(stderr, "%d benchmark(s) regressed by more than %.0f%%\n", regressions, options.threshold);
+            status = 1;
+        }
+    }
+
+    if (allocating_frame_benches > 0) {
+        fprintf(stderr, "%d frame benchmark(s) allocated in steady state\n", allocating_frame_benches);
+        status = 1;
+    }
+
+    sd_watch_shutdown();
+    accounts_shutdown();
+    LibraryFixture::destroy();
+    log_shutdown();
+    return status;
+}
@@ -0,0 +1,76 @@
+#include <cstdio>
+#include <string>
+#include <ftw.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "library_fixture.hpp"
+#include "library_gen.hpp"
+
+namespace {
+    std::string base_dir;
+
+    const char* font_candidates[] = {
+        "/usr/share/fonts/truetype/dejavu/DejaVuSans-Bold.ttf",
+        "/usr/share/fonts/TTF/DejaVuSans-Bold.ttf",
+        "/usr/share/fonts/dejavu/DejaVuSans-Bold.ttf",
+        "/usr/share/fonts/truetype/liberation/LiberationSans-Bold.ttf",
+    };
+
+    // Same library shape for every size, titles on mlc and a tenth as many
+    // homebrew apps, listed through the MCP stand-in so the order is fixed
+    LibraryGen::Options library_options(int size, const std::string& sd_data, const std::string& font) {
+        LibraryGen::Options options;
+        options.titles = size;
+        options.custom_icons = size / 10;
+        options.assets_dir = sd_data + "/assets";
+        options.font = font;
+        return options;
+    }
+
+    int remove_entry(const char* path, const struct stat*, int, struct FTW*) {
+        return remove(path);
+    }
+}
+
+namespace LibraryFixture {
+    bool create(const int* sizes, int count, const std::string& sd_data, const std::string& font_path) {
+        char tmpl[] = "/tmp/switchu-bench-XXXXXX";
+        if (!mkdtemp(tmpl)) {
+            fprintf(stderr, "mkdtemp failed\n");
+            return false;
+        }
+        base_dir = tmpl;
+
+        std::string font = font_path;
+        for (const char* candidate : font_candidates) {
+            if (!font.empty()) break;
+            if (access(candidate, R_OK) == 0) font = candidate;
+        }
+        if (font.empty()) fprintf(stderr, "No font found, text benchmarks will measure nothing (use --font)\n");
+
+        for (int i = 0; i < count; ++i) {
+            fprintf(stderr, "Generating %d title library...\n", sizes[i]);
+            if (!LibraryGen::generate(root_for(sizes[i]), library_options(sizes[i], sd_data, font))) return false;
+        }
+        return true;
+    }
+
+    void destroy() {
+        if (base_dir.empty()) return;
+        nftw(base_dir.c_str(), remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+        base_dir.clear();
+    }
+
+    std::string root_for(int size) {
+        return base_dir + "/lib" + std::to_string(size);
+    }
+
+    std::string meta_path(int i) {
+        return LibraryGen::meta_path(i, LibraryGen::Options());
+    }
+
+    std::string icon_path(int i) {
+        return LibraryGen::icon_path(i, LibraryGen::Options());
+    }
+}
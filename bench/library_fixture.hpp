@@ -0,0 +1,18 @@
+#pragma once
+
+#include <string>
+
+// Builds throwaway console filesystem trees (see tools/library_gen.hpp) holding a
+// synthetic title library, one tree per library size.
+namespace LibraryFixture {
+    // sd_data is the SwitchU SD folder to link assets/ from
+    bool create(const int* sizes, int count, const std::string& sd_data, const std::string& font_path);
+    void destroy();
+
+    // Directory to chdir into so ROOT_PATH resolves to the tree for size
+    std::string root_for(int size);
+
+    // Paths of the i-th generated title's files, relative to root_for()
+    std::string meta_path(int i);
+    std::string icon_path(int i);
+}
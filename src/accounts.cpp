@@ -0,0 +1,260 @@
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <sys/stat.h>
+#include <thread>
+#include <unordered_map>
+
+#include "accounts.hpp"
+#include "log.hpp"
+#include "thumbnail.hpp"
+#include "trace.hpp"
+
+namespace {
+    const char CACHE_MAGIC[4] = { 'S', 'U', 'M', 'I' };
+    constexpr uint32_t CACHE_VERSION = 2;
+
+    // Written after the magic, the name, the account id and the face's RGBA32
+    // pixels follow. A face of 0 x 0 is an account that has none.
+    struct CacheHeader {
+        uint32_t version;
+        uint64_t mii_hash;
+        uint16_t width;
+        uint16_t height;
+        uint16_t name_length;
+        uint16_t account_id_length;
+    };
+
+    struct LoadedMii {
+        uint64_t mii_hash;
+        SDL_Texture* texture;   // nullptr if the account has no face
+    };
+
+    struct FoundMii {
+        uint32_t persistent_id;
+        uint64_t mii_hash;
+        bool ok;
+        DecodedImage image;
+    };
+
+    std::vector<PlatformAccount> list;
+    std::unordered_map<uint32_t, LoadedMii> miis;   // by persistent id
+
+    std::thread worker;
+    std::atomic<bool> worker_done{false};
+
+    // Filled by the worker, emptied by accounts_poll()
+    std::mutex found_mutex;
+    std::vector<PlatformAccount> found_list;
+    bool found_list_ready = false;
+    std::deque<FoundMii> found_miis;
+    std::atomic<bool> found_ready{false};   // either of the above has something, read without the lock
+
+    std::string cache_path(uint32_t persistent_id) {
+        char name[32];
+        snprintf(name, sizeof(name), "/%08x.bin", (unsigned)persistent_id);
+        return std::string(ACCOUNTS_CACHE_DIR) + name;
+    }
+
+    bool read_string(FILE* file, uint16_t length, std::string& out) {
+        out.resize(length);
+        return length == 0 || fread(&out[0], 1, length, file) == length;
+    }
+
+    // The account's name and id, and its face unless face is nullptr, as
+    // cached for its current Mii. An edited Mii misses both.
+    bool read_cache(PlatformAccount& account, DecodedImage* face) {
+        FILE* file = fopen(cache_path(account.persistent_id).c_str(), "rb");
+        if (!file) return false;
+
+        char magic[sizeof(CACHE_MAGIC)];
+        CacheHeader header;
+        std::string name, account_id;
+        bool ok = fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+                  memcmp(magic, CACHE_MAGIC, sizeof(magic)) == 0 &&
+                  fread(&header, sizeof(header), 1, file) == 1 &&
+                  header.version == CACHE_VERSION &&
+                  header.mii_hash == account.mii_hash &&
+                  header.width <= ACCOUNT_MII_SIZE && header.height <= ACCOUNT_MII_SIZE &&
+                  read_string(file, header.name_length, name) &&
+                  read_string(file, header.account_id_length, account_id);
+        if (ok && face) {
+            face->width = header.width;
+            face->height = header.height;
+            face->pixels.resize((size_t)face->width * face->height * 4);
+            ok = fread(face->pixels.data(), 1, face->pixels.size(), file) == face->pixels.size();
+        }
+        fclose(file);
+
+        if (ok) {
+            account.name = std::move(name);
+            account.account_id = std::move(account_id);
+        }
+        return ok;
+    }
+
+    // face is nullptr for an account without one
+    void write_cache(const PlatformAccount& account, const DecodedImage* face) {
+        mkdir(ACCOUNTS_CACHE_DIR, 0777);
+        std::string path = cache_path(account.persistent_id);
+        // Written next to the final name first so a half written file is never read back
+        std::string temp = path + ".tmp";
+        FILE* file = fopen(temp.c_str(), "wb");
+        if (!file) return;
+
+        CacheHeader header = { CACHE_VERSION, account.mii_hash, 0, 0, (uint16_t)account.name.size(), (uint16_t)account.account_id.size() };
+        if (face) {
+            header.width = face->width;
+            header.height = face->height;
+        }
+        fwrite(CACHE_MAGIC, 1, sizeof(CACHE_MAGIC), file);
+        fwrite(&header, sizeof(header), 1, file);
+        fwrite(account.name.data(), 1, account.name.size(), file);
+        fwrite(account.account_id.data(), 1, account.account_id.size(), file);
+        if (face) fwrite(face->pixels.data(), 1, face->pixels.size(), file);
+        bool ok = !ferror(file);
+        fclose(file);
+        if (!ok || rename(temp.c_str(), path.c_str()) != 0) {
+            LOG_WARN(LOG_CAT_MAIN, "Couldn't write %s", path.c_str());
+            remove(temp.c_str());
+        }
+    }
+
+    // The face from the system, false if the account has none
+    bool fetch_mii(const PlatformAccount& account, DecodedImage& out) {
+        std::vector<uint8_t> file;
+        if (!platform_account_mii_image(account, file)) return false;
+        return decode_image_memory(file.data(), file.size(), "TGA", ACCOUNT_MII_SIZE, ACCOUNT_MII_SIZE, out);
+    }
+
+    // known: the Mii hashes of the faces already loaded, by persistent id
+    void run(std::unordered_map<uint32_t, uint64_t> known) {
+        TRACE_SCOPE("accounts_refresh");
+        std::vector<PlatformAccount> accounts;
+        if (!platform_list_accounts(accounts)) LOG_WARN(LOG_CAT_MAIN, "Failed to read the accounts");
+
+        // Name, id and face come from the cache together, or from the system
+        // together and then into the cache. Faces already loaded aren't read.
+        std::vector<FoundMii> faces;
+        for (PlatformAccount& account : accounts) {
+            auto loaded = known.find(account.persistent_id);
+            bool want_face = loaded == known.end() || loaded->second != account.mii_hash;
+
+            FoundMii found = { account.persistent_id, account.mii_hash, false, {} };
+            if (read_cache(account, want_face ? &found.image : nullptr)) {
+                found.ok = !found.image.pixels.empty();
+            } else {
+                if (!platform_account_profile(account)) LOG_WARN(LOG_CAT_MAIN, "Failed to read account %08x", (unsigned)account.persistent_id);
+                found.ok = fetch_mii(account, found.image);
+                write_cache(account, found.ok ? &found.image : nullptr);
+            }
+            if (want_face) faces.push_back(std::move(found));
+        }
+
+        std::lock_guard<std::mutex> lock(found_mutex);
+        found_list = accounts;
+        found_list_ready = true;
+        for (FoundMii& found : faces) found_miis.push_back(std::move(found));
+        found_ready.store(true, std::memory_order_release);
+    }
+}
+
+void accounts_refresh() {
+    if (worker.joinable()) return;
+
+    std::unordered_map<uint32_t, uint64_t> known;
+    for (const auto& mii : miis) known[mii.first] = mii.second.mii_hash;
+
+    worker_done.store(false);
+    worker = std::thread([known = std::move(known)]() mutable {
+        TRACE_THREAD_NAME("accounts");
+        run(std::move(known));
+        worker_done.store(true, std::memory_order_release);
+    });
+}
+
+bool accounts_poll(SDL_Renderer* renderer) {
+    if (!worker.joinable()) return false;
+    // Read before taking the results, so nothing the worker adds after it is missed
+    bool done = worker_done.load(std::memory_order_acquire);
+    // Most frames the worker is still busy, those neither lock nor allocate
+    if (!done && !found_ready.load(std::memory_order_acquire)) return false;
+
+    bool changed = false;
+    std::vector<PlatformAccount> new_list;
+    FoundMii found;
+    bool have_mii = false;
+    {
+        std::lock_guard<std::mutex> lock(found_mutex);
+        if (found_list_ready) {
+            new_list = std::move(found_list);
+            found_list_ready = false;
+            changed = true;
+        }
+        if (!found_miis.empty()) {
+            found = std::move(found_miis.front());
+            found_miis.pop_front();
+            have_mii = true;
+        }
+        found_ready.store(found_list_ready || !found_miis.empty(), std::memory_order_relaxed);
+    }
+
+    if (changed) {
+        size_t previous = list.size();
+        list = std::move(new_list);
+        if (list.size() != previous) LOG_INFO(LOG_CAT_MAIN, "%zu accounts", list.size());
+
+        // Faces of accounts that went away
+        for (auto it = miis.begin(); it != miis.end();) {
+            bool listed = false;
+            for (const PlatformAccount& account : list) listed = listed || account.persistent_id == it->first;
+            if (listed) {
+                ++it;
+                continue;
+            }
+            if (it->second.texture) SDL_DestroyTexture(it->second.texture);
+            it = miis.erase(it);
+        }
+    }
+
+    if (have_mii) {
+        LoadedMii& loaded = miis[found.persistent_id];
+        if (loaded.texture) SDL_DestroyTexture(loaded.texture);
+        loaded.mii_hash = found.mii_hash;
+        loaded.texture = found.ok ? thumbnail_texture(renderer, found.image) : nullptr;
+        changed = true;
+    }
+
+    if (done && !have_mii) {
+        std::lock_guard<std::mutex> lock(found_mutex);
+        if (found_miis.empty()) worker.join();
+    }
+    return changed;
+}
+
+const std::vector<PlatformAccount>& accounts_list() {
+    return list;
+}
+
+const PlatformAccount* accounts_current() {
+    for (const PlatformAccount& account : list) {
+        if (account.current) return &account;
+    }
+    return nullptr;
+}
+
+SDL_Texture* accounts_mii(uint32_t persistent_id) {
+    auto it = miis.find(persistent_id);
+    return it == miis.end() ? nullptr : it->second.texture;
+}
+
+void accounts_shutdown() {
+    if (worker.joinable()) worker.join();
+    for (auto& mii : miis) {
+        if (mii.second.texture) SDL_DestroyTexture(mii.second.texture);
+    }
+    miis.clear();
+    found_miis.clear();
+}
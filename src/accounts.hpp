@@ -0,0 +1,36 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <vector>
+
+#include "platform/platform.hpp"
+
+// The console's accounts for the user page: names, Nintendo Network IDs and
+// Mii faces. Everything is read on a worker thread, so neither startup nor
+// opening the page waits on nn::act. Each account's name, id and face are
+// cached together on the SD card, keyed by a hash of the Mii so an edited Mii
+// fetches all of them again. Faces stay loaded as textures for as long as the
+// launcher runs.
+
+#define ACCOUNTS_CACHE_DIR SD_CARD_PATH "switchU/accounts"
+
+// Size the faces are kept at
+constexpr int ACCOUNT_MII_SIZE = 128;
+
+// Reads the accounts again in the background, unless that is already
+// happening. Faces whose Mii didn't change are kept.
+void accounts_refresh();
+
+// Once per frame on the main thread. Hands over what the worker found,
+// uploading at most one face per call. True when anything shown changed.
+bool accounts_poll(SDL_Renderer* renderer);
+
+// Empty until the first refresh finishes
+const std::vector<PlatformAccount>& accounts_list();
+// The signed in account, nullptr until known
+const PlatformAccount* accounts_current();
+// The account's face, nullptr while it loads or if it has none
+SDL_Texture* accounts_mii(uint32_t persistent_id);
+
+// Waits for the worker and destroys the textures
+void accounts_shutdown();
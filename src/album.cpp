@@ -0,0 +1,322 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <dirent.h>
+#include <string>
+#include <strings.h>
+#include <thread>
+#include <vector>
+
+#include "album.hpp"
+#include "grid_view.hpp"
+#include "layout.hpp"
+#include "log.hpp"
+#include "render.hpp"
+#include "thumbnail.hpp"
+#include "trace.hpp"
+
+namespace {
+    // Sizes in 1280x720 design units, scaled for the layout when the album opens
+    constexpr int ALBUM_COLUMNS = 4;
+    constexpr int THUMBNAIL_WIDTH = 256;    // 16:9 like the captures themselves
+    constexpr int THUMBNAIL_HEIGHT = 144;
+    constexpr int CELL_GAP = 24;
+    constexpr int PREFETCH_ROWS = 2;
+
+    // A few pages worth, the grid only ever shows about 16
+    constexpr size_t RESIDENT_THUMBNAILS = 96;
+    // Texture uploads are cheap at this size but not free, a fast scroll
+    // spreads them over a few frames instead of hitching on one
+    constexpr int UPLOADS_PER_FRAME = 4;
+
+    // Same as the main menu's hold-to-scroll
+    constexpr Uint32 REPEAT_DELAY = 500;
+    constexpr Uint32 REPEAT_INTERVAL = 75;
+
+    constexpr int LIST_MAX_DEPTH = 2;   // the plugin keeps one folder per title
+
+    SDL_Rect album_area;
+    int thumbnail_width, thumbnail_height;     // in pixels
+    GridView grid;
+    ThumbnailLoader loader;
+
+    // Filled by the listing thread, handed over once listing_done is set
+    std::thread listing;
+    std::atomic<bool> listing_done{false};
+    std::atomic<bool> listing_cancel{false};
+    std::vector<std::string> listed;
+
+    std::vector<std::string> captures;
+    std::vector<uint8_t> failed;    // per capture, its thumbnail couldn't be decoded
+    bool captures_ready = false;
+
+    TextureResidency thumbnails(RESIDENT_THUMBNAILS);
+    std::vector<uint32_t> requested;    // what set_wanted() was last given
+    std::vector<uint32_t> wanted;       // reused by request_visible()
+
+    bool viewing = false;
+    int viewing_index = 0;
+    SDL_Texture* full_image = nullptr;
+
+    bool is_capture(const char* name) {
+        const char* dot = strrchr(name, '.');
+        if (!dot) return false;
+        return strcasecmp(dot, ".jpg") == 0 || strcasecmp(dot, ".jpeg") == 0 ||
+               strcasecmp(dot, ".png") == 0 || strcasecmp(dot, ".bmp") == 0;
+    }
+
+    const char* base_name(const std::string& path) {
+        size_t slash = path.rfind('/');
+        return path.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+    }
+
+    // Anything that isn't a capture is tried as a folder, that saves a stat()
+    // per entry over readdir()'s d_type, which not every devoptab fills in
+    void list_captures(const std::string& dir, int depth, std::vector<std::string>& out) {
+        DIR* handle = opendir(dir.c_str());
+        if (!handle) return;
+
+        struct dirent* entry;
+        while ((entry = readdir(handle)) != nullptr && !listing_cancel.load(std::memory_order_relaxed)) {
+            if (entry->d_name[0] == '.') continue;
+
+            std::string path = dir + "/" + entry->d_name;
+            if (is_capture(entry->d_name)) {
+                out.push_back(std::move(path));
+            } else if (depth < LIST_MAX_DEPTH) {
+                list_captures(path, depth + 1, out);
+            }
+        }
+        closedir(handle);
+    }
+
+    void start_listing() {
+        listing_done.store(false);
+        listing_cancel.store(false);
+        listing = std::thread([] {
+            TRACE_THREAD_NAME("album");
+            TRACE_SCOPE("album_list");
+            listed.clear();
+            list_captures(ALBUM_SCREENSHOT_DIR, 0, listed);
+
+            // Captures are named after when they were taken, newest first
+            std::sort(listed.begin(), listed.end(), [](const std::string& a, const std::string& b) {
+                return strcmp(base_name(a), base_name(b)) > 0;
+            });
+            listing_done.store(true, std::memory_order_release);
+        });
+    }
+
+    void poll_listing() {
+        if (!listing.joinable() || !listing_done.load(std::memory_order_acquire)) return;
+
+        listing.join();
+        captures = std::move(listed);
+        failed.assign(captures.size(), 0);
+        captures_ready = true;
+        grid.set_count(captures.size());
+        LOG_INFO(LOG_CAT_MAIN, "Album: %zu captures", captures.size());
+    }
+
+    void close_viewer() {
+        viewing = false;
+        if (full_image) SDL_DestroyTexture(full_image);
+        full_image = nullptr;
+    }
+
+    // Full size here means as big as the viewer shows it
+    void open_viewer(int index) {
+        close_viewer();
+        viewing = true;
+        viewing_index = index;
+        loader.request_full({ (uint32_t)index, captures[index], album_area.w, album_area.h, false });
+    }
+
+    // Collects finished decodes, a few per frame
+    void upload_results(SDL_Renderer* renderer) {
+        ThumbnailResult result;
+        for (int i = 0; i < UPLOADS_PER_FRAME && loader.poll(result); ++i) {
+            if (result.full) {
+                // The viewer may have moved on or closed meanwhile
+                if (viewing && result.id == (uint32_t)viewing_index && result.ok) {
+                    if (full_image) SDL_DestroyTexture(full_image);
+                    full_image = thumbnail_texture(renderer, result.image);
+                }
+                continue;
+            }
+
+            if (!result.ok) {
+                if (result.id < failed.size()) failed[result.id] = 1;
+                continue;
+            }
+            if (thumbnails.contains(result.id)) continue;
+
+            SDL_Texture* texture = thumbnail_texture(renderer, result.image);
+            if (texture) thumbnails.insert(result.id, texture);
+        }
+    }
+
+    // Asks for the thumbnails of the cells on screen first, then the ones a
+    // couple of rows either side, and only when that list changed
+    void request_visible() {
+        int first, last, prefetch_first, prefetch_last;
+        grid.visible_range(first, last);
+        grid.visible_range(prefetch_first, prefetch_last, PREFETCH_ROWS);
+
+        wanted.clear();
+        auto want = [&](int i) {
+            if (!failed[i] && !thumbnails.contains(i)) wanted.push_back(i);
+        };
+        for (int i = first; i < last; ++i) want(i);
+        for (int i = last; i < prefetch_last; ++i) want(i);
+        for (int i = first - 1; i >= prefetch_first; --i) want(i);
+
+        if (wanted == requested) return;
+        requested = wanted;
+
+        std::vector<ThumbnailRequest> requests;
+        requests.reserve(wanted.size());
+        for (uint32_t i : wanted) requests.push_back({ i, captures[i], thumbnail_width, thumbnail_height, true });
+        loader.set_wanted(requests);
+    }
+
+    // texture scaled to fit box keeping its aspect ratio, centred
+    SDL_Rect fit_rect(SDL_Texture* texture, const SDL_Rect& box) {
+        int w, h;
+        SDL_QueryTexture(texture, nullptr, nullptr, &w, &h);
+        if (w <= 0 || h <= 0) return box;
+
+        SDL_Rect dst = box;
+        if ((int64_t)w * box.h > (int64_t)h * box.w) {
+            dst.h = (int)((int64_t)h * box.w / w);
+        } else {
+            dst.w = (int)((int64_t)w * box.h / h);
+        }
+        dst.x = box.x + (box.w - dst.w) / 2;
+        dst.y = box.y + (box.h - dst.h) / 2;
+        return dst;
+    }
+
+    void draw_grid(SDL_Renderer* renderer) {
+        int first, last;
+        grid.visible_range(first, last);
+
+        SDL_RenderSetClipRect(renderer, &album_area);
+        for (int i = first; i < last; ++i) {
+            SDL_Rect cell = grid.cell_rect(i);
+            SDL_Texture* thumbnail = thumbnails.use(i);
+            if (thumbnail) {
+                SDL_Rect dst = fit_rect(thumbnail, cell);
+                SDL_RenderCopy(renderer, thumbnail, nullptr, &dst);
+            } else {
+                render_set_color(renderer, COLOR_UI_BOX);
+                SDL_RenderFillRect(renderer, &cell);
+            }
+
+            if (i == grid.selected()) {
+                const int outline_thickness = layout_metric(METRIC_OUTLINE);
+                render_set_color(renderer, COLOR_CYAN);
+                for (int t = 1; t <= outline_thickness; ++t) {
+                    SDL_Rect thick_rect = { cell.x - t, cell.y - t, cell.w + 2 * t, cell.h + 2 * t };
+                    SDL_RenderDrawRect(renderer, &thick_rect);
+                }
+            }
+        }
+        SDL_RenderSetClipRect(renderer, nullptr);
+    }
+
+    void draw_viewer(SDL_Renderer* renderer) {
+        // The thumbnail stands in until the full image is decoded
+        SDL_Texture* image = full_image ? full_image : thumbnails.use(viewing_index);
+        if (!image) return;
+
+        SDL_Rect dst = fit_rect(image, album_area);
+        SDL_RenderCopy(renderer, image, nullptr, &dst);
+    }
+}
+
+void album_open(const SDL_Rect& area) {
+    album_area = area;
+    thumbnail_width = layout_px(THUMBNAIL_WIDTH);
+    thumbnail_height = layout_px(THUMBNAIL_HEIGHT);
+    grid.configure(area, ALBUM_COLUMNS, thumbnail_width, thumbnail_height, layout_px(CELL_GAP));
+    grid.set_count(0);
+    grid.select(0);
+    captures_ready = false;
+    requested.clear();
+
+    loader.start();
+    start_listing();
+}
+
+void album_close() {
+    listing_cancel.store(true);
+    if (listing.joinable()) listing.join();
+
+    loader.stop();
+    close_viewer();
+    thumbnails.clear();
+    captures.clear();
+    failed.clear();
+    captures_ready = false;
+}
+
+bool album_input(Input& input, Uint32 now) {
+    const uint32_t pressed = input.data.buttons_d;
+
+    if (viewing) {
+        if (pressed & Input::BUTTON_B) {
+            close_viewer();
+        } else if ((pressed & (Input::BUTTON_LEFT | Input::STICK_L_LEFT)) && viewing_index > 0) {
+            grid.select(viewing_index - 1);
+            open_viewer(grid.selected());
+        } else if ((pressed & (Input::BUTTON_RIGHT | Input::STICK_L_RIGHT)) && viewing_index + 1 < grid.count()) {
+            grid.select(viewing_index + 1);
+            open_viewer(grid.selected());
+        }
+        return true;
+    }
+
+    if (pressed & Input::BUTTON_B) return false;
+
+    grid.input(input, now, REPEAT_DELAY, REPEAT_INTERVAL);
+
+    if ((pressed & Input::BUTTON_A) && grid.count() > 0) {
+        open_viewer(grid.selected());
+    }
+    return true;
+}
+
+int album_selected() {
+    return grid.selected();
+}
+
+bool album_viewing() {
+    return viewing;
+}
+
+void album_draw(SDL_Renderer* renderer, TTFText* text) {
+    TRACE_FUNCTION();
+    thumbnails.next_frame();
+
+    poll_listing();
+    if (!captures_ready) {
+        text->renderTextAt("Loading...", {255, 255, 255, 255}, album_area.x + album_area.w / 2, album_area.y + album_area.h / 2, TextAlign::Center);
+        return;
+    }
+    if (captures.empty()) {
+        text->renderTextAt("No screenshots", {255, 255, 255, 255}, album_area.x + album_area.w / 2, album_area.y + album_area.h / 2, TextAlign::Center);
+        return;
+    }
+
+    upload_results(renderer);
+
+    if (viewing) {
+        draw_viewer(renderer);
+        return;
+    }
+
+    grid.update();
+    request_visible();
+    draw_grid(renderer);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+#include "font.hpp"
+#include "input/Input.h"
+
+// The screenshot album (MENU_SCREENSHOT): a grid of every capture on the SD
+// card, newest first, and a viewer for one of them at full size. Opening it
+// lists the captures on a background thread and shows the grid right away,
+// thumbnails come in from the thumbnail cache (see thumbnail.hpp) as the
+// grid scrolls, and only the cells on screen are ever drawn.
+
+// Captures are looked for here, the Aroma screenshot plugin's folder
+#define ALBUM_SCREENSHOT_DIR SD_CARD_PATH "wiiu/screenshots"
+
+// area is the part of the screen between the header and the footer
+void album_open(const SDL_Rect& area);
+// Frees the thumbnails and stops the loader
+void album_close();
+
+// Returns false once the user backs out of the album, album_close() it then
+bool album_input(Input& input, Uint32 now);
+
+// The selected capture, and whether the viewer shows it
+int album_selected();
+bool album_viewing();
+
+// Draws the grid or the viewer below the header and above the footer.
+// Also where finished thumbnails are uploaded to the GPU.
+void album_draw(SDL_Renderer* renderer, TTFText* text);
@@ -0,0 +1,95 @@
+#ifdef SWITCHU_ALLOC_COUNT
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "alloc_count.hpp"
+
+namespace {
+    std::atomic<uint64_t> process_count{0};
+    // Constant initialised, so reading it from inside malloc() can't allocate
+    thread_local uint64_t thread_count = 0;
+
+    void count() {
+        process_count.fetch_add(1, std::memory_order_relaxed);
+        ++thread_count;
+    }
+}
+
+uint64_t alloc_count() {
+    return process_count.load(std::memory_order_relaxed);
+}
+
+uint64_t alloc_count_thread() {
+    return thread_count;
+}
+
+#if defined(__GLIBC__)
+
+// glibc lets a program replace malloc and still reach the real one
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void __libc_free(void* ptr);
+}
+
+extern "C" void* malloc(size_t size) {
+    count();
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count_, size_t size) {
+    count();
+    return __libc_calloc(count_, size);
+}
+
+extern "C" void* realloc(void* ptr, size_t size) {
+    count();
+    return __libc_realloc(ptr, size);
+}
+
+extern "C" void free(void* ptr) {
+    __libc_free(ptr);
+}
+
+#else
+
+// newlib has no way back to the real malloc(), count C++ allocations only.
+// The other forms of operator new end up in these two.
+void* operator new(size_t size) {
+    count();
+    void* p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    count();
+    size_t align = std::max(sizeof(void*), (size_t)alignment);
+    void* p = aligned_alloc(align, (size + align - 1) / align * align);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept {
+    free(ptr);
+}
+
+#endif
+
+#endif
@@ -0,0 +1,26 @@
+#pragma once
+
+// Heap allocation counters, for keeping steady-state frames off the heap.
+//
+// Only compiled in with ALLOCS=1 (SWITCHU_ALLOC_COUNT), the benchmark always
+// has them. With glibc every malloc(), calloc() and realloc() in the process
+// is counted, SDL's and operator new's included. Elsewhere only operator new
+// can be replaced portably, so C allocations go uncounted there.
+//
+// Without SWITCHU_ALLOC_COUNT both counters read 0.
+
+#include <cstdint>
+
+#ifdef SWITCHU_ALLOC_COUNT
+
+// Allocations made by every thread so far
+uint64_t alloc_count();
+// Allocations made by the calling thread so far
+uint64_t alloc_count_thread();
+
+#else
+
+inline uint64_t alloc_count() { return 0; }
+inline uint64_t alloc_count_thread() { return 0; }
+
+#endif
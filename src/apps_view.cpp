@@ -0,0 +1,325 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <strings.h>
+#include <vector>
+
+#include "apps_view.hpp"
+#include "grid_view.hpp"
+#include "layout.hpp"
+#include "render.hpp"
+#include "thumbnail.hpp"
+#include "title_extractor.hpp"
+#include "trace.hpp"
+
+namespace {
+    // Sizes in 1280x720 design units, scaled for the layout when the view opens
+    constexpr int APPS_COLUMNS = 6;
+    constexpr int ICON_SIZE = 160;
+    constexpr int CELL_GAP = 32;
+    constexpr int TITLE_STRIP_HEIGHT = 44;  // selected title and sort mode, above the grid
+    constexpr int TITLE_SIDE_MARGIN = 240;  // keeps the title clear of the sort label
+    constexpr int SORT_LABEL_INSET = 48;
+    constexpr int TEXT_TOP = 4;
+    constexpr int LETTER_BOX_SIZE = 96;
+    constexpr int PREFETCH_ROWS = 2;
+
+    // Three pages or so, an icon at cell size is 100KB of texture
+    constexpr size_t RESIDENT_ICONS = 72;
+    constexpr int UPLOADS_PER_FRAME = 4;
+
+    // Same as the main menu's hold-to-scroll
+    constexpr Uint32 REPEAT_DELAY = 500;
+    constexpr Uint32 REPEAT_INTERVAL = 75;
+
+    // How long the letter jumped to stays up
+    constexpr Uint32 LETTER_SHOWN_MS = 600;
+
+    const char* sort_names[APPS_SORT_COUNT] = { "Default", "Title", "Storage" };
+
+    SDL_Rect view_area;
+    int icon_size, cell_gap, title_strip_height;    // in pixels
+    GridView grid;
+    ThumbnailLoader loader;
+    TextureResidency icons(RESIDENT_ICONS);
+
+    AppsSort sort = APPS_SORT_LIBRARY;
+    std::vector<uint32_t> order;    // library index of each cell
+    std::vector<uint8_t> failed;    // per library entry, its icon couldn't be decoded
+    uint32_t order_generation = 0;
+    size_t order_size = 0;
+    bool open = false;
+
+    std::vector<uint32_t> requested;    // what set_wanted() was last given
+    std::vector<uint32_t> wanted;       // reused by request_visible()
+
+    char shown_letter = 0;
+    Uint32 letter_shown_at = 0;
+
+    // Letters jumped between, anything that doesn't start with one is '#'
+    char first_letter(uint32_t entry) {
+        for (const char* p = library.cold.title[entry]; *p; ++p) {
+            if (isalpha((unsigned char)*p)) return toupper((unsigned char)*p);
+            if (isdigit((unsigned char)*p) || (unsigned char)*p >= 0x80) return '#';
+        }
+        return '#';
+    }
+
+    void sort_order() {
+        TRACE_FUNCTION();
+        auto by_title = [](uint32_t a, uint32_t b) {
+            int c = strcasecmp(library.cold.title[a], library.cold.title[b]);
+            return c != 0 ? c < 0 : a < b;
+        };
+
+        order.resize(library.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+
+        if (sort == APPS_SORT_TITLE) {
+            std::sort(order.begin(), order.end(), by_title);
+        } else if (sort == APPS_SORT_DEVICE) {
+            std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+                if (library.cold.device[a] != library.cold.device[b]) return library.cold.device[a] < library.cold.device[b];
+                return by_title(a, b);
+            });
+        }
+    }
+
+    // Re-sorts keeping the same entry selected
+    void resort(size_t selected_entry) {
+        sort_order();
+        grid.set_count(order.size());
+        auto it = std::find(order.begin(), order.end(), (uint32_t)selected_entry);
+        grid.select(it == order.end() ? 0 : it - order.begin());
+    }
+
+    // A rescan replaces every entry, anything keyed on their indices goes
+    void sync_with_library() {
+        if (order_generation == library.generation && order_size == library.size()) return;
+
+        if (order_generation != library.generation) {
+            loader.stop();
+            icons.clear();
+            loader.start();
+            requested.clear();
+            failed.assign(library.size(), 0);
+        }
+        failed.resize(library.size(), 0);
+
+        size_t selected = order_generation == library.generation ? apps_view_selected() : 0;
+        order_generation = library.generation;
+        order_size = library.size();
+        resort(selected);
+    }
+
+    // From the start of the selected entry's letter to the start of the next
+    // one, or back to the start of the previous one
+    void jump_letter(bool forward) {
+        if (order.empty()) return;
+        int pos = grid.selected();
+        char letter = first_letter(order[pos]);
+
+        if (forward) {
+            while (pos < (int)order.size() && first_letter(order[pos]) == letter) ++pos;
+            if (pos == (int)order.size()) return;
+        } else {
+            while (pos > 0 && first_letter(order[pos - 1]) == letter) --pos;
+            if (pos == grid.selected()) {
+                if (pos == 0) return;
+                letter = first_letter(order[pos - 1]);
+                while (pos > 0 && first_letter(order[pos - 1]) == letter) --pos;
+            }
+        }
+
+        grid.select(pos);
+        shown_letter = first_letter(order[pos]);
+        letter_shown_at = SDL_GetTicks();
+    }
+
+    SDL_Texture* entry_icon(uint32_t entry) {
+        // The home row's icons are loaded at full size already
+        if (library.hot.icon[entry]) return library.hot.icon[entry];
+        return icons.use(entry);
+    }
+
+    void upload_results(SDL_Renderer* renderer) {
+        ThumbnailResult result;
+        for (int i = 0; i < UPLOADS_PER_FRAME && loader.poll(result); ++i) {
+            if (result.id >= library.size()) continue;
+            if (!result.ok) {
+                failed[result.id] = 1;
+                continue;
+            }
+
+            SDL_Texture* texture = thumbnail_texture(renderer, result.image);
+            if (!texture) continue;
+            icons.insert(result.id, texture);
+
+            // Same as library_add() samples, without reading back from the GPU
+            const uint8_t* corner = result.image.pixels.data();
+            library.hot.background[result.id] = { corner[0], corner[1], corner[2], 255 };
+        }
+    }
+
+    void request_visible() {
+        int first, last, prefetch_first, prefetch_last;
+        grid.visible_range(first, last);
+        grid.visible_range(prefetch_first, prefetch_last, PREFETCH_ROWS);
+
+        wanted.clear();
+        auto want = [&](int pos) {
+            uint32_t entry = order[pos];
+            if (library.hot.icon[entry] || failed[entry] || icons.contains(entry)) return;
+            if (library.cold.icon_path[entry][0] == '\0') return;
+            wanted.push_back(entry);
+        };
+        for (int i = first; i < last; ++i) want(i);
+        for (int i = last; i < prefetch_last; ++i) want(i);
+        for (int i = first - 1; i >= prefetch_first; --i) want(i);
+
+        if (wanted == requested) return;
+        requested = wanted;
+
+        // Icons keep their alpha, they skip the thumbnail cache
+        std::vector<ThumbnailRequest> requests;
+        requests.reserve(wanted.size());
+        for (uint32_t entry : wanted) requests.push_back({ entry, library.cold.icon_path[entry], icon_size, icon_size, false });
+        loader.set_wanted(requests);
+    }
+
+    void draw_cells(SDL_Renderer* renderer) {
+        int first, last;
+        grid.visible_range(first, last);
+
+        SDL_Rect grid_area = { view_area.x, view_area.y + title_strip_height, view_area.w, view_area.h - title_strip_height };
+        SDL_RenderSetClipRect(renderer, &grid_area);
+        for (int pos = first; pos < last; ++pos) {
+            uint32_t entry = order[pos];
+            SDL_Rect cell = grid.cell_rect(pos);
+
+            SDL_Texture* icon = entry_icon(entry);
+            if (icon) {
+                render_icon_with_background(renderer, icon, library.hot.background[entry], cell, render_icon_fit(icon, cell));
+            } else {
+                render_set_color(renderer, COLOR_UI_BOX);
+                SDL_RenderFillRect(renderer, &cell);
+            }
+
+            if (pos == grid.selected()) {
+                const int outline_thickness = layout_metric(METRIC_OUTLINE);
+                render_set_color(renderer, COLOR_CYAN);
+                for (int t = 1; t <= outline_thickness; ++t) {
+                    SDL_Rect thick_rect = { cell.x - t, cell.y - t, cell.w + 2 * t, cell.h + 2 * t };
+                    SDL_RenderDrawRect(renderer, &thick_rect);
+                }
+            }
+        }
+        SDL_RenderSetClipRect(renderer, nullptr);
+    }
+}
+
+void apps_view_open(const SDL_Rect& area, AppsSort sort_mode, size_t selected_entry) {
+    view_area = area;
+    icon_size = layout_px(ICON_SIZE);
+    cell_gap = layout_px(CELL_GAP);
+    title_strip_height = layout_px(TITLE_STRIP_HEIGHT);
+    SDL_Rect grid_area = { area.x, area.y + title_strip_height, area.w, area.h - title_strip_height };
+    grid.configure(grid_area, APPS_COLUMNS, icon_size, icon_size, cell_gap);
+
+    sort = (sort_mode >= 0 && sort_mode < APPS_SORT_COUNT) ? sort_mode : APPS_SORT_LIBRARY;
+    order_generation = library.generation;
+    order_size = library.size();
+    failed.assign(library.size(), 0);
+    requested.clear();
+    shown_letter = 0;
+    resort(selected_entry);
+
+    loader.start();
+    open = true;
+}
+
+void apps_view_close() {
+    loader.stop();
+    icons.clear();
+    order.clear();
+    open = false;
+}
+
+AppsViewAction apps_view_input(Input& input, Uint32 now) {
+    sync_with_library();
+
+    const uint32_t pressed = input.data.buttons_d;
+    const uint32_t held = input.data.buttons_h;
+
+    if (pressed & Input::BUTTON_B) return APPS_VIEW_BACK;
+    if ((pressed & Input::BUTTON_A) && !order.empty()) return APPS_VIEW_LAUNCH;
+
+    if (pressed & Input::BUTTON_Y) {
+        size_t selected = apps_view_selected();
+        sort = (AppsSort)((sort + 1) % APPS_SORT_COUNT);
+        resort(selected);
+    }
+
+    // ZL+ZR together is the trace toggle, see trace.hpp
+    if ((pressed & Input::BUTTON_ZL) && !(held & Input::BUTTON_ZR)) jump_letter(false);
+    if ((pressed & Input::BUTTON_ZR) && !(held & Input::BUTTON_ZL)) jump_letter(true);
+
+    grid.input(input, now, REPEAT_DELAY, REPEAT_INTERVAL);
+    return APPS_VIEW_NONE;
+}
+
+size_t apps_view_selected() {
+    if (order.empty()) return 0;
+    return order[grid.selected()];
+}
+
+AppsSort apps_view_sort() {
+    return sort;
+}
+
+void apps_view_reload_icon(size_t entry) {
+    if (!open) return;
+    icons.erase(entry);
+    if (entry < failed.size()) failed[entry] = 0;
+
+    // So the next request_visible() asks for it even if nothing else moved
+    requested.clear();
+}
+
+void apps_view_draw(SDL_Renderer* renderer, TTFText* text) {
+    TRACE_FUNCTION();
+    if (!open) return;
+
+    sync_with_library();
+    icons.next_frame();
+
+    const int center_x = view_area.x + view_area.w / 2;
+    if (order.empty()) {
+        text->renderTextAt("No software", {255, 255, 255, 255}, center_x, view_area.y + view_area.h / 2, TextAlign::Center);
+        return;
+    }
+
+    upload_results(renderer);
+    grid.update();
+    request_visible();
+    draw_cells(renderer);
+
+    // Kept clear of the sort label on the right
+    const int text_y = view_area.y + layout_px(TEXT_TOP);
+    const int title_width = view_area.w - 2 * layout_px(TITLE_SIDE_MARGIN);
+    text->renderTextAt(library.cold.title[apps_view_selected()], {0, 255, 245, 255}, center_x, text_y, TextAlign::Center, title_width, 1);
+
+    char sort_label[32];
+    snprintf(sort_label, sizeof(sort_label), "Sort: %s", sort_names[sort]);
+    text->renderTextAt(sort_label, {255, 255, 255, 255}, view_area.x + view_area.w - layout_px(SORT_LABEL_INSET), text_y, TextAlign::Right);
+
+    if (shown_letter && SDL_GetTicks() - letter_shown_at < LETTER_SHOWN_MS) {
+        const int size = layout_px(LETTER_BOX_SIZE);
+        SDL_Rect box = { center_x - size / 2, view_area.y + (view_area.h - size) / 2, size, size };
+        render_set_color(renderer, COLOR_UI_BOX);
+        SDL_RenderFillRect(renderer, &box);
+        char letter[2] = { shown_letter, '\0' };
+        text->renderTextAt(letter, {255, 255, 255, 255}, center_x, box.y + (size - layout_metric(METRIC_FONT_SIZE)) / 2, TextAlign::Center);
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <cstddef>
+
+#include "font.hpp"
+#include "input/Input.h"
+
+// All Software (MENU_APPS): every library entry in a grid, where the home
+// row only has room for the first few. Only the rows on screen are laid out
+// and drawn, and icons not already loaded for the home row are decoded at
+// cell size on a worker thread and kept in a bounded cache, so a frame costs
+// the same with ten titles or a thousand.
+//
+// Y changes the sort, ZL and ZR jump to the previous and next first letter,
+// L and R page.
+
+enum AppsSort {
+    APPS_SORT_LIBRARY,  // the home row's order
+    APPS_SORT_TITLE,
+    APPS_SORT_DEVICE,   // by storage device, then title
+    APPS_SORT_COUNT
+};
+
+enum AppsViewAction {
+    APPS_VIEW_NONE,
+    APPS_VIEW_BACK,     // apps_view_close() it
+    APPS_VIEW_LAUNCH    // launch apps_view_selected()
+};
+
+// area is the part of the screen between the header and the footer.
+// selected_entry is a library index to start on.
+void apps_view_open(const SDL_Rect& area, AppsSort sort, size_t selected_entry);
+void apps_view_close();
+
+AppsViewAction apps_view_input(Input& input, Uint32 now);
+
+// Library index of the selected entry
+size_t apps_view_selected();
+AppsSort apps_view_sort();
+
+// An entry's icon_path or icon changed, drops the view's copy of it
+void apps_view_reload_icon(size_t entry);
+
+void apps_view_draw(SDL_Renderer* renderer, TTFText* text);
@@ -0,0 +1,129 @@
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "asset_pack.hpp"
+#include "asset_pack_format.hpp"
+#include "log.hpp"
+#include "trace.hpp"
+
+// The default pack, linked in by the build (bin2o on the console, see Makefile.linux for Linux)
+extern "C" {
+    extern const uint8_t default_assets_bin[];
+    extern const uint32_t default_assets_bin_size;
+}
+
+namespace {
+    constexpr const char* LOOSE_DIR = SD_CARD_PATH "switchU/assets/";
+
+    struct Pack {
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        const AssetPackEntry* index = nullptr;
+        uint32_t count = 0;
+    };
+
+    bool opened = false;
+    std::vector<uint8_t> sd_data;
+    Pack sd_pack;
+    Pack default_pack;
+
+    // Checks the header and every entry once, lookups trust them afterwards
+    bool parse(const uint8_t* data, size_t size, Pack& out) {
+        if (size < sizeof(AssetPackHeader)) return false;
+        const AssetPackHeader* header = (const AssetPackHeader*)data;
+        if (memcmp(header->magic, ASSET_PACK_MAGIC, sizeof(ASSET_PACK_MAGIC)) != 0 ||
+            asset_pack_get32(header->version) != ASSET_PACK_VERSION) {
+            return false;
+        }
+
+        uint32_t count = asset_pack_get32(header->count);
+        if (count > (size - sizeof(AssetPackHeader)) / sizeof(AssetPackEntry)) return false;
+        const AssetPackEntry* index = (const AssetPackEntry*)(data + sizeof(AssetPackHeader));
+        for (uint32_t i = 0; i < count; ++i) {
+            uint32_t offset = asset_pack_get32(index[i].offset);
+            uint32_t length = asset_pack_get32(index[i].size);
+            if (index[i].name[ASSET_PACK_NAME_SIZE - 1] != '\0' || offset > size || length > size - offset) return false;
+            if (i > 0 && strcmp(index[i - 1].name, index[i].name) >= 0) return false;
+        }
+
+        out = { data, size, index, count };
+        return true;
+    }
+
+    void open_packs() {
+        TRACE_FUNCTION();
+        opened = true;
+
+        if (!parse(default_assets_bin, default_assets_bin_size, default_pack)) {
+            LOG_ERROR(LOG_CAT_MAIN, "The built in asset pack is damaged");
+        }
+
+        FILE* file = fopen(ASSET_PACK_PATH, "rb");
+        if (!file) {
+            LOG_INFO(LOG_CAT_MAIN, "No %s, using the built in assets", ASSET_PACK_PATH);
+            return;
+        }
+
+        // All of it in one read, it is a few hundred KB
+        bool ok = fseek(file, 0, SEEK_END) == 0;
+        long size = ok ? ftell(file) : -1;
+        ok = size > 0 && fseek(file, 0, SEEK_SET) == 0;
+        if (ok) {
+            sd_data.resize(size);
+            ok = fread(sd_data.data(), 1, sd_data.size(), file) == sd_data.size();
+        }
+        fclose(file);
+
+        if (!ok || !parse(sd_data.data(), sd_data.size(), sd_pack)) {
+            LOG_WARN(LOG_CAT_MAIN, "%s is unreadable, using the built in assets", ASSET_PACK_PATH);
+            sd_data.clear();
+            sd_pack = {};
+            return;
+        }
+        LOG_INFO(LOG_CAT_MAIN, "%u assets in %s", (unsigned)sd_pack.count, ASSET_PACK_PATH);
+    }
+
+    const AssetPackEntry* find(const Pack& pack, const char* name) {
+        uint32_t low = 0, high = pack.count;
+        while (low < high) {
+            uint32_t middle = (low + high) / 2;
+            int order = strcmp(pack.index[middle].name, name);
+            if (order == 0) return &pack.index[middle];
+            if (order < 0) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        return nullptr;
+    }
+}
+
+SDL_RWops* asset_pack_rw(const char* name) {
+    if (!opened) open_packs();
+
+    for (const Pack* pack : { &sd_pack, &default_pack }) {
+        const AssetPackEntry* entry = find(*pack, name);
+        if (entry) return SDL_RWFromConstMem(pack->data + asset_pack_get32(entry->offset), asset_pack_get32(entry->size));
+    }
+    return nullptr;
+}
+
+SDL_RWops* asset_rw(const char* name) {
+    SDL_RWops* rw = asset_pack_rw(name);
+    if (rw) return rw;
+
+    std::string path = std::string(LOOSE_DIR) + name;
+    rw = SDL_RWFromFile(path.c_str(), "rb");
+    if (!rw) LOG_WARN(LOG_CAT_MAIN, "No asset %s: %s", name, SDL_GetError());
+    return rw;
+}
+
+void asset_pack_close() {
+    sd_data.clear();
+    sd_data.shrink_to_fit();
+    sd_pack = {};
+    opened = false;
+}
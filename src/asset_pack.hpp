@@ -0,0 +1,28 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+#include "platform/platform.hpp"
+
+// The launcher's artwork and sounds come from one pack file (see
+// asset_pack_format.hpp) instead of a file per asset: the SD card's pack is
+// read with a single sequential read the first time an asset is asked for,
+// and a minimal pack linked into the executable stands in for it, so a
+// missing or damaged SD card pack still gives a complete set. Both are made
+// from copytosd/switchU/assets by tools/asset_pack/ when building.
+//
+// Files under assets/ on the SD card are only read for names neither pack
+// has, and by the hot reload when one changes (see sd_watch.hpp).
+
+#define ASSET_PACK_PATH SD_CARD_PATH "switchU/assets.pack"
+
+// The named asset, e.g. "battery/battery_full.png", from the SD card's pack
+// or the built in one. nullptr if neither has it. Read only, freed by
+// whoever reads it.
+SDL_RWops* asset_pack_rw(const char* name);
+
+// asset_pack_rw(), or else the loose file under assets/
+SDL_RWops* asset_rw(const char* name);
+
+// Frees the SD card pack
+void asset_pack_close();
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+
+// Layout of an asset pack file, shared by the launcher and the packer in
+// tools/asset_pack/. Every number is little endian.
+//
+//   header     AssetPackHeader
+//   index      AssetPackEntry x count, sorted by name
+//   blobs      each starting on an ASSET_PACK_ALIGN boundary
+//
+// Plain byte arrays so the layout is the same for every compiler and byte order.
+
+constexpr char ASSET_PACK_MAGIC[4] = { 'S', 'U', 'P', 'K' };
+constexpr uint32_t ASSET_PACK_VERSION = 1;
+constexpr uint32_t ASSET_PACK_ALIGN = 64;
+constexpr int ASSET_PACK_NAME_SIZE = 56;     // path under assets/ with '/' separators, NUL padded
+
+struct AssetPackHeader {
+    char magic[4];
+    uint8_t version[4];
+    uint8_t count[4];
+    uint8_t reserved[4];
+};
+
+struct AssetPackEntry {
+    char name[ASSET_PACK_NAME_SIZE];
+    uint8_t offset[4];      // from the start of the pack
+    uint8_t size[4];
+};
+
+static_assert(sizeof(AssetPackHeader) == 16, "asset pack header must stay 16 bytes");
+static_assert(sizeof(AssetPackEntry) == 64, "asset pack entries must stay 64 bytes");
+
+inline uint32_t asset_pack_get32(const uint8_t* p) {
+    return p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+inline void asset_pack_put32(uint8_t* p, uint32_t value) {
+    p[0] = value;
+    p[1] = value >> 8;
+    p[2] = value >> 16;
+    p[3] = value >> 24;
+}
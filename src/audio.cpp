@@ -0,0 +1,342 @@
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "asset_pack.hpp"
+#include "audio.hpp"
+#include "log.hpp"
+#include "platform/platform.hpp"
+#include "trace.hpp"
+
+namespace {
+    constexpr const char* SOUNDS_DIR = "sounds/";     // in the asset packs
+    constexpr const char* MUSIC_PATH = SD_CARD_PATH "switchU/music.wav";
+    constexpr const char* sound_files[SOUND_COUNT] = { "navigate.wav", "select.wav", "back.wav" };
+
+    constexpr int VOICE_COUNT = 8;              // more at once and the oldest is cut off
+    constexpr uint32_t QUEUE_SIZE = 16;         // triggers between two mixes, power of two
+    constexpr int MIX_CHUNK_FRAMES = 256;
+    constexpr int MUSIC_BUFFER_FRAMES = 8192;   // ~170 ms, each of the two
+    constexpr int MUSIC_VOLUME = 80;            // of 256, under the effects
+    constexpr Uint32 MUSIC_POLL_MS = 10;
+    constexpr size_t MUSIC_READ_SIZE = 4096;
+
+    // Interleaved stereo at AUDIO_RATE, ready to add into the mix
+    struct Clip {
+        std::vector<int16_t> samples;
+        int frames = 0;
+    };
+
+    struct Voice {
+        const Clip* clip = nullptr;
+        int position = 0;
+        uint64_t started = 0;
+    };
+
+    struct MusicBuffer {
+        int16_t samples[MUSIC_BUFFER_FRAMES * 2];
+        std::atomic<bool> ready{false};     // filled by the worker and not played yet
+    };
+
+    // The music file as the worker reads it
+    struct MusicStream {
+        FILE* file = nullptr;
+        long data_offset = 0;
+        uint32_t data_size = 0;             // whole frames only
+        uint32_t remaining = 0;
+        SDL_AudioStream* converter = nullptr;
+    };
+
+    Clip clips[SOUND_COUNT];
+    bool initialized = false;
+    bool output_open = false;
+
+    // Only the audio thread touches these
+    Voice voices[VOICE_COUNT];
+    uint64_t voices_started = 0;
+    int32_t mix_buffer[MIX_CHUNK_FRAMES * 2];
+    int music_buffer = 0;
+    int music_position = 0;
+    bool music_started = false;         // the worker has filled the first buffer
+
+    // audio_play() writes the head, the mixer the tail
+    uint8_t queue[QUEUE_SIZE];
+    std::atomic<uint32_t> queue_head{0};
+    std::atomic<uint32_t> queue_tail{0};
+
+    MusicBuffer music_buffers[2];
+    MusicStream music;
+    std::thread music_worker;
+    std::atomic<bool> music_on{false};
+    std::atomic<bool> music_stop{false};
+
+    struct {
+        std::atomic<uint64_t> mixes{0}, frames{0}, mix_ns{0}, max_mix_ns{0};
+        std::atomic<uint64_t> triggers{0}, dropped{0}, music_underruns{0};
+    } stats;
+
+    bool load_clip(const char* name, Clip& clip) {
+        std::string path = std::string(SOUNDS_DIR) + name;
+        SDL_RWops* rw = asset_rw(path.c_str());
+        if (!rw) return false;
+
+        SDL_AudioSpec spec;
+        Uint8* data = nullptr;
+        Uint32 length = 0;
+        if (!SDL_LoadWAV_RW(rw, 1, &spec, &data, &length)) {
+            LOG_WARN(LOG_CAT_AUDIO, "Failed to load sound %s: %s", path.c_str(), SDL_GetError());
+            return false;
+        }
+
+        SDL_AudioStream* converter = SDL_NewAudioStream(spec.format, spec.channels, spec.freq, AUDIO_S16SYS, 2, AUDIO_RATE);
+        if (converter && SDL_AudioStreamPut(converter, data, length) == 0 && SDL_AudioStreamFlush(converter) == 0) {
+            clip.samples.resize(SDL_AudioStreamAvailable(converter) / sizeof(int16_t));
+            int got = SDL_AudioStreamGet(converter, clip.samples.data(), clip.samples.size() * sizeof(int16_t));
+            clip.frames = std::max(got, 0) / (2 * sizeof(int16_t));
+        }
+        if (converter) SDL_FreeAudioStream(converter);
+        SDL_FreeWAV(data);
+        return clip.frames > 0;
+    }
+
+    uint32_t read_le32(const uint8_t* p) {
+        return p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+
+    // Finds the 16 bit PCM data of a .wav file and sets up its conversion
+    bool open_music(MusicStream& stream) {
+        stream.file = fopen(MUSIC_PATH, "rb");
+        if (!stream.file) return false;
+
+        uint8_t header[12];
+        if (fread(header, 1, sizeof(header), stream.file) != sizeof(header) ||
+            memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0) {
+            LOG_WARN(LOG_CAT_AUDIO, "Not a wav file: %s", MUSIC_PATH);
+            return false;
+        }
+
+        int channels = 0, rate = 0, bits = 0;
+        uint8_t chunk[8];
+        while (fread(chunk, 1, sizeof(chunk), stream.file) == sizeof(chunk)) {
+            uint32_t size = read_le32(chunk + 4);
+            if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16) {
+                uint8_t format[16];
+                if (fread(format, 1, sizeof(format), stream.file) != sizeof(format)) break;
+                if (format[0] == 1 && format[1] == 0) {    // plain PCM
+                    channels = format[2] | (format[3] << 8);
+                    rate = (int)read_le32(format + 4);
+                    bits = format[14] | (format[15] << 8);
+                }
+                fseek(stream.file, size - sizeof(format) + (size & 1), SEEK_CUR);
+            } else if (memcmp(chunk, "data", 4) == 0) {
+                if (channels < 1 || channels > 2 || bits != 16 || rate <= 0) break;
+                uint32_t frame_size = channels * sizeof(int16_t);
+                stream.data_offset = ftell(stream.file);
+                stream.data_size = size / frame_size * frame_size;
+                stream.remaining = stream.data_size;
+                stream.converter = SDL_NewAudioStream(AUDIO_S16LSB, channels, rate, AUDIO_S16SYS, 2, AUDIO_RATE);
+                return stream.converter != nullptr && stream.data_size > 0;
+            } else {
+                fseek(stream.file, size + (size & 1), SEEK_CUR);
+            }
+        }
+
+        LOG_WARN(LOG_CAT_AUDIO, "Music must be 16 bit PCM, mono or stereo: %s", MUSIC_PATH);
+        return false;
+    }
+
+    void close_music(MusicStream& stream) {
+        if (stream.converter) SDL_FreeAudioStream(stream.converter);
+        if (stream.file) fclose(stream.file);
+        stream = MusicStream();
+    }
+
+    // Decodes the next frames of music, starting over at the end of the file
+    bool fill_music(MusicStream& stream, int16_t* out, int frames) {
+        TRACE_SCOPE("music_fill");
+        uint8_t raw[MUSIC_READ_SIZE];
+        int wanted = frames * 2 * sizeof(int16_t);
+        int got = 0;
+
+        while (got < wanted) {
+            int converted = SDL_AudioStreamGet(stream.converter, (uint8_t*)out + got, wanted - got);
+            if (converted < 0) return false;
+            got += converted;
+            if (got == wanted) break;
+
+            if (stream.remaining == 0) {
+                fseek(stream.file, stream.data_offset, SEEK_SET);
+                stream.remaining = stream.data_size;
+            }
+            size_t size = fread(raw, 1, std::min<size_t>(sizeof(raw), stream.remaining), stream.file);
+            if (size == 0 || SDL_AudioStreamPut(stream.converter, raw, size) != 0) return false;
+            stream.remaining -= size;
+        }
+        return true;
+    }
+
+    // Keeps both buffers full, the mixer empties one while this fills the other
+    void run_music_worker() {
+        TRACE_THREAD_NAME("music");
+        while (!music_stop.load(std::memory_order_relaxed)) {
+            for (MusicBuffer& buffer : music_buffers) {
+                if (buffer.ready.load(std::memory_order_acquire)) continue;
+                if (!fill_music(music, buffer.samples, MUSIC_BUFFER_FRAMES)) {
+                    LOG_ERROR(LOG_CAT_AUDIO, "Failed to read %s, stopping music", MUSIC_PATH);
+                    music_on.store(false, std::memory_order_relaxed);
+                    return;
+                }
+                buffer.ready.store(true, std::memory_order_release);
+            }
+            SDL_Delay(MUSIC_POLL_MS);
+        }
+    }
+
+    void start_queued_sounds() {
+        uint32_t tail = queue_tail.load(std::memory_order_relaxed);
+        uint32_t head = queue_head.load(std::memory_order_acquire);
+
+        for (; tail != head; ++tail) {
+            const Clip& clip = clips[queue[tail % QUEUE_SIZE]];
+            if (clip.frames == 0) continue;
+
+            // A free voice, or the one that has been playing longest
+            Voice* voice = &voices[0];
+            for (Voice& candidate : voices) {
+                if (!candidate.clip) {
+                    voice = &candidate;
+                    break;
+                }
+                if (candidate.started < voice->started) voice = &candidate;
+            }
+            *voice = { &clip, 0, ++voices_started };
+            stats.triggers.fetch_add(1, std::memory_order_relaxed);
+        }
+        queue_tail.store(tail, std::memory_order_release);
+    }
+
+    void mix_voices(int frames) {
+        for (Voice& voice : voices) {
+            if (!voice.clip) continue;
+
+            int count = std::min(frames, voice.clip->frames - voice.position);
+            const int16_t* samples = voice.clip->samples.data() + voice.position * 2;
+            for (int i = 0; i < count * 2; ++i) mix_buffer[i] += samples[i];
+
+            voice.position += count;
+            if (voice.position == voice.clip->frames) voice.clip = nullptr;
+        }
+    }
+
+    // False if the worker fell behind, the rest of the mix goes without music
+    bool mix_music(int frames) {
+        int done = 0;
+        while (done < frames) {
+            MusicBuffer& buffer = music_buffers[music_buffer];
+            if (!buffer.ready.load(std::memory_order_acquire)) return !music_started;
+            music_started = true;
+
+            int count = std::min(frames - done, MUSIC_BUFFER_FRAMES - music_position);
+            const int16_t* samples = buffer.samples + music_position * 2;
+            for (int i = 0; i < count * 2; ++i) mix_buffer[done * 2 + i] += (samples[i] * MUSIC_VOLUME) >> 8;
+
+            done += count;
+            music_position += count;
+            if (music_position == MUSIC_BUFFER_FRAMES) {
+                buffer.ready.store(false, std::memory_order_release);
+                music_buffer ^= 1;
+                music_position = 0;
+            }
+        }
+        return true;
+    }
+}
+
+void audio_init(bool open_output) {
+    TRACE_FUNCTION();
+    if (initialized) return;
+    initialized = true;
+
+    for (int i = 0; i < SOUND_COUNT; ++i) load_clip(sound_files[i], clips[i]);
+
+    if (open_music(music)) {
+        LOG_INFO(LOG_CAT_AUDIO, "Streaming music from %s", MUSIC_PATH);
+        music_stop.store(false);
+        music_on.store(true);
+        music_worker = std::thread(run_music_worker);
+    } else {
+        close_music(music);
+    }
+
+    if (open_output) {
+        output_open = platform_audio_open(AUDIO_RATE, audio_mix);
+        if (!output_open) LOG_WARN(LOG_CAT_AUDIO, "No audio output, sounds are off");
+    }
+}
+
+void audio_shutdown() {
+    if (!initialized) return;
+
+    // The output first, so nothing mixes while the rest goes away
+    if (output_open) platform_audio_close();
+    output_open = false;
+
+    music_stop.store(true);
+    if (music_worker.joinable()) music_worker.join();
+    music_on.store(false);
+    close_music(music);
+
+    AudioStats s = audio_stats();
+    if (s.mixes > 0) {
+        LOG_INFO(LOG_CAT_AUDIO, "Audio: %llu mixes, %.1f us average, %.1f us max, %llu sounds, %llu dropped, %llu music underruns",
+                 (unsigned long long)s.mixes, s.mix_ns / 1000.0 / s.mixes, s.max_mix_ns / 1000.0,
+                 (unsigned long long)s.triggers, (unsigned long long)s.dropped, (unsigned long long)s.music_underruns);
+    }
+    initialized = false;
+}
+
+void audio_play(Sound sound) {
+    uint32_t head = queue_head.load(std::memory_order_relaxed);
+    if (head - queue_tail.load(std::memory_order_acquire) >= QUEUE_SIZE) {
+        stats.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    queue[head % QUEUE_SIZE] = (uint8_t)sound;
+    queue_head.store(head + 1, std::memory_order_release);
+}
+
+void audio_mix(int16_t* out, int frames) {
+    Uint64 start = SDL_GetPerformanceCounter();
+    start_queued_sounds();
+
+    bool underrun = false;
+    for (int done = 0; done < frames; done += MIX_CHUNK_FRAMES) {
+        int count = std::min(frames - done, MIX_CHUNK_FRAMES);
+        memset(mix_buffer, 0, count * 2 * sizeof(int32_t));
+
+        mix_voices(count);
+        if (music_on.load(std::memory_order_relaxed) && !underrun && !mix_music(count)) underrun = true;
+
+        int16_t* chunk = out + done * 2;
+        for (int i = 0; i < count * 2; ++i) chunk[i] = (int16_t)std::clamp(mix_buffer[i], -32768, 32767);
+    }
+
+    uint64_t ns = (SDL_GetPerformanceCounter() - start) * 1000000000ull / SDL_GetPerformanceFrequency();
+    stats.mixes.fetch_add(1, std::memory_order_relaxed);
+    stats.frames.fetch_add(frames, std::memory_order_relaxed);
+    stats.mix_ns.fetch_add(ns, std::memory_order_relaxed);
+    if (ns > stats.max_mix_ns.load(std::memory_order_relaxed)) stats.max_mix_ns.store(ns, std::memory_order_relaxed);
+    if (underrun) stats.music_underruns.fetch_add(1, std::memory_order_relaxed);
+}
+
+AudioStats audio_stats() {
+    return {
+        stats.mixes.load(), stats.frames.load(), stats.mix_ns.load(), stats.max_mix_ns.load(),
+        stats.triggers.load(), stats.dropped.load(), stats.music_underruns.load()
+    };
+}
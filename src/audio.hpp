@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+// UI sound effects and optional background music, mixed in software into one
+// 48 kHz stereo stream the platform plays (see platform_audio_open()).
+//
+// The effects are read from switchU/assets/sounds/ and converted once at
+// audio_init(), so triggering one only queues its id for the audio thread,
+// which starts it on the next mix (a few ms later) in a fixed pool of voices.
+// Music, switchU/music.wav if there is one, is streamed from the SD card by
+// a worker thread into two buffers the mixer plays in turn.
+
+enum Sound {
+    SOUND_NAVIGATE,     // selection moved
+    SOUND_SELECT,       // something opened or launched
+    SOUND_BACK,         // something closed
+    SOUND_COUNT
+};
+
+constexpr int AUDIO_RATE = 48000;
+
+struct AudioStats {
+    uint64_t mixes;             // audio callbacks
+    uint64_t frames;            // frames mixed over all of them
+    uint64_t mix_ns;            // time spent mixing
+    uint64_t max_mix_ns;        // longest single mix
+    uint64_t triggers;          // sounds started
+    uint64_t dropped;           // sounds the trigger queue had no room for
+    uint64_t music_underruns;   // mixes the music worker hadn't filled the next buffer for
+};
+
+// Loads the sounds, starts the music worker and opens the platform's output.
+// Without open_output nothing mixes unless audio_mix() is called directly,
+// as the benchmarks do.
+void audio_init(bool open_output = true);
+void audio_shutdown();
+
+// Main thread only, allocation free; dropped if the queue to the mixer is full
+void audio_play(Sound sound);
+
+// Mixes frames interleaved stereo frames into out, called from the
+// platform's audio thread (or a benchmark)
+void audio_mix(int16_t* out, int frames);
+
+AudioStats audio_stats();
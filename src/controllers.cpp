@@ -0,0 +1,54 @@
+#include "controllers.hpp"
+#include "log.hpp"
+#include "trace.hpp"
+
+namespace {
+    // Batteries drain over hours, a couple of seconds late is fine
+    constexpr Uint32 STATUS_INTERVAL_MS = 2000;
+    constexpr int MAX_LISTENERS = 4;
+
+    PlatformControllerStatus statuses[PLATFORM_CONTROLLER_SLOTS];
+    ControllerListener listeners[MAX_LISTENERS] = {};
+    int listener_count = 0;
+    bool have_status = false;
+    Uint32 last_status = 0;
+
+    void emit(ControllerEventType type, int slot) {
+        ControllerEvent event = { type, slot };
+        for (int i = 0; i < listener_count; i++) listeners[i](event);
+    }
+}
+
+void controllers_subscribe(ControllerListener listener) {
+    if (listener_count == MAX_LISTENERS) {
+        LOG_ERROR(LOG_CAT_INPUT, "Too many controller listeners");
+        return;
+    }
+    listeners[listener_count++] = listener;
+}
+
+void controllers_poll(Uint32 now) {
+    bool hotplug = platform_controllers_changed();
+    if (have_status && !hotplug && now - last_status < STATUS_INTERVAL_MS) return;
+
+    TRACE_SCOPE("controllers_status");
+    last_status = now;
+    for (int slot = 0; slot < PLATFORM_CONTROLLER_SLOTS; slot++) {
+        PlatformControllerStatus previous = statuses[slot];
+        PlatformControllerStatus& current = statuses[slot];
+        platform_controller_status(slot, current);
+
+        if (current.connected != previous.connected) {
+            LOG_INFO(LOG_CAT_INPUT, "Controller %d %s", slot, current.connected ? "connected" : "disconnected");
+            emit(current.connected ? CONTROLLER_CONNECTED : CONTROLLER_DISCONNECTED, slot);
+        } else if (current.connected) {
+            if (current.battery != previous.battery) emit(CONTROLLER_BATTERY_CHANGED, slot);
+            if (current.extension != previous.extension) emit(CONTROLLER_EXTENSION_CHANGED, slot);
+        }
+    }
+    have_status = true;
+}
+
+const PlatformControllerStatus& controller_status(int slot) {
+    return statuses[slot];
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+#include "platform/platform.hpp"
+
+// Keeps track of which controllers are connected and their slow changing
+// state: battery and extension. That is probed every couple of seconds, or
+// right after the system reports a controller (dis)connecting, instead of
+// every frame, and what changed is handed to the subscribed listeners.
+
+enum ControllerEventType {
+    CONTROLLER_CONNECTED,
+    CONTROLLER_DISCONNECTED,
+    CONTROLLER_BATTERY_CHANGED,
+    CONTROLLER_EXTENSION_CHANGED
+};
+
+struct ControllerEvent {
+    ControllerEventType type;
+    int slot;       // see PLATFORM_CONTROLLER_SLOTS
+};
+
+using ControllerListener = void (*)(const ControllerEvent& event);
+
+// Listeners are called on the main thread from controllers_poll(), after the
+// slot's controller_status() is updated. The first poll reports every
+// connected controller as CONTROLLER_CONNECTED.
+void controllers_subscribe(ControllerListener listener);
+
+// Once per frame, only probes when the timer is due or after a hotplug
+void controllers_poll(Uint32 now);
+
+const PlatformControllerStatus& controller_status(int slot);
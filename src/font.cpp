@@ -1,21 +1,41 @@
+#include <cstring>
+
 #include "font.hpp"
-#include <iostream>
+#include "frame_arena.hpp"
+#include "log.hpp"
+#include "trace.hpp"
 
-TTFText::TTFText(SDL_Renderer* renderer) : renderer(renderer), font(nullptr) {
-    if (TTF_Init() == -1) {
-        std::cerr << "TTF_Init failed: " << TTF_GetError() << std::endl;
+namespace {
+    // Titles, menu labels and the few strings that change (battery), with room to spare
+    constexpr size_t TEXT_CACHE_SIZE = 256;
+
+    uint64_t text_key(const char* message, SDL_Color color, int max_width, int max_lines, TextAlign align) {
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        auto add = [&hash](uint64_t value) {
+            hash ^= value;
+            hash *= 0x100000001b3ULL;
+        };
+        for (const char* p = message; *p; ++p) add((unsigned char)*p);
+        add(((uint64_t)color.r << 24) | (color.g << 16) | (color.b << 8) | color.a);
+        add((uint32_t)max_width);
+        add((uint32_t)max_lines);
+        add((uint64_t)align);
+        return hash;
     }
 }
 
+TTFText::TTFText(SDL_Renderer* renderer) : renderer(renderer), font(nullptr) {
+}
+
 TTFText::~TTFText() {
-    if (font) TTF_CloseFont(font);
-    TTF_Quit();
+    clearCache();
+    for (TTF_Font* f : fonts) TTF_CloseFont(f);
 }
 
 bool TTFText::loadFont(const std::string& path, int size, bool bold) {
     font = TTF_OpenFont(path.c_str(), size);
     if (!font) {
-        std::cerr << "Failed to load font: " << TTF_GetError() << std::endl;
+        LOG_ERROR(LOG_CAT_RENDER, "Failed to load font: %s", TTF_GetError());
         return false;
     }
 
@@ -23,40 +43,157 @@ bool TTFText::loadFont(const std::string& path, int size, bool bold) {
         TTF_SetFontStyle(font, TTF_STYLE_BOLD);
     }
 
+    this->size = size;
+    this->bold = bold;
+    fonts.insert(fonts.begin(), font);
+    clearCache();
     return true;
 }
 
-SDL_Texture* TTFText::renderText(const std::string& message, SDL_Color color) {
-    if (!font) return nullptr;
-    SDL_Surface* surface = TTF_RenderUTF8_Blended(font, message.c_str(), color);
-    if (!surface) return nullptr;
-    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
-    SDL_FreeSurface(surface);
+bool TTFText::addFallback(TTF_Font* fallback) {
+    if (!fallback) {
+        LOG_WARN(LOG_CAT_RENDER, "Failed to load fallback font: %s", TTF_GetError());
+        return false;
+    }
+
+    if (bold) TTF_SetFontStyle(fallback, TTF_STYLE_BOLD);
+    fonts.push_back(fallback);
+
+    // Text laid out before may have had missing glyphs
+    clearCache();
+    return true;
+}
+
+bool TTFText::addFallbackFont(const std::string& path) {
+    if (!font) return false;
+    return addFallback(TTF_OpenFont(path.c_str(), size));
+}
+
+bool TTFText::addFallbackFont(const void* data, size_t size) {
+    if (!font) return false;
+    return addFallback(TTF_OpenFontRW(SDL_RWFromConstMem(data, size), 1, this->size));
+}
+
+// Draws each run with its own font onto one surface, a run's baseline is
+// lined up with the primary font's
+SDL_Texture* TTFText::renderLayout(const TextLayout& layout, SDL_Color color, TextAlign align) {
+    TRACE_FUNCTION();
+    if (layout.width <= 0) return nullptr;
+
+    std::pmr::string piece(frame_arena());
+    auto render_run = [&](const TextRun& run) {
+        piece.assign(layout.text, run.start, run.end - run.start);
+        return TTF_RenderUTF8_Blended(fonts[run.font], piece.c_str(), color);
+    };
+
+    // Nearly everything is one line in one font, TTF renders that directly
+    if (layout.lines.size() == 1 && layout.lines[0].run_count == 1) {
+        SDL_Surface* surface = render_run(layout.runs[layout.lines[0].first_run]);
+        if (!surface) return nullptr;
+        SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
+        SDL_FreeSurface(surface);
+        return texture;
+    }
+
+    SDL_Surface* target = SDL_CreateRGBSurfaceWithFormat(0, layout.width, layout.height, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (!target) return nullptr;
+
+    const int ascent = TTF_FontAscent(fonts[0]);
+    for (size_t i = 0; i < layout.lines.size(); ++i) {
+        const TextLine& line = layout.lines[i];
+        int line_x = 0;
+        if (align == TextAlign::Center) line_x = (layout.width - line.width) / 2;
+        else if (align == TextAlign::Right) line_x = layout.width - line.width;
+
+        for (uint32_t r = line.first_run; r < line.first_run + line.run_count; ++r) {
+            const TextRun& run = layout.runs[r];
+            SDL_Surface* surface = render_run(run);
+            if (!surface) continue;
+
+            // Runs don't overlap, copy their alpha rather than blending onto nothing
+            SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_NONE);
+            SDL_Rect dst = { line_x + run.x, (int)i * layout.line_skip + ascent - TTF_FontAscent(fonts[run.font]), surface->w, surface->h };
+            SDL_BlitSurface(surface, nullptr, target, &dst);
+            SDL_FreeSurface(surface);
+        }
+    }
+
+    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, target);
+    SDL_FreeSurface(target);
     return texture;
 }
 
-void TTFText::renderTextAt(const std::string& message, SDL_Color color, int x, int y, TextAlign align) {
-    SDL_Texture* texture = renderText(message, color);
-    if (!texture) return;
+void TTFText::evictOldest() {
+    auto oldest = cache.begin();
+    for (auto it = cache.begin(); it != cache.end(); ++it) {
+        if (it->second.last_used < oldest->second.last_used) oldest = it;
+    }
+    if (oldest->second.text.texture) SDL_DestroyTexture(oldest->second.text.texture);
+    cache.erase(oldest);
+}
+
+const TextTexture& TTFText::layoutText(const char* message, SDL_Color color, int max_width, int max_lines, TextAlign align) {
+    uint64_t key = text_key(message, color, max_width, max_lines, align);
+
+    auto it = cache.find(key);
+    if (it != cache.end() && strcmp(it->second.message.c_str(), message) == 0) {
+        it->second.last_used = ++use_counter;
+        return it->second.text;
+    }
+
+    TRACE_SCOPE("layout_text");
+    if (it == cache.end() && cache.size() >= TEXT_CACHE_SIZE) evictOldest();
+
+    // A new entry, or a different string that hashed the same replacing it
+    CachedText& entry = cache[key];
+    if (entry.text.texture) SDL_DestroyTexture(entry.text.texture);
+
+    // Only needed until it's rendered
+    TextLayout layout(frame_arena());
+    layout_text(fonts, message, max_width, max_lines, layout);
+
+    entry.message = message;
+    entry.color = color;
+    entry.max_width = max_width;
+    entry.max_lines = max_lines;
+    entry.align = align;
+    entry.text.texture = renderLayout(layout, color, align);
+    entry.text.width = layout.width;
+    entry.text.height = layout.height;
+    entry.text.line_count = layout.lines.size();
+    entry.text.truncated = layout.truncated;
+    entry.last_used = ++use_counter;
+    return entry.text;
+}
 
-    int w, h;
-    SDL_QueryTexture(texture, nullptr, nullptr, &w, &h);
+void TTFText::drawText(const TextTexture& text, int x, int y, TextAlign align) {
+    if (!text.texture) return;
 
-    SDL_Rect dst = { x, y, w, h };
+    SDL_Rect dst = { x, y, text.width, text.height };
 
     // Adjust x based on alignment
     switch (align) {
         case TextAlign::Center:
-            dst.x -= w / 2;
+            dst.x -= text.width / 2;
             break;
         case TextAlign::Right:
-            dst.x -= w;
+            dst.x -= text.width;
             break;
         case TextAlign::Left:
         default:
             break;
     }
 
-    SDL_RenderCopy(renderer, texture, nullptr, &dst);
-    SDL_DestroyTexture(texture);
+    SDL_RenderCopy(renderer, text.texture, nullptr, &dst);
+}
+
+void TTFText::renderTextAt(const char* message, SDL_Color color, int x, int y, TextAlign align, int max_width, int max_lines) {
+    drawText(layoutText(message, color, max_width, max_lines, align), x, y, align);
+}
+
+void TTFText::clearCache() {
+    for (auto& entry : cache) {
+        if (entry.second.text.texture) SDL_DestroyTexture(entry.second.text.texture);
+    }
+    cache.clear();
 }
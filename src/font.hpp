@@ -1,26 +1,73 @@
 #pragma once
 #include <string>
+#include <unordered_map>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
 
+#include "text_layout.hpp"
+
 enum class TextAlign {
     Left,
     Center,
     Right
 };
 
+// A laid out and rendered piece of text
+struct TextTexture {
+    SDL_Texture* texture = nullptr;
+    int width = 0;
+    int height = 0;
+    int line_count = 0;
+    bool truncated = false;
+};
+
+// Draws text with one font, plus fallback fonts for characters it lacks.
+// SDL_ttf must already be initialized, the launcher does that once in initialize().
+// Text is laid out (see text_layout.hpp) and rendered once per string and
+// layout, and kept for the frames after that show it again.
 class TTFText {
 public:
     TTFText(SDL_Renderer* renderer);
     ~TTFText();
 
     bool loadFont(const std::string& path, int size, bool bold = false);
-    void renderTextAt(const std::string& message, SDL_Color color, int x, int y, TextAlign align);
+    // Adds a font tried for characters the ones before it don't have, loadFont() first
+    bool addFallbackFont(const std::string& path);
+    // Same from memory, data must outlive this
+    bool addFallbackFont(const void* data, size_t size);
+
+    // Lines no wider than max_width (0 for no limit), at most max_lines of
+    // them (0 for no limit), the rest is ellipsized. align lines up the lines
+    // inside the block.
+    const TextTexture& layoutText(const char* message, SDL_Color color, int max_width = 0, int max_lines = 1, TextAlign align = TextAlign::Left);
+    // x is the left edge, centre or right edge of the block depending on align
+    void drawText(const TextTexture& text, int x, int y, TextAlign align);
+    void renderTextAt(const char* message, SDL_Color color, int x, int y, TextAlign align, int max_width = 0, int max_lines = 1);
+
+    // Drops every cached text
+    void clearCache();
 
 private:
+    struct CachedText {
+        std::string message;
+        SDL_Color color;
+        int max_width;
+        int max_lines;
+        TextAlign align;
+        TextTexture text;
+        uint64_t last_used;
+    };
+
     SDL_Renderer* renderer;
     TTF_Font* font;
-    TextAlign alignment = TextAlign::Left;
+    FontStack fonts;
+    int size = 0;
+    bool bold = false;
+
+    std::unordered_map<uint64_t, CachedText> cache;
+    uint64_t use_counter = 0;
 
-    SDL_Texture* renderText(const std::string& message, SDL_Color color);
+    bool addFallback(TTF_Font* fallback);
+    SDL_Texture* renderLayout(const TextLayout& layout, SDL_Color color, TextAlign align);
+    void evictOldest();
 };
@@ -0,0 +1,18 @@
+#include "frame_arena.hpp"
+#include "scan_arena.hpp"
+
+namespace {
+    // A busy frame lays out a few dozen strings at a few hundred bytes each
+    constexpr size_t FRAME_ARENA_SIZE = 64 * 1024;
+
+    alignas(std::max_align_t) char buffer[FRAME_ARENA_SIZE];
+    ScanArena arena(buffer, sizeof(buffer));
+}
+
+std::pmr::memory_resource* frame_arena() {
+    return &arena;
+}
+
+void frame_arena_reset() {
+    arena.release();
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <memory_resource>
+
+// Scratch memory for what lives only while one frame is built, e.g. a text
+// layout made on a text cache miss (see font.cpp). A ScanArena over a fixed
+// buffer, released when update() ends, so these never reach the heap unless
+// one frame outgrows the buffer. Main thread only.
+std::pmr::memory_resource* frame_arena();
+
+// Drops everything allocated from frame_arena() since the last reset
+void frame_arena_reset();
@@ -0,0 +1,74 @@
+#include <algorithm>
+#include <cstdio>
+
+#include "alloc_count.hpp"
+#include "frame_stats.hpp"
+#include "log.hpp"
+
+void FrameStats::reset() {
+    samples.clear();
+    last_counter = 0;
+    allocating_frames = 0;
+    max_frame_allocations = 0;
+}
+
+void FrameStats::tick() {
+    Uint64 now = SDL_GetPerformanceCounter();
+    // Read on both sides of push_back() so its growth isn't put on a frame
+    uint64_t allocations = alloc_count_thread();
+    if (last_counter != 0) {
+        samples.push_back((float)((now - last_counter) * 1000.0 / SDL_GetPerformanceFrequency()));
+
+        uint64_t frame_allocations = allocations - last_allocations;
+        if (frame_allocations > 0) allocating_frames++;
+        max_frame_allocations = std::max(max_frame_allocations, frame_allocations);
+    }
+    last_counter = now;
+    last_allocations = alloc_count_thread();
+}
+
+static float percentile(std::vector<float>& sorted, float p) {
+    size_t index = (size_t)(p * (sorted.size() - 1) + 0.5f);
+    return sorted[index];
+}
+
+void FrameStats::write_report(const char* path, const char* label) const {
+    if (samples.empty()) {
+        LOG_WARN(LOG_CAT_MAIN, "No frame times recorded for %s run", label);
+        return;
+    }
+
+    std::vector<float> sorted = samples;
+    std::sort(sorted.begin(), sorted.end());
+
+    float p50 = percentile(sorted, 0.50f);
+    float p90 = percentile(sorted, 0.90f);
+    float p95 = percentile(sorted, 0.95f);
+    float p99 = percentile(sorted, 0.99f);
+
+    LOG_INFO(LOG_CAT_MAIN, "Frame times (%s, %u frames): min %.2f p50 %.2f p90 %.2f p95 %.2f p99 %.2f max %.2f ms",
+             label, (unsigned)sorted.size(), sorted.front(), p50, p90, p95, p99, sorted.back());
+#ifdef SWITCHU_ALLOC_COUNT
+    LOG_INFO(LOG_CAT_MAIN, "Allocations (%s): %u of %u frames allocated, at most %llu in one",
+             label, (unsigned)allocating_frames, (unsigned)sorted.size(), (unsigned long long)max_frame_allocations);
+#endif
+
+    FILE* out = fopen(path, "w");
+    if (!out) {
+        LOG_ERROR(LOG_CAT_MAIN, "Failed to open %s for writing", path);
+        return;
+    }
+    fprintf(out, "run: %s\n", label);
+    fprintf(out, "frames: %u\n", (unsigned)sorted.size());
+    fprintf(out, "min: %.3f\n", sorted.front());
+    fprintf(out, "p50: %.3f\n", p50);
+    fprintf(out, "p90: %.3f\n", p90);
+    fprintf(out, "p95: %.3f\n", p95);
+    fprintf(out, "p99: %.3f\n", p99);
+    fprintf(out, "max: %.3f\n", sorted.back());
+#ifdef SWITCHU_ALLOC_COUNT
+    fprintf(out, "allocating_frames: %u\n", (unsigned)allocating_frames);
+    fprintf(out, "max_frame_allocations: %llu\n", (unsigned long long)max_frame_allocations);
+#endif
+    fclose(out);
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <cstdint>
+#include <vector>
+
+// Collects per-frame times so scripted runs can be compared build to build.
+// With ALLOCS=1 it also counts the frames that allocated on the calling
+// thread, see alloc_count.hpp.
+class FrameStats {
+public:
+    void reset();
+
+    // Call once per frame, the first call only starts the clock
+    void tick();
+
+    size_t count() const { return samples.size(); }
+
+    // Writes frame count, min, percentiles and max (in ms) to path and the
+    // log, and the allocating frames if they're counted
+    void write_report(const char* path, const char* label) const;
+
+private:
+    std::vector<float> samples;
+    Uint64 last_counter = 0;
+
+    uint64_t last_allocations = 0;
+    uint32_t allocating_frames = 0;
+    uint64_t max_frame_allocations = 0;
+};
@@ -0,0 +1,43 @@
+#include "gamepad_screen.hpp"
+#include "log.hpp"
+#include "platform/platform.hpp"
+#include "trace.hpp"
+
+namespace {
+    SDL_Window* window = nullptr;
+    SDL_Renderer* renderer = nullptr;
+}
+
+bool gamepad_screen_open() {
+    TRACE_FUNCTION();
+    window = platform_create_window(SCREEN_GAMEPAD, "SwitchU GamePad", GAMEPAD_WIDTH, GAMEPAD_HEIGHT);
+    if (window) renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+
+    if (!renderer) {
+        LOG_WARN(LOG_CAT_RENDER, "No GamePad screen of its own, mirroring the TV: %s", SDL_GetError());
+        gamepad_screen_close();
+        return false;
+    }
+    return true;
+}
+
+bool gamepad_screen_active() {
+    return renderer != nullptr;
+}
+
+void gamepad_screen_close() {
+    if (renderer) SDL_DestroyRenderer(renderer);
+    if (window) SDL_DestroyWindow(window);
+    renderer = nullptr;
+    window = nullptr;
+}
+
+SDL_Renderer* gamepad_screen_renderer() {
+    return renderer;
+}
+
+void gamepad_screen_present() {
+    if (!renderer) return;
+    TRACE_FUNCTION();
+    SDL_RenderPresent(renderer);
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+// The GamePad's own screen. Its window has a renderer of its own that draws
+// the GamePad layout directly. Textures belong to the renderer that made them,
+// so whatever that layout shows (a few UI textures, the page's icons, a font)
+// is loaded a second time for this renderer. It only draws and presents when
+// what the screen shows changed.
+//
+// Where the second window can't be had the GamePad mirrors the TV as before.
+
+constexpr int GAMEPAD_WIDTH = 854;
+constexpr int GAMEPAD_HEIGHT = 480;
+
+// Opens the GamePad's window, false if the GamePad is to mirror the TV
+bool gamepad_screen_open();
+bool gamepad_screen_active();
+void gamepad_screen_close();
+
+// What to draw the GamePad's screen with, nullptr while it mirrors the TV
+SDL_Renderer* gamepad_screen_renderer();
+
+// Shows what was drawn with gamepad_screen_renderer()
+void gamepad_screen_present();
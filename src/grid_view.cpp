@@ -0,0 +1,118 @@
+#include <cmath>
+
+#include "grid_view.hpp"
+
+namespace {
+    const uint32_t GRID_LEFT = Input::BUTTON_LEFT | Input::STICK_L_LEFT;
+    const uint32_t GRID_RIGHT = Input::BUTTON_RIGHT | Input::STICK_L_RIGHT;
+    const uint32_t GRID_UP = Input::BUTTON_UP | Input::STICK_L_UP;
+    const uint32_t GRID_DOWN = Input::BUTTON_DOWN | Input::STICK_L_DOWN;
+    const uint32_t GRID_PAGE_UP = Input::BUTTON_L;
+    const uint32_t GRID_PAGE_DOWN = Input::BUTTON_R;
+    const uint32_t GRID_BUTTONS = GRID_LEFT | GRID_RIGHT | GRID_UP | GRID_DOWN | GRID_PAGE_UP | GRID_PAGE_DOWN;
+}
+
+void GridView::configure(const SDL_Rect& area, int columns, int cell_w, int cell_h, int gap) {
+    this->area = area;
+    this->columns = columns > 0 ? columns : 1;
+    this->cell_w = cell_w;
+    this->cell_h = cell_h;
+    this->gap = gap;
+}
+
+void GridView::set_count(int count) {
+    item_count = count;
+    if (selection >= item_count) selection = item_count > 0 ? item_count - 1 : 0;
+}
+
+void GridView::select(int index) {
+    if (item_count == 0) {
+        selection = 0;
+        return;
+    }
+    if (index < 0) index = 0;
+    if (index >= item_count) index = item_count - 1;
+    selection = index;
+}
+
+int GridView::rows_per_page() const {
+    int rows = area.h / row_height();
+    return rows > 0 ? rows : 1;
+}
+
+bool GridView::move(uint32_t direction) {
+    int before = selection;
+    int column = selection % columns;
+
+    if (direction & GRID_LEFT) {
+        if (column > 0) select(selection - 1);
+    } else if (direction & GRID_RIGHT) {
+        if (column < columns - 1 && selection + 1 < item_count) select(selection + 1);
+    } else if (direction & GRID_UP) {
+        if (selection >= columns) select(selection - columns);
+    } else if (direction & GRID_DOWN) {
+        // The last row may be short, stop on its last item
+        if ((selection / columns) < (item_count - 1) / columns) select(selection + columns);
+    } else if (direction & GRID_PAGE_UP) {
+        select(selection - rows_per_page() * columns);
+    } else if (direction & GRID_PAGE_DOWN) {
+        select(selection + rows_per_page() * columns);
+    }
+
+    return selection != before;
+}
+
+bool GridView::input(Input& input, Uint32 now, Uint32 delay, Uint32 interval) {
+    uint32_t pressed = input.data.buttons_d & GRID_BUTTONS;
+    uint32_t holding = input.data.buttons_h & GRID_BUTTONS;
+
+    if (pressed) {
+        held = pressed;
+        held_since = now;
+        last_repeat = now;
+        return move(pressed);
+    }
+
+    if (!(holding & held)) {
+        held = 0;
+        return false;
+    }
+
+    if (now - held_since >= delay && now - last_repeat >= interval) {
+        last_repeat = now;
+        return move(held);
+    }
+    return false;
+}
+
+void GridView::update() {
+    int row_top = (selection / columns) * row_height();
+    if (row_top < target_scroll) {
+        target_scroll = row_top;
+    } else if (row_top + cell_h > target_scroll + area.h) {
+        target_scroll = row_top + cell_h - area.h;
+    }
+
+    const float scroll_speed = 0.25f;
+    scroll += (target_scroll - scroll) * scroll_speed;
+    if (fabsf(target_scroll - scroll) < 1.0f) scroll = target_scroll;
+}
+
+void GridView::visible_range(int& first, int& last, int margin_rows) const {
+    int first_row = (int)scroll / row_height() - margin_rows;
+    int last_row = ((int)scroll + area.h) / row_height() + 1 + margin_rows;
+    if (first_row < 0) first_row = 0;
+
+    first = first_row * columns;
+    last = last_row * columns;
+    if (first > item_count) first = item_count;
+    if (last > item_count) last = item_count;
+}
+
+SDL_Rect GridView::cell_rect(int index) const {
+    // Cells are centred horizontally in the area
+    int grid_w = columns * cell_w + (columns - 1) * gap;
+    int x = area.x + (area.w - grid_w) / 2 + (index % columns) * (cell_w + gap);
+    int y = area.y + (index / columns) * row_height() - (int)scroll;
+    return { x, y, cell_w, cell_h };
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+#include "input/Input.h"
+
+// Selection and scrolling for a grid of same size cells too long to draw
+// whole. Only the rows in view (see visible_range()) are laid out and drawn,
+// so a grid of ten thousand items costs the same per frame as one of ten.
+class GridView {
+public:
+    // area is the part of the screen the grid scrolls in
+    void configure(const SDL_Rect& area, int columns, int cell_w, int cell_h, int gap);
+    void set_count(int count);
+    int count() const { return item_count; }
+
+    int selected() const { return selection; }
+    void select(int index);
+
+    // Moves the selection with the d-pad and left stick, held directions
+    // repeat after delay ms every interval ms, L and R move a page. Returns
+    // true if the selection changed.
+    bool input(Input& input, Uint32 now, Uint32 delay, Uint32 interval);
+
+    // Eases the scroll position towards keeping the selection in view, once per frame
+    void update();
+
+    // Items [first, last) with at least part of their cell on screen,
+    // plus margin_rows rows either side to prefetch
+    void visible_range(int& first, int& last, int margin_rows = 0) const;
+
+    // Screen rect of an item's cell at the current scroll position
+    SDL_Rect cell_rect(int index) const;
+
+    int rows_per_page() const;
+
+private:
+    SDL_Rect area = { 0, 0, 0, 0 };
+    int columns = 1;
+    int cell_w = 0;
+    int cell_h = 0;
+    int gap = 0;
+
+    int item_count = 0;
+    int selection = 0;
+    float scroll = 0.0f;    // pixels from the top of the first row
+    int target_scroll = 0;
+
+    uint32_t held = 0;      // direction buttons held since the last press
+    Uint32 held_since = 0;
+    Uint32 last_repeat = 0;
+
+    int row_height() const { return cell_h + gap; }
+    bool move(uint32_t direction);
+};
@@ -0,0 +1,44 @@
+#include <algorithm>
+#include <climits>
+
+#include "hit_index.hpp"
+
+void HitIndex::clear() {
+    entries.clear();
+}
+
+void HitIndex::add(const SDL_Rect& rect, int row, int index) {
+    entries.push_back({ rect, 0, { row, index } });
+}
+
+void HitIndex::build() {
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return a.rect.x < b.rect.x;
+    });
+
+    int max_right = INT_MIN;
+    for (auto& entry : entries) {
+        max_right = std::max(max_right, entry.rect.x + entry.rect.w);
+        entry.max_right = max_right;
+    }
+}
+
+bool HitIndex::hit_test(int x, int y, HitTarget& out) const {
+    // First entry starting to the right of x, everything before it is a candidate
+    auto it = std::upper_bound(entries.begin(), entries.end(), x, [](int value, const Entry& entry) {
+        return value < entry.rect.x;
+    });
+
+    while (it != entries.begin()) {
+        --it;
+        if (it->max_right <= x) break; // nothing at or before this entry reaches x
+
+        const SDL_Rect& r = it->rect;
+        if (x < r.x + r.w && y >= r.y && y < r.y + r.h) {
+            out = it->target;
+            return true;
+        }
+    }
+
+    return false;
+}
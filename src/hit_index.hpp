@@ -0,0 +1,35 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <vector>
+
+struct HitTarget {
+    int row;
+    int index;
+};
+
+// Interactive rects of one layer sorted along x. Rebuilt only when the
+// layout changes; lookups are a binary search plus a short backwards scan
+// over rects that still reach the query point.
+class HitIndex {
+public:
+    void clear();
+    void add(const SDL_Rect& rect, int row, int index);
+
+    // Sorts the rects, call after the last add()
+    void build();
+
+    // Returns true and fills out when (x, y) is inside one of the rects
+    bool hit_test(int x, int y, HitTarget& out) const;
+
+    bool empty() const { return entries.empty(); }
+
+private:
+    struct Entry {
+        SDL_Rect rect;
+        int max_right; // furthest right edge of this and every earlier entry
+        HitTarget target;
+    };
+
+    std::vector<Entry> entries;
+};
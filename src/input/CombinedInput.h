@@ -4,6 +4,15 @@ class CombinedInput : public Input {
 public:
     void combine(const Input &b) {
         data.buttons_h |= b.data.buttons_h;
+
+        // A touch beats a pointer, otherwise the first valid pointer wins
+        bool takePointer = b.data.touched ? !data.touched : (b.data.validPointer && !data.validPointer);
+        if (takePointer) {
+            data.touched      = b.data.touched;
+            data.validPointer = b.data.validPointer;
+            data.x            = b.data.x;
+            data.y            = b.data.y;
+        }
     }
 
     void process() {
@@ -16,5 +25,7 @@ public:
         data.buttons_h = 0;
         data.buttons_d = 0;
         data.buttons_r = 0;
+        data.touched = false;
+        data.validPointer = false;
     }
-};
\ No newline at end of file
+};
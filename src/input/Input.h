@@ -59,4 +59,7 @@ public:
 
     PadData data{};
     PadData lastData{};
+
+    //!When data was read, in SDL performance counter ticks (see input_latency.hpp)
+    uint64_t sampleTime = 0;
 };
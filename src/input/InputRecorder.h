@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdio>
+#include "Input.h"
+#include "log.hpp"
+
+//! On-disk layout shared by InputRecorder and ReplayInput.
+//! Every field is stored little-endian so a recording made on the console
+//! replays the same way on any other build.
+namespace InputRecording {
+    constexpr char MAGIC[4] = {'S', 'U', 'I', 'R'};
+    constexpr uint16_t VERSION = 1;
+
+    constexpr size_t HEADER_SIZE = 12; // magic, version, frame size, frame count
+    constexpr size_t FRAME_SIZE = 12;  // dt, flags, pad, buttons_h, x, y
+
+    enum FrameFlags : uint8_t {
+        FLAG_TOUCHED       = 0x01,
+        FLAG_VALID_POINTER = 0x02
+    };
+
+    struct Frame {
+        uint16_t dt;          //!< ms since the previous frame
+        uint8_t flags;
+        uint32_t buttons_h;   //!< buttons_d/_r are rebuilt by CombinedInput::process()
+        int16_t x;
+        int16_t y;
+    };
+
+    inline void put16(uint8_t *p, uint16_t v) {
+        p[0] = v & 0xFF;
+        p[1] = v >> 8;
+    }
+
+    inline void put32(uint8_t *p, uint32_t v) {
+        put16(p, v & 0xFFFF);
+        put16(p + 2, v >> 16);
+    }
+
+    inline uint16_t get16(const uint8_t *p) {
+        return p[0] | (p[1] << 8);
+    }
+
+    inline uint32_t get32(const uint8_t *p) {
+        return get16(p) | ((uint32_t) get16(p + 2) << 16);
+    }
+}
+
+//! Writes one compact record per frame of combined input to a file
+class InputRecorder {
+public:
+    //!Constructor
+    InputRecorder() = default;
+
+    //!Destructor
+    ~InputRecorder() {
+        close();
+    }
+
+    bool open(const char *path, uint32_t now) {
+        close();
+
+        file = fopen(path, "wb");
+        if (!file) {
+            LOG_ERROR(LOG_CAT_INPUT, "InputRecorder: failed to open %s", path);
+            return false;
+        }
+
+        // The frame count is patched in by close(); readers tolerate a stale one
+        uint8_t header[InputRecording::HEADER_SIZE] = {};
+        memcpy(header, InputRecording::MAGIC, 4);
+        InputRecording::put16(header + 4, InputRecording::VERSION);
+        InputRecording::put16(header + 6, InputRecording::FRAME_SIZE);
+        fwrite(header, 1, sizeof(header), file);
+
+        lastTime = now;
+        frameCount = 0;
+        LOG_INFO(LOG_CAT_INPUT, "InputRecorder: recording to %s", path);
+        return true;
+    }
+
+    void write(const Input &input, uint32_t now) {
+        if (!file) return;
+
+        uint32_t dt = now - lastTime;
+        lastTime = now;
+
+        uint8_t flags = 0;
+        if (input.data.touched) flags |= InputRecording::FLAG_TOUCHED;
+        if (input.data.validPointer) flags |= InputRecording::FLAG_VALID_POINTER;
+
+        uint8_t record[InputRecording::FRAME_SIZE] = {};
+        InputRecording::put16(record, dt > 0xFFFF ? 0xFFFF : dt);
+        record[2] = flags;
+        InputRecording::put32(record + 4, input.data.buttons_h);
+        InputRecording::put16(record + 8, (uint16_t) (int16_t) input.data.x);
+        InputRecording::put16(record + 10, (uint16_t) (int16_t) input.data.y);
+        fwrite(record, 1, sizeof(record), file);
+
+        frameCount++;
+    }
+
+    void close() {
+        if (!file) return;
+
+        uint8_t count[4];
+        InputRecording::put32(count, frameCount);
+        fseek(file, 8, SEEK_SET);
+        fwrite(count, 1, sizeof(count), file);
+
+        fclose(file);
+        file = nullptr;
+        LOG_INFO(LOG_CAT_INPUT, "InputRecorder: wrote %u frames", frameCount);
+    }
+
+    bool isOpen() const {
+        return file != nullptr;
+    }
+
+private:
+    FILE *file = nullptr;
+    uint32_t lastTime = 0;
+    uint32_t frameCount = 0;
+};
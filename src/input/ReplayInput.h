@@ -0,0 +1,80 @@
+#pragma once
+
+#include <vector>
+#include "InputRecorder.h"
+#include "ScriptedInput.h"
+#include "log.hpp"
+
+//! Feeds a recording made by InputRecorder back one frame per update()
+class ReplayInput : public ScriptedInput {
+public:
+    //!Constructor
+    ReplayInput() = default;
+
+    //!Destructor
+    ~ReplayInput() override = default;
+
+    bool load(const char *path) {
+        frames.clear();
+        position = 0;
+
+        FILE *file = fopen(path, "rb");
+        if (!file) {
+            LOG_ERROR(LOG_CAT_INPUT, "ReplayInput: failed to open %s", path);
+            return false;
+        }
+
+        uint8_t header[InputRecording::HEADER_SIZE];
+        if (fread(header, 1, sizeof(header), file) != sizeof(header) ||
+            memcmp(header, InputRecording::MAGIC, 4) != 0 ||
+            InputRecording::get16(header + 4) != InputRecording::VERSION ||
+            InputRecording::get16(header + 6) != InputRecording::FRAME_SIZE) {
+            LOG_ERROR(LOG_CAT_INPUT, "ReplayInput: %s is not a recording this build understands", path);
+            fclose(file);
+            return false;
+        }
+
+        // Read until EOF rather than trusting the header count, a recording
+        // cut short by a title launch never gets its count patched
+        frames.reserve(InputRecording::get32(header + 8));
+        uint8_t record[InputRecording::FRAME_SIZE];
+        while (fread(record, 1, sizeof(record), file) == sizeof(record)) {
+            InputRecording::Frame frame;
+            frame.dt = InputRecording::get16(record);
+            frame.flags = record[2];
+            frame.buttons_h = InputRecording::get32(record + 4);
+            frame.x = (int16_t) InputRecording::get16(record + 8);
+            frame.y = (int16_t) InputRecording::get16(record + 10);
+            frames.push_back(frame);
+        }
+        fclose(file);
+
+        LOG_INFO(LOG_CAT_INPUT, "ReplayInput: loaded %u frames from %s", (unsigned) frames.size(), path);
+        return !frames.empty();
+    }
+
+    bool update(uint32_t &now) override {
+        if (position >= frames.size()) {
+            data.buttons_h = 0;
+            return false;
+        }
+
+        const InputRecording::Frame &frame = frames[position++];
+        now += frame.dt;
+
+        data.buttons_h = frame.buttons_h;
+        data.touched = frame.flags & InputRecording::FLAG_TOUCHED;
+        data.validPointer = frame.flags & InputRecording::FLAG_VALID_POINTER;
+        data.x = frame.x;
+        data.y = frame.y;
+        return true;
+    }
+
+    const char *name() const override {
+        return "replay";
+    }
+
+private:
+    std::vector<InputRecording::Frame> frames;
+    size_t position = 0;
+};
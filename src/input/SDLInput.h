@@ -0,0 +1,69 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include "Input.h"
+
+//! Keyboard and mouse input for desktop builds. The mouse acts as the
+//! GamePad touch screen while the left button is held, over any window
+//! until setTouchWindow() names the GamePad's.
+class SDLInput : public Input {
+public:
+    //!Constructor
+    SDLInput() = default;
+
+    //!Destructor
+    ~SDLInput() override = default;
+
+    void setTouchWindow(SDL_Window *window) {
+        touchWindow = window;
+    }
+
+    bool update(int32_t width, int32_t height) {
+        lastData = data;
+
+        const Uint8 *keys = SDL_GetKeyboardState(nullptr);
+        uint32_t buttons = 0;
+
+        if (keys[SDL_SCANCODE_LEFT]) buttons |= Input::BUTTON_LEFT;
+        if (keys[SDL_SCANCODE_RIGHT]) buttons |= Input::BUTTON_RIGHT;
+        if (keys[SDL_SCANCODE_UP]) buttons |= Input::BUTTON_UP;
+        if (keys[SDL_SCANCODE_DOWN]) buttons |= Input::BUTTON_DOWN;
+        if (keys[SDL_SCANCODE_RETURN] || keys[SDL_SCANCODE_A]) buttons |= Input::BUTTON_A;
+        if (keys[SDL_SCANCODE_BACKSPACE] || keys[SDL_SCANCODE_B]) buttons |= Input::BUTTON_B;
+        if (keys[SDL_SCANCODE_X]) buttons |= Input::BUTTON_X;
+        if (keys[SDL_SCANCODE_Q]) buttons |= Input::BUTTON_ZL;
+        if (keys[SDL_SCANCODE_E]) buttons |= Input::BUTTON_ZR;
+        if (keys[SDL_SCANCODE_EQUALS]) buttons |= Input::BUTTON_PLUS;
+        if (keys[SDL_SCANCODE_MINUS]) buttons |= Input::BUTTON_MINUS;
+        if (keys[SDL_SCANCODE_H]) buttons |= Input::BUTTON_HOME;
+
+        data.buttons_h = buttons;
+        data.buttons_d = buttons & ~lastData.buttons_h;
+        data.buttons_r = lastData.buttons_h & ~buttons;
+
+        int mouse_x, mouse_y;
+        Uint32 mouse = SDL_GetMouseState(&mouse_x, &mouse_y);
+        bool on_touch_window = !touchWindow || SDL_GetMouseFocus() == touchWindow;
+        data.touched = on_touch_window && (mouse & SDL_BUTTON_LMASK) != 0;
+        data.validPointer = data.touched;
+
+        //! the GamePad's window is smaller, touches span the same range as on the console
+        if (touchWindow && on_touch_window) {
+            int window_width, window_height;
+            SDL_GetWindowSize(touchWindow, &window_width, &window_height);
+            if (window_width > 0 && window_height > 0) {
+                mouse_x = mouse_x * width / window_width;
+                mouse_y = mouse_y * height / window_height;
+            }
+        }
+
+        //! same centred, y-up coordinates as VPadInput
+        data.x = mouse_x - (width >> 1);
+        data.y = (height >> 1) - mouse_y;
+
+        return true;
+    }
+
+private:
+    SDL_Window *touchWindow = nullptr;
+};
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "Input.h"
+
+//! Base for input sources that replace the live VPAD/WPAD reads with
+//! pre-recorded or generated frames. They drive their own clock so that
+//! hold/repeat timing in input() is reproducible run to run.
+class ScriptedInput : public Input {
+public:
+    //!Destructor
+    ~ScriptedInput() override = default;
+
+    //! Fills data with the next frame and advances now (in ms).
+    //! Returns false once the script is exhausted.
+    virtual bool update(uint32_t &now) = 0;
+
+    //! Short name used when reporting results
+    virtual const char *name() const = 0;
+};
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <vector>
+#include "ScriptedInput.h"
+
+//! Generates a fixed navigation workload: sweeps the carousel and the bottom
+//! row, opens every menu, the album and the controllers page included, and
+//! toggles homebrew scanning. Runs on a virtual 60Hz clock so hold-to-scroll
+//! behaves identically on every run.
+//! It never presses A on a tile that would launch something.
+class StressInput : public ScriptedInput {
+public:
+    //!Constructor
+    StressInput(int middleTiles, int bottomTiles, int settingsRows, int passes = 3) {
+        for (int pass = 0; pass < passes; ++pass) {
+            buildPass(middleTiles, bottomTiles, settingsRows);
+        }
+    }
+
+    //!Destructor
+    ~StressInput() override = default;
+
+    bool update(uint32_t &now) override {
+        now += FRAME_MS;
+
+        while (position < steps.size() && frameInStep >= steps[position].frames) {
+            position++;
+            frameInStep = 0;
+        }
+
+        if (position >= steps.size()) {
+            data.buttons_h = 0;
+            return false;
+        }
+
+        data.buttons_h = steps[position].buttons;
+        frameInStep++;
+        return true;
+    }
+
+    const char *name() const override {
+        return "stress";
+    }
+
+private:
+    static constexpr uint32_t FRAME_MS = 16;
+
+    struct Step {
+        uint32_t buttons;
+        uint32_t frames;
+    };
+
+    std::vector<Step> steps;
+    size_t position = 0;
+    uint32_t frameInStep = 0;
+
+    void wait(uint32_t frames) {
+        steps.push_back({0, frames});
+    }
+
+    void hold(uint32_t buttons, uint32_t frames) {
+        steps.push_back({buttons, frames});
+        wait(1);
+    }
+
+    //! A single press followed by a few idle frames so the camera can move
+    void press(uint32_t buttons, int times = 1) {
+        for (int i = 0; i < times; ++i) {
+            hold(buttons, 1);
+            wait(5);
+        }
+    }
+
+    // Every pass starts and ends on the first carousel tile with no menu open
+    void buildPass(int middleTiles, int bottomTiles, int settingsRows) {
+        wait(30);
+
+        // Carousel: step through twice (wrapping), then hold to auto-repeat
+        press(BUTTON_RIGHT, middleTiles * 2);
+        hold(BUTTON_RIGHT, 120);
+        hold(BUTTON_LEFT, 120);
+
+        // Game options overlay
+        press(BUTTON_PLUS);
+        wait(30);
+        press(BUTTON_B);
+
+        // Homebrew scanning on and back off, each toggle triggers a rescan
+        press(BUTTON_MINUS);
+        wait(30);
+        press(BUTTON_MINUS);
+        wait(30);
+
+        // Wrap to "All Software" and open it
+        press(BUTTON_LEFT);
+        press(BUTTON_A);
+        wait(30);
+        press(BUTTON_B);
+        press(BUTTON_RIGHT);
+
+        // Bottom row sweep, then open System Settings (tile 6)
+        press(BUTTON_DOWN);
+        press(BUTTON_RIGHT, bottomTiles - 1);
+        press(BUTTON_LEFT, bottomTiles - 1);
+        press(BUTTON_RIGHT, 6);
+        press(BUTTON_A);
+        wait(30);
+        press(BUTTON_B);
+
+        // Album (tile 2): move in the grid, open the selected capture, then B
+        // out of the viewer and the album
+        press(BUTTON_LEFT, 4);
+        press(BUTTON_A);
+        wait(30);
+        press(BUTTON_RIGHT);
+        press(BUTTON_DOWN);
+        press(BUTTON_A);
+        wait(30);
+        press(BUTTON_B, 2);
+
+        // Controllers (tile 4)
+        press(BUTTON_RIGHT, 2);
+        press(BUTTON_A);
+        wait(30);
+        press(BUTTON_B);
+
+        // User page through the top row
+        press(BUTTON_UP, 2);
+        press(BUTTON_A);
+        press(BUTTON_DOWN, settingsRows - 1);
+        press(BUTTON_UP, settingsRows - 1);
+        press(BUTTON_B);
+    }
+};
@@ -39,7 +39,7 @@ public:
             data.buttons_r    = vpad.release;
             data.buttons_h    = vpad.hold;
             data.buttons_d    = vpad.trigger;
-            data.validPointer = !vpad.tpNormal.validity;
+            data.validPointer = !vpad.tpNormal.validity && vpad.tpNormal.touched;
             data.touched      = vpad.tpNormal.touched;
             data.battery      = vpad.battery;
             headphones        = vpad.usingHeadphones ? 1 : 0;
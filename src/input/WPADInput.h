@@ -126,14 +126,31 @@ public:
 
     bool update(int32_t width, int32_t height) {
         lastData = data;
-        WPADExtensionType type;
-        if (WPADProbe(channel, &type) != 0) {
+        if (!connected) {
             data.buttons_h = 0;
             return false;
         }
 
-        KPADRead(channel, &kpad, 1);
-        WPADGetInfo(channel, &wpadInfo);
+        KPADError error = KPAD_ERROR_OK;
+        int32_t samples = KPADReadEx(channel, &kpad, 1, &error);
+
+        //! nothing new since the last read, whatever was held still is
+        if (error == KPAD_ERROR_NO_SAMPLES) {
+            data.buttons_d = 0;
+            data.buttons_r = 0;
+            return true;
+        }
+
+        //! gone since the status poll last looked, kpad holds nothing usable.
+        //! The poll marks the channel connected again once it answers.
+        if (error != KPAD_ERROR_OK || samples <= 0) {
+            data.buttons_h = 0;
+            data.buttons_d = 0;
+            data.buttons_r = 0;
+            data.validPointer = false;
+            setConnected(false);
+            return false;
+        }
 
         if (kpad.extensionType == WPAD_EXT_CORE || kpad.extensionType == WPAD_EXT_NUNCHUK) {
             data.buttons_r = remapWiiMoteButtons(kpad.release);
@@ -145,8 +162,6 @@ public:
             data.buttons_d = remapClassicButtons(kpad.classic.trigger);
         }
 
-        data.battery = wpadInfo.batteryLevel;
-
         data.validPointer = (kpad.posValid == 1 || kpad.posValid == 2) &&
                             (kpad.pos.x >= -1.0f && kpad.pos.x <= 1.0f) &&
                             (kpad.pos.y >= -1.0f && kpad.pos.y <= 1.0f);
@@ -166,6 +181,16 @@ public:
         return true;
     }
 
+    // Whether update() reads the channel at all. Probing it every frame is
+    // what the controller status poll is for, so it sets this instead.
+    void setConnected(bool connected) {
+        this->connected = connected;
+    }
+
+    bool isConnected() const {
+        return connected;
+    }
+
     static void init() {
         KPADInit();
         WPADEnableURCC(1);
@@ -176,6 +201,6 @@ public:
 
 private:
     KPADStatus kpad{};
-    WPADInfo wpadInfo{};
     KPADChan channel;
+    bool connected = false;
 };
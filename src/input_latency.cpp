@@ -0,0 +1,82 @@
+#include <SDL2/SDL.h>
+
+#include <algorithm>
+
+#include "input_latency.hpp"
+#include "log.hpp"
+#include "trace.hpp"
+
+namespace {
+    // 0.25 ms buckets up to 100 ms, a few frames at 60 Hz more than it should ever take
+    constexpr int BUCKET_US = 250;
+    constexpr int BUCKET_COUNT = 400;
+
+    const char* const ACTION_NAMES[LATENCY_ACTION_COUNT] = { "move", "select", "back", "open menu", "launch" };
+    const char* const TRACE_NAMES[LATENCY_ACTION_COUNT] = {
+        "latency move", "latency select", "latency back", "latency open menu", "latency launch"
+    };
+
+    struct Histogram {
+        uint32_t buckets[BUCKET_COUNT + 1];     // the last one for anything longer
+        uint32_t count;
+        uint64_t max_us;
+    };
+
+    Histogram histograms[LATENCY_ACTION_COUNT];
+    uint64_t pending[LATENCY_ACTION_COUNT];     // sample time, 0 if nothing is waiting
+
+    // Upper edge of the bucket the p-th latency is in, no more than the max
+    double percentile_ms(const Histogram& histogram, double p) {
+        uint32_t rank = (uint32_t)(p * (histogram.count - 1)) + 1;
+        uint32_t seen = 0;
+        uint64_t us = histogram.max_us;
+        for (int i = 0; i < BUCKET_COUNT; ++i) {
+            seen += histogram.buckets[i];
+            if (seen >= rank) {
+                us = std::min<uint64_t>((i + 1) * BUCKET_US, us);
+                break;
+            }
+        }
+        return us / 1000.0;
+    }
+}
+
+void input_latency_mark(LatencyAction action, uint64_t sample_time) {
+    // The earliest input still waiting, later ones are shown by the same frame
+    if (pending[action] == 0) pending[action] = sample_time;
+}
+
+void input_latency_presented() {
+    uint64_t now = SDL_GetPerformanceCounter();
+    uint64_t frequency = SDL_GetPerformanceFrequency();
+
+    for (int action = 0; action < LATENCY_ACTION_COUNT; ++action) {
+        if (pending[action] == 0) continue;
+        uint64_t latency_us = (now - pending[action]) * 1000000 / frequency;
+        pending[action] = 0;
+
+        Histogram& histogram = histograms[action];
+        histogram.buckets[std::min<uint64_t>(latency_us / BUCKET_US, BUCKET_COUNT)]++;
+        histogram.count++;
+        histogram.max_us = std::max(histogram.max_us, latency_us);
+
+#ifdef SWITCHU_TRACE
+        if (trace_capturing.load(std::memory_order_relaxed)) {
+            uint64_t end_us = trace_now_us();
+            trace_record(TRACE_NAMES[action], end_us - std::min(latency_us, end_us), end_us);
+        }
+#endif
+    }
+}
+
+void input_latency_report(const char* label) {
+    for (int action = 0; action < LATENCY_ACTION_COUNT; ++action) {
+        Histogram& histogram = histograms[action];
+        if (histogram.count == 0) continue;
+
+        LOG_INFO(LOG_CAT_INPUT, "Input latency (%s, %s, %u inputs): p50 %.2f p90 %.2f p99 %.2f max %.2f ms",
+                 label, ACTION_NAMES[action], (unsigned)histogram.count, percentile_ms(histogram, 0.50),
+                 percentile_ms(histogram, 0.90), percentile_ms(histogram, 0.99), histogram.max_us / 1000.0);
+        histogram = Histogram();
+    }
+}
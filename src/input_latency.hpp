@@ -0,0 +1,34 @@
+#pragma once
+
+// Input to photon latency: from the moment the controllers were read to the
+// present of the first frame showing what the input did, as a histogram per
+// kind of action. input() marks the actions with the sample time of the
+// input that caused them (Input::sampleTime), update() closes them after
+// SDL_RenderPresent().
+//
+// The end is when the present returns, the vsync with it on. The display's
+// own processing comes on top. VPADRead() hands over the pad's latest
+// sample, which can be a few ms old already.
+//
+// Trace builds (see trace.hpp) also put each one in the capture.
+
+#include <cstdint>
+
+// By the input that caused it, not by what it did on screen
+enum LatencyAction {
+    LATENCY_MOVE,       // the d-pad, the stick or the pointer moved the selection
+    LATENCY_SELECT,     // A or a tap picked something
+    LATENCY_BACK,       // B backed out of something
+    LATENCY_OPEN_MENU,  // a menu opened or closed some other way, e.g. with PLUS
+    LATENCY_LAUNCH,     // a title or applet launched, to the last frame before it takes over
+    LATENCY_ACTION_COUNT
+};
+
+// action happened because of an input read at sample_time (SDL performance counter)
+void input_latency_mark(LatencyAction action, uint64_t sample_time);
+
+// Right after SDL_RenderPresent(), everything marked since the last one is on screen now
+void input_latency_presented();
+
+// Logs the count, median, p90, p99 and max of every action, then starts over
+void input_latency_report(const char* label);
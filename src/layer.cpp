@@ -0,0 +1,74 @@
+#include "layer.hpp"
+#include "log.hpp"
+#include "trace.hpp"
+
+namespace {
+    // Drawing with normal blending onto the cleared layer leaves its colour
+    // multiplied by alpha, so it goes to the screen as premultiplied alpha.
+    // Plain blending would darken every anti-aliased edge a second time.
+    SDL_BlendMode premultiplied_blend_mode() {
+        return SDL_ComposeCustomBlendMode(SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+                                          SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+    }
+
+    bool create_layer_texture(SDL_Renderer* renderer, UILayer& layer) {
+        layer.texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, layer.rect.w, layer.rect.h);
+        if (!layer.texture) {
+            LOG_WARN(LOG_CAT_RENDER, "Layer texture unavailable, drawing directly: %s", SDL_GetError());
+            return false;
+        }
+
+        if (SDL_SetTextureBlendMode(layer.texture, premultiplied_blend_mode()) != 0) {
+            SDL_SetTextureBlendMode(layer.texture, SDL_BLENDMODE_BLEND);
+        }
+        return true;
+    }
+}
+
+bool layer_begin(SDL_Renderer* renderer, UILayer& layer, uint64_t key) {
+    if (layer.direct) return true;
+    if (layer.drawn && layer.key == key) return false;
+
+    if (!layer.texture && !create_layer_texture(renderer, layer)) {
+        layer.direct = true;
+        return true;
+    }
+
+    TRACE_SCOPE("layer_redraw");
+    layer.outer = SDL_GetRenderTarget(renderer);
+    SDL_SetRenderTarget(renderer, layer.texture);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+    SDL_RenderClear(renderer);
+
+    layer.key = key;
+    layer.redraws++;
+    return true;
+}
+
+void layer_end(SDL_Renderer* renderer, UILayer& layer) {
+    if (layer.direct) return;
+
+    SDL_SetRenderTarget(renderer, layer.outer);
+    layer.outer = nullptr;
+    layer.drawn = true;
+}
+
+SDL_Point layer_origin(const UILayer& layer) {
+    if (layer.direct) return { 0, 0 };
+    return { layer.rect.x, layer.rect.y };
+}
+
+void layer_composite(SDL_Renderer* renderer, const UILayer& layer) {
+    if (layer.direct || !layer.drawn) return;
+    SDL_RenderCopy(renderer, layer.texture, nullptr, &layer.rect);
+}
+
+void layer_invalidate(UILayer& layer) {
+    layer.drawn = false;
+}
+
+void layer_destroy(UILayer& layer) {
+    if (layer.texture) SDL_DestroyTexture(layer.texture);
+    layer.texture = nullptr;
+    layer.drawn = false;
+}
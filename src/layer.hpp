@@ -0,0 +1,60 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <cstdint>
+
+// A part of the UI that rarely changes, drawn once into its own texture and
+// copied to the screen every frame. It is only drawn again when the key of
+// what it shows (selection, battery level, menu, ...) changes.
+//
+//   if (layer_begin(renderer, layer, key)) {
+//       SDL_Point origin = layer_origin(layer);
+//       ... draw, subtracting origin from screen coordinates ...
+//       layer_end(renderer, layer);
+//   }
+//   layer_composite(renderer, layer);
+struct UILayer {
+    SDL_Rect rect;                  // where it goes on screen
+    SDL_Texture* texture = nullptr;
+    uint64_t key = 0;
+    bool drawn = false;
+    bool direct = false;            // render targets unavailable, draws straight to the screen
+    uint32_t redraws = 0;
+    SDL_Texture* outer = nullptr;   // target layer_begin() found, layer_end() goes back to it
+
+};
+
+// Builds a layer key out of everything a layer's look depends on
+class LayerKey {
+public:
+    LayerKey& add(uint64_t value) {
+        hash ^= value;
+        hash *= 0x100000001b3ULL;
+        return *this;
+    }
+
+    LayerKey& add(const char* text) {
+        for (const char* p = text; *p; ++p) add((unsigned char)*p);
+        return add(uint64_t(0));
+    }
+
+    operator uint64_t() const { return hash; }
+
+private:
+    uint64_t hash = 0xcbf29ce484222325ULL;
+};
+
+// If the layer is out of date for key, points the renderer at it, clears it
+// and returns true. The caller then draws and calls layer_end(). Layers can
+// be drawn while drawing another, layer_end() returns to the outer one.
+bool layer_begin(SDL_Renderer* renderer, UILayer& layer, uint64_t key);
+void layer_end(SDL_Renderer* renderer, UILayer& layer);
+
+// Screen position of the layer's top-left corner, subtract it from what is drawn into it
+SDL_Point layer_origin(const UILayer& layer);
+
+void layer_composite(SDL_Renderer* renderer, const UILayer& layer);
+
+// Forces a redraw on next use, e.g. after a texture the layer shows changed
+void layer_invalidate(UILayer& layer);
+void layer_destroy(UILayer& layer);
@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <cmath>
+
+#include "layout.hpp"
+#include "log.hpp"
+
+Layout layout;
+
+namespace {
+    struct TierInfo {
+        int width;
+        int height;
+        float scale;
+        const char* asset_dir;
+    };
+
+    constexpr TierInfo tiers[LAYOUT_TIER_COUNT] = {
+        { 1280, 720, 1.0f, "" },
+        { 1920, 1080, 1.5f, "1080p/" },
+    };
+
+    // A box, or count of them step_x/step_y apart, at x/y from its anchor.
+    // Design units throughout.
+    struct BoxRule {
+        LayoutBox box;
+        LayoutAnchor anchor;
+        int x, y, w, h;
+        int count = 1;
+        int step_x = 0;
+        int step_y = 0;
+    };
+
+    // In LayoutBox order
+    constexpr BoxRule rules[] = {
+        { BOX_HEADER_LAYER,      ANCHOR_TOP_LEFT,     0,     0,    1280, 120 },
+        { BOX_TOP_TILE,          ANCHOR_TOP_LEFT,     40,    16,   100,  100 },
+        { BOX_HEADER_TITLE,      ANCHOR_TOP_LEFT,     128,   32,   0,    0 },
+        { BOX_BATTERY,           ANCHOR_TOP_RIGHT,    -102,  51,   46,   28 },
+        { BOX_BATTERY_TEXT,      ANCHOR_TOP_RIGHT,    -110,  53,   0,    0 },
+        { BOX_HEADER_LINE,       ANCHOR_TOP_LEFT,     32,    90,   1216, 0 },
+        { BOX_MIDDLE_TILE,       ANCHOR_LEFT,         109,   -170, 256,  256, LAYOUT_MIDDLE_TILES, 270, 0 },
+        { BOX_BOTTOM_LAYER,      ANCHOR_BOTTOM_LEFT,  0,     -250, 1280, 150 },
+        { BOX_BOTTOM_TILE,       ANCHOR_BOTTOM,       -412,  -250, 150,  150, LAYOUT_BOTTOM_TILES, 107, 0 },
+        { BOX_BOTTOM_HIT,        ANCHOR_BOTTOM,       -391,  -229, 107,  107, LAYOUT_BOTTOM_TILES, 107, 0 },
+        { BOX_PAGE_LAYER,        ANCHOR_LEFT,         0,     -208, 1280, 80 * LAYOUT_USER_ROWS + 16 },
+        { BOX_USER_ROW,          ANCHOR_LEFT,         85,    -200, 640,  64, LAYOUT_USER_ROWS, 0, 80 },
+        { BOX_CONTROLLERS_LAYER, ANCHOR_LEFT,         0,     -208, 1280, 80 * LAYOUT_CONTROLLER_ROWS + 16 },
+        { BOX_CONTROLLER_ROW,    ANCHOR_LEFT,         85,    -200, 1067, 64, LAYOUT_CONTROLLER_ROWS, 0, 80 },
+        { BOX_VIEW_AREA,         ANCHOR_TOP_LEFT,     0,     110,  1280, 530 },
+        { BOX_MENU_PANEL,        ANCHOR_TOP_LEFT,     100,   0,    1080, 720 },
+        { BOX_MENU_LINE,         ANCHOR_TOP_LEFT,     117,   90,   1046, 0 },
+        { BOX_FOOTER_LAYER,      ANCHOR_BOTTOM_LEFT,  0,     -72,  1280, 72 },
+        { BOX_FOOTER_LINE,       ANCHOR_BOTTOM_LEFT,  32,    -70,  1216, 0 },
+        { BOX_FOOTER_LINE_MENU,  ANCHOR_BOTTOM_LEFT,  117,   -70,  1046, 0 },
+        { BOX_HINT_A,            ANCHOR_BOTTOM_RIGHT, -145,  -60,  48,   48 },
+        { BOX_HINT_A_WIDE,       ANCHOR_BOTTOM_RIGHT, -160,  -60,  48,   48 },
+        { BOX_HINT_PLUS,         ANCHOR_BOTTOM_RIGHT, -328,  -60,  48,   48 },
+        { BOX_HINT_OK_TEXT,      ANCHOR_BOTTOM_RIGHT, -96,   -49,  0,    0 },
+        { BOX_HINT_START_TEXT,   ANCHOR_BOTTOM_RIGHT, -115,  -49,  0,    0 },
+        { BOX_HINT_OPTIONS_TEXT, ANCHOR_BOTTOM_RIGHT, -283,  -49,  0,    0 },
+    };
+
+    // In LayoutMetric order
+    constexpr int metrics[METRIC_COUNT] = {
+        270,    // METRIC_TILE_STEP
+        220,    // METRIC_CAMERA_LEAD
+        10,     // METRIC_CAMERA_MARGIN
+        4,      // METRIC_OUTLINE_PADDING
+        5,      // METRIC_OUTLINE
+        3,      // METRIC_ROW_OUTLINE
+        8,      // METRIC_GAP
+        16,     // METRIC_TEXT_INSET
+        56,     // METRIC_MII_SIZE
+        24,     // METRIC_FONT_SIZE
+    };
+
+    constexpr bool rules_in_order() {
+        for (int i = 0; i < BOX_COUNT; ++i) {
+            if (rules[i].box != i) return false;
+        }
+        return sizeof(rules) / sizeof(rules[0]) == BOX_COUNT;
+    }
+
+    constexpr int rect_count() {
+        int count = 0;
+        for (const BoxRule& rule : rules) count += rule.count;
+        return count;
+    }
+
+    static_assert(rules_in_order(), "layout rules must list every LayoutBox in order");
+    static_assert(rect_count() <= LAYOUT_MAX_RECTS, "raise LAYOUT_MAX_RECTS");
+
+    int scaled(int design, float scale) {
+        return (int)lroundf(design * scale);
+    }
+
+    // The anchor's point on a width x height screen
+    SDL_Point anchor_point(LayoutAnchor anchor, int width, int height) {
+        switch (anchor) {
+            case ANCHOR_TOP_RIGHT: return { width, 0 };
+            case ANCHOR_LEFT: return { 0, height / 2 };
+            case ANCHOR_BOTTOM_LEFT: return { 0, height };
+            case ANCHOR_BOTTOM: return { width / 2, height };
+            case ANCHOR_BOTTOM_RIGHT: return { width, height };
+            case ANCHOR_TOP_LEFT:
+            default: return { 0, 0 };
+        }
+    }
+}
+
+LayoutTier layout_tier_for(int width, int height) {
+    const TierInfo& full_hd = tiers[LAYOUT_TIER_1080P];
+    return width >= full_hd.width && height >= full_hd.height ? LAYOUT_TIER_1080P : LAYOUT_TIER_720P;
+}
+
+void layout_compile(LayoutTier tier) {
+    const TierInfo& info = tiers[tier];
+    layout.tier = tier;
+    layout.width = info.width;
+    layout.height = info.height;
+    layout.scale = info.scale;
+
+    int next = 0;
+    for (const BoxRule& rule : rules) {
+        SDL_Point anchor = anchor_point(rule.anchor, info.width, info.height);
+        layout.first[rule.box] = next;
+        for (int i = 0; i < rule.count; ++i) {
+            // Each copy is placed from its design position, so rounding doesn't add up along a row
+            layout.rects[next++] = {
+                anchor.x + scaled(rule.x + i * rule.step_x, info.scale),
+                anchor.y + scaled(rule.y + i * rule.step_y, info.scale),
+                scaled(rule.w, info.scale),
+                scaled(rule.h, info.scale)
+            };
+        }
+    }
+
+    for (int i = 0; i < METRIC_COUNT; ++i) {
+        layout.metrics[i] = std::max(1, scaled(metrics[i], info.scale));
+    }
+
+    LOG_INFO(LOG_CAT_RENDER, "Layout for %dx%d, scale %.1f", info.width, info.height, info.scale);
+}
+
+int layout_px(int design) {
+    return scaled(design, layout.scale);
+}
+
+const char* layout_asset_dir() {
+    return tiers[layout.tier].asset_dir;
+}
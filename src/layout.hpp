@@ -0,0 +1,114 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+// Where everything on the TV screen goes, at any of the supported output
+// resolutions. The layout is described once (see layout.cpp) as boxes in
+// 1280x720 design units, each anchored to a corner, edge or the centre of
+// the screen, plus the spacings the drawing code needs. layout_compile()
+// scales that for the resolution's tier into flat tables of pixel rects,
+// which drawing, hit testing and the layers only read: nothing is laid out
+// per frame.
+//
+// The GamePad's own screen is not part of it, it is always 854x480.
+
+enum LayoutTier {
+    LAYOUT_TIER_720P,       // 1280x720, the design resolution
+    LAYOUT_TIER_1080P,      // 1920x1080, everything 1.5 times as big
+    LAYOUT_TIER_COUNT
+};
+
+enum LayoutAnchor {
+    ANCHOR_TOP_LEFT,
+    ANCHOR_TOP_RIGHT,
+    ANCHOR_LEFT,            // middle of the left edge
+    ANCHOR_BOTTOM_LEFT,
+    ANCHOR_BOTTOM,          // middle of the bottom edge
+    ANCHOR_BOTTOM_RIGHT
+};
+
+constexpr int LAYOUT_MIDDLE_TILES = 13;     // home row, the last is All Software
+constexpr int LAYOUT_BOTTOM_TILES = 8;
+constexpr int LAYOUT_USER_ROWS = 4;         // account rows in view on the user page
+constexpr int LAYOUT_CONTROLLER_ROWS = 5;   // one per controller slot
+
+// The boxes the description places. Text positions are boxes without a size.
+enum LayoutBox {
+    BOX_HEADER_LAYER,
+    BOX_TOP_TILE,               // the user page circle
+    BOX_HEADER_TITLE,           // left edge of the page title
+    BOX_BATTERY,
+    BOX_BATTERY_TEXT,           // right edge of the percentage
+    BOX_HEADER_LINE,            // no height, drawn as a line
+    BOX_MIDDLE_TILE,            // x LAYOUT_MIDDLE_TILES, before the camera offset
+    BOX_BOTTOM_LAYER,
+    BOX_BOTTOM_TILE,            // x LAYOUT_BOTTOM_TILES, circles and icons, they overlap
+    BOX_BOTTOM_HIT,             // x LAYOUT_BOTTOM_TILES, the middle of each, for touches
+    BOX_PAGE_LAYER,             // the user page
+    BOX_USER_ROW,               // x LAYOUT_USER_ROWS
+    BOX_CONTROLLERS_LAYER,
+    BOX_CONTROLLER_ROW,         // x LAYOUT_CONTROLLER_ROWS
+    BOX_VIEW_AREA,              // between the header and footer lines, All Software and the album
+    BOX_MENU_PANEL,             // options menu over the home row
+    BOX_MENU_LINE,
+    BOX_FOOTER_LAYER,
+    BOX_FOOTER_LINE,
+    BOX_FOOTER_LINE_MENU,       // shorter while the options menu is open
+    BOX_HINT_A,                 // button hints, the second A is further left next to longer text
+    BOX_HINT_A_WIDE,
+    BOX_HINT_PLUS,
+    BOX_HINT_OK_TEXT,
+    BOX_HINT_START_TEXT,
+    BOX_HINT_OPTIONS_TEXT,
+    BOX_COUNT
+};
+
+// Spacings, in pixels once compiled
+enum LayoutMetric {
+    METRIC_TILE_STEP,           // home row tile to tile, the camera moves by it
+    METRIC_CAMERA_LEAD,         // room kept right of the selection when scrolling right
+    METRIC_CAMERA_MARGIN,
+    METRIC_OUTLINE_PADDING,     // selection outline around a home row tile
+    METRIC_OUTLINE,
+    METRIC_ROW_OUTLINE,
+    METRIC_GAP,                 // small insets, e.g. a title above its tile
+    METRIC_TEXT_INSET,          // text inside a row
+    METRIC_MII_SIZE,
+    METRIC_FONT_SIZE,
+    METRIC_COUNT
+};
+
+constexpr int LAYOUT_MAX_RECTS = 64;
+
+struct Layout {
+    LayoutTier tier = LAYOUT_TIER_720P;
+    int width = 0;
+    int height = 0;
+    float scale = 1.0f;
+    SDL_Rect rects[LAYOUT_MAX_RECTS] = {};
+    int first[BOX_COUNT] = {};      // index of each box's first rect
+    int metrics[METRIC_COUNT] = {};
+};
+
+extern Layout layout;
+
+// The tier to render at for a TV running at width x height
+LayoutTier layout_tier_for(int width, int height);
+
+// Lays everything out for tier, before anything reads the tables
+void layout_compile(LayoutTier tier);
+
+inline const SDL_Rect& layout_rect(LayoutBox box, int index = 0) {
+    return layout.rects[layout.first[box] + index];
+}
+
+inline int layout_metric(LayoutMetric metric) {
+    return layout.metrics[metric];
+}
+
+// A design size in pixels, for views that lay themselves out when opened
+int layout_px(int design);
+
+// Subfolder of assets/ with artwork drawn for the tier, "" for the design
+// resolution. Assets missing from it are the design ones scaled.
+const char* layout_asset_dir();
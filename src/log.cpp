@@ -0,0 +1,149 @@
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+
+#include "log.hpp"
+#include "trace.hpp"
+#include "platform/platform.hpp"
+
+namespace {
+    // Must be a power of two
+    constexpr uint32_t RING_SIZE = 256;
+
+    // A slot belongs to the writer thread when sequence is one past its
+    // position, and is free for the producer at that position when they match
+    struct Slot {
+        std::atomic<uint32_t> sequence;
+        uint8_t level;
+        uint8_t category;
+        uint32_t time_ms;
+        char text[LOG_MESSAGE_SIZE];
+    };
+
+    Slot ring[RING_SIZE];
+    std::atomic<uint32_t> write_pos{0};
+    uint32_t read_pos = 0; // writer thread only
+
+    std::atomic<uint32_t> dropped{0};
+    std::atomic<bool> running{false};
+    std::thread writer;
+
+    int runtime_level[LOG_CAT_COUNT] = {};
+
+    const char level_letters[] = { 'D', 'I', 'W', 'E' };
+    const char* category_names[LOG_CAT_COUNT] = { "main", "scan", "input", "render", "platform", "audio" };
+
+    const auto start_time = std::chrono::steady_clock::now();
+
+    uint32_t now_ms() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time).count();
+    }
+
+    void emit(int level, int category, uint32_t time_ms, const char* text) {
+        char line[LOG_MESSAGE_SIZE + 32];
+        snprintf(line, sizeof(line), "[%6u.%03u] %c %s: %s\n", time_ms / 1000, time_ms % 1000,
+                 level_letters[level], category_names[category], text);
+        platform_log_write(line);
+    }
+
+    // Writes out every message that is ready, returns false if there was none
+    bool drain() {
+        bool wrote = false;
+        for (;;) {
+            Slot& slot = ring[read_pos & (RING_SIZE - 1)];
+            if (slot.sequence.load(std::memory_order_acquire) != read_pos + 1) break;
+
+            TRACE_SCOPE("log_emit");
+            emit(slot.level, slot.category, slot.time_ms, slot.text);
+            slot.sequence.store(read_pos + RING_SIZE, std::memory_order_release);
+            read_pos++;
+            wrote = true;
+        }
+
+        uint32_t lost = dropped.exchange(0, std::memory_order_relaxed);
+        if (lost) {
+            char text[64];
+            snprintf(text, sizeof(text), "%u messages dropped, log buffer full", lost);
+            emit(LOG_LEVEL_WARN, LOG_CAT_MAIN, now_ms(), text);
+        }
+        return wrote;
+    }
+
+    void writer_main() {
+        TRACE_THREAD_NAME("log");
+        while (running.load(std::memory_order_acquire)) {
+            if (!drain()) std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        drain();
+    }
+}
+
+void log_init() {
+    if (running.load()) return;
+
+    for (uint32_t i = 0; i < RING_SIZE; ++i) {
+        ring[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    write_pos.store(0, std::memory_order_relaxed);
+    read_pos = 0;
+
+    running.store(true, std::memory_order_release);
+    writer = std::thread(writer_main);
+}
+
+void log_shutdown() {
+    if (!running.load()) return;
+    running.store(false, std::memory_order_release);
+    writer.join();
+}
+
+void log_set_level(LogCategory category, int level) {
+    runtime_level[category] = level;
+}
+
+void log_set_level(int level) {
+    for (int& category_level : runtime_level) category_level = level;
+}
+
+void log_write(int level, LogCategory category, const char* format, ...) {
+    if (level < runtime_level[category]) return;
+
+    va_list args;
+    va_start(args, format);
+
+    if (!running.load(std::memory_order_acquire)) {
+        char text[LOG_MESSAGE_SIZE];
+        vsnprintf(text, sizeof(text), format, args);
+        va_end(args);
+        emit(level, category, now_ms(), text);
+        return;
+    }
+
+    // Claim a slot, or drop the message if the writer has fallen a whole ring behind
+    uint32_t pos = write_pos.load(std::memory_order_relaxed);
+    Slot* slot;
+    for (;;) {
+        slot = &ring[pos & (RING_SIZE - 1)];
+        int32_t diff = (int32_t)(slot->sequence.load(std::memory_order_acquire) - pos);
+        if (diff == 0) {
+            if (write_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            va_end(args);
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            pos = write_pos.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->level = level;
+    slot->category = category;
+    slot->time_ms = now_ms();
+    vsnprintf(slot->text, sizeof(slot->text), format, args);
+    va_end(args);
+
+    slot->sequence.store(pos + 1, std::memory_order_release);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+// Leveled, categorised logging. Messages are formatted straight into a
+// lock-free ring buffer and written out by a background thread through
+// platform_log_write(), so logging never waits on the log sink.
+//
+// Calls below LOG_COMPILE_LEVEL are removed by the preprocessor, arguments
+// and all. Release builds keep INFO and up, build with DEBUG=1 (which
+// defines SWITCHU_DEBUG) to get DEBUG messages too.
+
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO  1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_ERROR 3
+#define LOG_LEVEL_NONE  4
+
+#ifndef LOG_COMPILE_LEVEL
+#ifdef SWITCHU_DEBUG
+#define LOG_COMPILE_LEVEL LOG_LEVEL_DEBUG
+#else
+#define LOG_COMPILE_LEVEL LOG_LEVEL_INFO
+#endif
+#endif
+
+enum LogCategory {
+    LOG_CAT_MAIN,
+    LOG_CAT_SCAN,
+    LOG_CAT_INPUT,
+    LOG_CAT_RENDER,
+    LOG_CAT_PLATFORM,
+    LOG_CAT_AUDIO,
+    LOG_CAT_COUNT
+};
+
+// Longer messages are cut off
+constexpr int LOG_MESSAGE_SIZE = 200;
+
+// Starts the writer thread. Until then, and after log_shutdown(), messages
+// are written straight away on the calling thread.
+void log_init();
+
+// Writes out whatever is still queued and stops the writer thread
+void log_shutdown();
+
+// Messages below level are dropped at runtime, for one category or all of them
+void log_set_level(LogCategory category, int level);
+void log_set_level(int level);
+
+void log_write(int level, LogCategory category, const char* format, ...) __attribute__((format(printf, 3, 4)));
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(category, ...) log_write(LOG_LEVEL_DEBUG, category, __VA_ARGS__)
+#else
+#define LOG_DEBUG(category, ...) ((void)0)
+#endif
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(category, ...) log_write(LOG_LEVEL_INFO, category, __VA_ARGS__)
+#else
+#define LOG_INFO(category, ...) ((void)0)
+#endif
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_WARN
+#define LOG_WARN(category, ...) log_write(LOG_LEVEL_WARN, category, __VA_ARGS__)
+#else
+#define LOG_WARN(category, ...) ((void)0)
+#endif
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(category, ...) log_write(LOG_LEVEL_ERROR, category, __VA_ARGS__)
+#else
+#define LOG_ERROR(category, ...) ((void)0)
+#endif
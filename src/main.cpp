@@ -1,58 +1,83 @@
 #include <SDL.h>
 #include <SDL_image.h>
 
-#include <rpxloader/rpxloader.h>
-#include <coreinit/debug.h>
-#include <coreinit/title.h>
-#include <padscore/kpad.h>
-#include <sndcore2/core.h>
-#include <sysapp/launch.h>
-#include <sysapp/title.h>
-#include <nn/acp/title.h>
-#include <whb/proc.h>
 #include <stdio.h>
 #include <string.h>
 #include <dirent.h>
 #include <cstdint>
-#include <nn/act.h>
+#include <cstdlib>
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
 
 #include "input/CombinedInput.h"
-#include "input/VPADInput.h"
-#include "input/WPADInput.h"
+#include "input/InputRecorder.h"
+#include "input/ReplayInput.h"
+#include "input/StressInput.h"
 
+#include "log.hpp"
+#include "trace.hpp"
 #include "render.hpp"
 #include "util.hpp"
 #include "title_extractor.hpp"
 #include "font.hpp"
-
-enum RowSelection {
-    ROW_TOP = 0,
-    ROW_MIDDLE = 1,
-    ROW_BOTTOM = 2
-};
-
-enum Menu {
-    MENU_MAIN = 0,
-    MENU_APPS = 1,
-    MENU_USER = 2,
-    MENU_MORE = 3,
-    MENU_SETTINGS = 4,
-    MENU_SCREENSHOT = 5
+#include "menu.hpp"
+#include "frame_arena.hpp"
+#include "frame_stats.hpp"
+#include "hit_index.hpp"
+#include "input_latency.hpp"
+#include "layer.hpp"
+#include "layout.hpp"
+#include "snapshot.hpp"
+#include "album.hpp"
+#include "apps_view.hpp"
+#include "accounts.hpp"
+#include "asset_pack.hpp"
+#include "audio.hpp"
+#include "controllers.hpp"
+#include "gamepad_screen.hpp"
+#include "sd_watch.hpp"
+#include "platform/platform.hpp"
+
+enum InputMode {
+    INPUT_MODE_LIVE = 0,
+    INPUT_MODE_RECORD = 1,
+    INPUT_MODE_REPLAY = 2,
+    INPUT_MODE_STRESS = 3
 };
 
 namespace Config {
-    constexpr int WINDOW_WIDTH = 1280;
-    constexpr int WINDOW_HEIGHT = 720;
-
     constexpr int SCROLL_INITIAL_DELAY = 500;
     constexpr int SCROLL_REPEAT_INTERVAL = 75;
 
-    constexpr int TILE_COUNT_MIDDLE = 13;
-    constexpr int TILE_COUNT_BOTTOM = 8;
+    constexpr int TILE_COUNT_MIDDLE = LAYOUT_MIDDLE_TILES;
+    constexpr int TILE_COUNT_BOTTOM = LAYOUT_BOTTOM_TILES;
+
+    constexpr int TITLE_MAX_LINES = 2;
+    constexpr size_t MAX_FALLBACK_FONTS = 4;
+
+    constexpr int settings_row_count = LAYOUT_USER_ROWS;
+
+    // GamePad launcher when the GamePad has a screen of its own, pages of big tiles
+    constexpr int GAMEPAD_COLUMNS = 4;
+    constexpr int GAMEPAD_ROWS = 2;
+    constexpr int GAMEPAD_PAGE_TILES = GAMEPAD_COLUMNS * GAMEPAD_ROWS;
+    constexpr int GAMEPAD_TILE_SIZE = 176;
+    constexpr int GAMEPAD_TILE_SPACING = 24;
+    constexpr int GAMEPAD_GRID_TOP = 72;
+    constexpr int GAMEPAD_FONT_SIZE = 24;
+
+    constexpr int TOUCH_DRAG_THRESHOLD = 12;
+    constexpr float KINETIC_FRICTION = 0.92f;
+    constexpr float KINETIC_MIN_VELOCITY = 0.5f;
 
-    constexpr int circle_diameter = 75;
-    constexpr int spawn_box_size = 256;
-    constexpr int settings_row_count = 4;
+    constexpr const char* INPUT_MODE_PATH = SD_CARD_PATH "switchU/input_mode.txt";
+    constexpr const char* INPUT_RECORDING_PATH = SD_CARD_PATH "switchU/input.rec";
+    constexpr const char* FRAME_TIMES_PATH = SD_CARD_PATH "switchU/frametimes.txt";
+
+    // Icons left off a restored library, loaded per frame once it's interactive
+    constexpr size_t DEFERRED_ICONS_PER_FRAME = 4;
 }
 
 struct UITextures {
@@ -95,6 +120,41 @@ struct UITextures {
     }
 };
 
+// Where each UI texture comes from, under switchU/assets/
+struct UITextureFile {
+    const char* name;
+    SDL_Texture* UITextures::* texture;
+    bool deferred;      // loaded by load_deferred_assets() rather than load_view_assets()
+    bool gamepad;       // the GamePad's screen draws it too, it gets a copy of its own
+};
+
+static const UITextureFile ui_texture_files[] = {
+    { "ui_button.png", &UITextures::circle, false },
+    { "ui_button_selected.png", &UITextures::circle_selection, false },
+    { "ui_big_circle.png", &UITextures::circle_big, false, true },
+    { "ui_big_circle_selected.png", &UITextures::circle_big_selection, false },
+    { "battery/battery_full.png", &UITextures::battery_full, false },
+    { "battery/battery_three_fourths.png", &UITextures::battery_three_fourths, false },
+    { "battery/battery_half.png", &UITextures::battery_half, false },
+    { "battery/battery_needs_charge.png", &UITextures::battery_needs_charge, false },
+    { "battery/battery_base.png", &UITextures::battery_base, false },
+    { "all_titles.png", &UITextures::all_titles, false, true },
+
+    { "miiverse.png", &UITextures::miiverse, false },
+    { "eshop.png", &UITextures::eshop, false },
+    { "screenshots.png", &UITextures::screenshots, false },
+    { "browser.png", &UITextures::browser, false },
+    { "controller.png", &UITextures::controller, false },
+    { "downloads.png", &UITextures::downloads, false },
+    { "settings.png", &UITextures::settings, false },
+    { "power.png", &UITextures::power, false },
+
+    { "buttons/button_a.png", &UITextures::a_button, false },
+    { "buttons/button_plus.png", &UITextures::plus_button, false },
+
+    { "reference.png", &UITextures::reference, true },
+};
+
 static Uint32 left_hold_time = 0;
 static Uint32 right_hold_time = 0;
 static Uint32 up_hold_time = 0;
@@ -105,9 +165,9 @@ static bool up_scrolling = false;
 static bool down_scrolling = false;
 bool menuOpen = false;
 bool load_homebrew_titles = false;
-int battery_level = 0;
+int battery_level = 0;              // the GamePad's, kept up to date by on_header_controller()
+int controllers_page_generation = 0;    // bumped by on_page_controller()
 
-int seperation_space = 264;
 int target_camera_offset_x = 0;
 int camera_offset_x = 0;
 int cur_menu = MENU_MAIN;
@@ -116,9 +176,29 @@ int cur_selected_tile = 0;
 int cur_selected_row = ROW_MIDDLE;
 int cur_selected_subtile = 0;
 int cur_selected_subrow = 0;
-
-int tiles_x = Config::WINDOW_WIDTH / 6;
-int tiles_y = Config::WINDOW_HEIGHT / 2;
+int accounts_generation = 0;            // bumped whenever accounts_poll() changed something
+int launch_count = 0;                   // bumped by every launch, see save_snapshot()
+std::string user_page_title = "User Page";
+
+// Touch and pointer navigation
+HitIndex scrolling_hits; // carousel, in camera space
+HitIndex fixed_hits;     // everything that doesn't scroll
+int hit_layout_menu = -1;
+size_t hit_layout_app_count = 0;
+HitIndex gamepad_hits;   // the GamePad's own screen
+int gamepad_hit_menu = -1;
+int gamepad_hit_page = -1;
+
+static bool touch_active = false;
+static bool touch_dragging = false;
+static int touch_start_x = 0;
+static int touch_start_camera_x = 0;
+static int touch_last_x = 0;
+static int touch_last_y = 0;
+static int pointer_last_x = 0;
+static int pointer_last_y = 0;
+static float scroll_velocity = 0.0f;
+static bool camera_free = false; // set while the camera is driven by touch instead of the selection
 
 SDL_Window *main_window;
 SDL_Renderer *main_renderer;
@@ -126,138 +206,789 @@ SDL_Event event;
 UITextures textures;
 TTFText* textRenderer = NULL;
 
-SDL_Texture* load_texture(const char* path, SDL_Renderer* renderer) {
-    SDL_RWops* rw = SDL_RWFromFile(path, "rb");
-    if (!rw) {
-        printf("SDL_RWFromFile failed: %s\n", SDL_GetError());
-        return NULL;
+// The GamePad screen's own copies of what it draws, made by its renderer
+UITextures gamepad_textures;
+TTFText* gamepadText = NULL;
+struct GamePadIcon {
+    SDL_Texture* icon = nullptr;
+    SDL_Texture* source = nullptr;  // the TV's icon this was loaded for
+    int entry = -1;                 // library index, -1 once dropped
+    uint32_t generation = 0;
+};
+GamePadIcon gamepad_icons[Config::GAMEPAD_PAGE_TILES];
+uint32_t gamepad_icon_loads = 0;    // bumped by every load into gamepad_icons, part of the screen's key
+bool gamepad_drawn = false;         // cleared to draw it again even if its key held
+uint64_t gamepad_drawn_key = 0;
+
+// Static regions of the screen, see layer.hpp. Placed by place() once the layout is compiled.
+struct UILayers {
+    UILayer header;
+    UILayer page;
+    UILayer controllers;
+    UILayer bottom_row;
+    UILayer footer;
+    UILayer screen;     // the whole TV frame, the layers above are drawn into it
+
+    void place() {
+        header.rect = layout_rect(BOX_HEADER_LAYER);
+        page.rect = layout_rect(BOX_PAGE_LAYER);
+        controllers.rect = layout_rect(BOX_CONTROLLERS_LAYER);
+        bottom_row.rect = layout_rect(BOX_BOTTOM_LAYER);
+        footer.rect = layout_rect(BOX_FOOTER_LAYER);
+        screen.rect = { 0, 0, layout.width, layout.height };
+    }
+
+    void invalidateAll() {
+        layer_invalidate(header); layer_invalidate(page);
+        layer_invalidate(controllers);
+        layer_invalidate(bottom_row); layer_invalidate(footer);
+        layer_invalidate(screen);
+    }
+
+    void destroyAll() {
+        layer_destroy(header); layer_destroy(page);
+        layer_destroy(controllers);
+        layer_destroy(bottom_row); layer_destroy(footer);
+        layer_destroy(screen);
     }
+};
+UILayers layers;
 
+// Takes ownership of rw. Scaled by scale once here, if it isn't 1.
+SDL_Texture* load_texture_rw(SDL_RWops* rw, SDL_Renderer* renderer, float scale = 1.0f) {
+    TRACE_FUNCTION();
     SDL_Surface* surface = IMG_Load_RW(rw, 1);
     if (!surface) {
-        printf("IMG_Load_RW failed: %s\n", IMG_GetError());
+        LOG_WARN(LOG_CAT_MAIN, "IMG_Load_RW failed: %s", IMG_GetError());
         return NULL;
     }
 
+    if (scale != 1.0f) {
+        SDL_Surface* scaled = render_scale_surface(surface, scale);
+        if (scaled) {
+            SDL_FreeSurface(surface);
+            surface = scaled;
+        }
+    }
+
     SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
     SDL_FreeSurface(surface);
 
     if (!texture) {
-        printf("SDL_CreateTextureFromSurface failed: %s\n", SDL_GetError());
+        LOG_WARN(LOG_CAT_MAIN, "SDL_CreateTextureFromSurface failed: %s", SDL_GetError());
     }
 
     return texture;
 }
 
-void launch_system_title(uint64_t titleID) {
-    MCPTitleListType titleInfo;
-    int32_t handle = MCP_Open();
-    auto err       = MCP_GetTitleInfo(handle, titleID, &titleInfo);
-    MCP_Close(handle);
+SDL_Texture* load_texture(const char* path, SDL_Renderer* renderer) {
+    SDL_RWops* rw = SDL_RWFromFile(path, "rb");
+    if (!rw) {
+        LOG_WARN(LOG_CAT_MAIN, "SDL_RWFromFile failed: %s", SDL_GetError());
+        return NULL;
+    }
+    return load_texture_rw(rw, renderer);
+}
 
-    if (SYSCheckTitleExists(titleID) && err == ACP_RESULT_SUCCESS) {
-        ACPAssignTitlePatch(&titleInfo);
-        SYSLaunchTitle(titleID);
-    } else {
-        printf("Title not found or ACP error.\n");
+// Layout rects shared by drawing and hit-testing, see layout.hpp. Middle row
+// rects are in camera space, subtract camera_offset_x to get screen coordinates.
+const SDL_Rect& middle_tile_rect(int i) {
+    return layout_rect(BOX_MIDDLE_TILE, i);
+}
+
+const SDL_Rect& bottom_tile_rect(int i) {
+    return layout_rect(BOX_BOTTOM_TILE, i);
+}
+
+const SDL_Rect& user_row_rect(int i) {
+    return layout_rect(BOX_USER_ROW, i);
+}
+
+// One row per account on the user page, at least one while they are being read
+int user_page_rows() {
+    return std::max<int>(1, accounts_list().size());
+}
+
+// The account in the page's top row, it scrolls to keep the selection in view
+int user_page_first_row() {
+    return std::max(0, cur_selected_subrow - (Config::settings_row_count - 1));
+}
+
+const SDL_Rect& top_tile_rect() {
+    return layout_rect(BOX_TOP_TILE);
+}
+
+// GamePad screen rects, in its own coordinates
+enum GamePadTarget {
+    GAMEPAD_TILE,           // index is the middle row tile
+    GAMEPAD_PAGE,           // index is -1 or 1
+    GAMEPAD_BACK
+};
+
+SDL_Rect gamepad_tile_rect(int slot) {
+    const int step = Config::GAMEPAD_TILE_SIZE + Config::GAMEPAD_TILE_SPACING;
+    const int grid_width = Config::GAMEPAD_COLUMNS * step - Config::GAMEPAD_TILE_SPACING;
+    const int left = (GAMEPAD_WIDTH - grid_width) / 2;
+    return { left + (slot % Config::GAMEPAD_COLUMNS) * step, Config::GAMEPAD_GRID_TOP + (slot / Config::GAMEPAD_COLUMNS) * step,
+             Config::GAMEPAD_TILE_SIZE, Config::GAMEPAD_TILE_SIZE };
+}
+
+// The margins either side of the grid
+SDL_Rect gamepad_page_rect(int direction) {
+    const int width = gamepad_tile_rect(0).x;
+    return { direction < 0 ? 0 : GAMEPAD_WIDTH - width, Config::GAMEPAD_GRID_TOP, width, GAMEPAD_HEIGHT - Config::GAMEPAD_GRID_TOP };
+}
+
+const SDL_Rect gamepad_back_rect = { GAMEPAD_WIDTH / 2 - 120, GAMEPAD_HEIGHT / 2 - 40, 240, 80 };
+
+// The page holding the selected middle row tile
+int gamepad_page() {
+    int tile = (cur_selected_row == ROW_MIDDLE) ? cur_selected_tile : 0;
+    return tile / Config::GAMEPAD_PAGE_TILES;
+}
+
+int gamepad_page_count() {
+    return (Config::TILE_COUNT_MIDDLE + Config::GAMEPAD_PAGE_TILES - 1) / Config::GAMEPAD_PAGE_TILES;
+}
+
+// Places every home row tile and its icon, redone only after a scan
+void layout_library() {
+    for (size_t i = 0; i < library.size() && i < LIBRARY_HOME_ICONS; ++i) {
+        library.hot.tile[i] = middle_tile_rect(i);
+        library.hot.icon_rect[i] = render_icon_fit(library.hot.icon[i], library.hot.tile[i]);
     }
+    library.layout_valid = true;
 }
 
+void rebuild_hit_index() {
+    scrolling_hits.clear();
+    fixed_hits.clear();
+
+    if (cur_menu == MENU_MAIN) {
+        for (int i = 0; i < Config::TILE_COUNT_MIDDLE; ++i) {
+            scrolling_hits.add(middle_tile_rect(i), ROW_MIDDLE, i);
+        }
+
+        // The bottom row images overlap, only the circle in the middle is a target
+        for (int i = 0; i < Config::TILE_COUNT_BOTTOM; ++i) {
+            fixed_hits.add(layout_rect(BOX_BOTTOM_HIT, i), ROW_BOTTOM, i);
+        }
+    } else if (cur_menu == MENU_USER) {
+        for (int i = 0; i < Config::settings_row_count; ++i) {
+            fixed_hits.add(user_row_rect(i), ROW_MIDDLE, i);
+        }
+    }
+
+    if ((cur_menu == MENU_MAIN) || (cur_menu == MENU_USER)) {
+        fixed_hits.add(top_tile_rect(), ROW_TOP, 0);
+    }
+
+    scrolling_hits.build();
+    fixed_hits.build();
+
+    hit_layout_menu = cur_menu;
+    hit_layout_app_count = library.size();
+}
+
+bool hit_test_screen(int x, int y, HitTarget& out) {
+    if (hit_layout_menu != cur_menu || hit_layout_app_count != library.size()) {
+        rebuild_hit_index();
+    }
+
+    if (fixed_hits.hit_test(x, y, out)) return true;
+    return scrolling_hits.hit_test(x + camera_offset_x, y, out);
+}
+
+bool gamepad_hit_test(int x, int y, HitTarget& out) {
+    if (gamepad_hit_menu != cur_menu || gamepad_hit_page != gamepad_page()) {
+        gamepad_hits.clear();
+        if (cur_menu == MENU_MAIN) {
+            int first = gamepad_page() * Config::GAMEPAD_PAGE_TILES;
+            for (int slot = 0; slot < Config::GAMEPAD_PAGE_TILES && first + slot < Config::TILE_COUNT_MIDDLE; ++slot) {
+                gamepad_hits.add(gamepad_tile_rect(slot), GAMEPAD_TILE, first + slot);
+            }
+            if (gamepad_page() > 0) gamepad_hits.add(gamepad_page_rect(-1), GAMEPAD_PAGE, -1);
+            if (gamepad_page() < gamepad_page_count() - 1) gamepad_hits.add(gamepad_page_rect(1), GAMEPAD_PAGE, 1);
+        } else {
+            gamepad_hits.add(gamepad_back_rect, GAMEPAD_BACK, 0);
+        }
+        gamepad_hits.build();
+        gamepad_hit_menu = cur_menu;
+        gamepad_hit_page = gamepad_page();
+    }
+    return gamepad_hits.hit_test(x, y, out);
+}
+
+int max_camera_offset() {
+    return layout_metric(METRIC_TILE_STEP) * 24 - layout.width;
+}
+
+// SDL, the window and the renderer, enough to put the startup shell on screen
 int initialize() {
+    TRACE_FUNCTION();
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
-        printf("SDL_Init failed with error: %s\n", SDL_GetError());
+        LOG_ERROR(LOG_CAT_MAIN, "SDL_Init failed with error: %s", SDL_GetError());
         return EXIT_FAILURE;
     }
 
-    if (RPXLoader_InitLibrary() != RPX_LOADER_RESULT_SUCCESS) {
-        printf("RPX_LOADER failed with an error");
-    }
+    // Everything is placed for the TV's resolution before anything is drawn
+    int tv_width, tv_height;
+    platform_tv_size(tv_width, tv_height);
+    layout_compile(layout_tier_for(tv_width, tv_height));
+    layers.place();
 
-    // Handle window creation
-    main_window = SDL_CreateWindow(
-        "SwitchU",
-        SDL_WINDOWPOS_UNDEFINED,
-        SDL_WINDOWPOS_UNDEFINED,
-        Config::WINDOW_WIDTH,
-        Config::WINDOW_HEIGHT,
-        0);
+    // Handle window creation, the TV's only goes to the TV if the GamePad got one of its own
+    bool gamepad_separate = gamepad_screen_open();
+    main_window = platform_create_window(gamepad_separate ? SCREEN_TV : SCREEN_MIRRORED, "SwitchU",
+                                         layout.width, layout.height);
 
     if (!main_window) {
-        printf("SDL_CreateWindow failed with error: %s\n", SDL_GetError());
+        LOG_ERROR(LOG_CAT_MAIN, "SDL_CreateWindow failed with error: %s", SDL_GetError());
         SDL_Quit();
         return EXIT_FAILURE;
     }
 
     if (!(IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG)) {
-        printf("Failed to initialize SDL_image for PNG files: %s\n", IMG_GetError());
+        LOG_ERROR(LOG_CAT_MAIN, "Failed to initialize SDL_image for PNG files: %s", IMG_GetError());
     }
 
     if (TTF_Init() == -1) {
-        printf("TTF_Init failed: %s\n", TTF_GetError());
+        LOG_ERROR(LOG_CAT_MAIN, "TTF_Init failed: %s", TTF_GetError());
     }
 
     // Handle renderer creation
     main_renderer = SDL_CreateRenderer(main_window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
 
+    SDL_SetHint( SDL_HINT_RENDER_SCALE_QUALITY, "1" );
+
+    return EXIT_SUCCESS;
+}
+
+// The tier's own artwork if the packs have it. Otherwise the design
+// resolution's, scaled up to the tier once here with a proper filter rather
+// than stretched by the GPU on every draw. See asset_pack.hpp.
+static SDL_Texture* load_ui_texture(const UITextureFile& file) {
+    SDL_RWops* rw = nullptr;
+    if (*layout_asset_dir()) rw = asset_pack_rw((std::string(layout_asset_dir()) + file.name).c_str());
+    if (rw) return load_texture_rw(rw, main_renderer);
+    rw = asset_rw(file.name);
+    return rw ? load_texture_rw(rw, main_renderer, layout.scale) : nullptr;
+}
+
+static void load_ui_textures(bool deferred) {
+    for (const UITextureFile& file : ui_texture_files) {
+        if (file.deferred == deferred) textures.*file.texture = load_ui_texture(file);
+    }
+}
+
+// The GamePad's screen is drawn at the design resolution, its copies never come from a tier
+static void load_gamepad_textures() {
+    for (const UITextureFile& file : ui_texture_files) {
+        if (!file.gamepad) continue;
+        SDL_RWops* rw = asset_rw(file.name);
+        gamepad_textures.*file.texture = rw ? load_texture_rw(rw, gamepad_screen_renderer()) : nullptr;
+    }
+}
+
+// One asset changed on the SD card, name is relative to assets/. The loose
+// file replaces what the packs have until the next start. False if it isn't
+// one of the UI textures.
+static bool reload_ui_texture(const char* name) {
+    // The tier's copy replaces the same texture
+    const char* file_name = name;
+    const size_t dir_length = strlen(layout_asset_dir());
+    if (dir_length > 0 && strncmp(name, layout_asset_dir(), dir_length) == 0) file_name += dir_length;
+
+    for (const UITextureFile& file : ui_texture_files) {
+        if (strcmp(file.name, file_name) != 0) continue;
+
+        SDL_Texture*& texture = textures.*file.texture;
+        if (texture) SDL_DestroyTexture(texture);
+        std::string path = std::string(SD_CARD_PATH "switchU/assets/") + name;
+        SDL_RWops* rw = SDL_RWFromFile(path.c_str(), "rb");
+        // A design resolution file is scaled to the tier like the packed one
+        texture = rw ? load_texture_rw(rw, main_renderer, file_name == name ? layout.scale : 1.0f) : nullptr;
+
+        SDL_Texture*& gamepad_texture = gamepad_textures.*file.texture;
+        if (gamepad_screen_active() && file.gamepad && file_name == name) {
+            if (gamepad_texture) SDL_DestroyTexture(gamepad_texture);
+            gamepad_texture = load_texture(path.c_str(), gamepad_screen_renderer());
+        }
+        LOG_INFO(LOG_CAT_MAIN, "Reloaded UI texture %s", name);
+        return true;
+    }
+    return false;
+}
+
+// Font and textures the main menu needs to draw its first real frame
+void load_view_assets() {
+    TRACE_FUNCTION();
     textRenderer = new TTFText(main_renderer);
-    if (!textRenderer->loadFont(SD_CARD_PATH "switchU/fonts/font.ttf", 24, true)) {
-        printf("Failed to load font!");
+    if (!textRenderer->loadFont(SD_CARD_PATH "switchU/fonts/font.ttf", layout_metric(METRIC_FONT_SIZE), true)) {
+        LOG_ERROR(LOG_CAT_MAIN, "Failed to load font!");
     }
 
-    SDL_SetHint( SDL_HINT_RENDER_SCALE_QUALITY, "1" );
+    PlatformFont fallback_fonts[Config::MAX_FALLBACK_FONTS];
+    size_t fallback_count = platform_fallback_fonts(fallback_fonts, Config::MAX_FALLBACK_FONTS);
+    for (size_t i = 0; i < fallback_count; ++i) {
+        textRenderer->addFallbackFont(fallback_fonts[i].data, fallback_fonts[i].size);
+    }
 
-    textures.circle = load_texture(SD_CARD_PATH "switchU/assets/ui_button.png", main_renderer);
-    textures.circle_selection = load_texture(SD_CARD_PATH "switchU/assets/ui_button_selected.png", main_renderer);
-    textures.circle_big = load_texture(SD_CARD_PATH "switchU/assets/ui_big_circle.png", main_renderer);
-    textures.circle_big_selection = load_texture(SD_CARD_PATH "switchU/assets/ui_big_circle_selected.png", main_renderer);
-    textures.battery_full = load_texture(SD_CARD_PATH "switchU/assets/battery/battery_full.png", main_renderer);
-    textures.battery_three_fourths = load_texture(SD_CARD_PATH "switchU/assets/battery/battery_three_fourths.png", main_renderer);
-    textures.battery_half = load_texture(SD_CARD_PATH "switchU/assets/battery/battery_half.png", main_renderer);
-    textures.battery_needs_charge = load_texture(SD_CARD_PATH "switchU/assets/battery/battery_needs_charge.png", main_renderer);
-    textures.battery_base = load_texture(SD_CARD_PATH "switchU/assets/battery/battery_base.png", main_renderer);
-    textures.all_titles = load_texture(SD_CARD_PATH "switchU/assets/all_titles.png", main_renderer);
-
-    textures.miiverse = load_texture(SD_CARD_PATH "switchU/assets/miiverse.png", main_renderer);
-    textures.eshop = load_texture(SD_CARD_PATH "switchU/assets/eshop.png", main_renderer);
-    textures.screenshots = load_texture(SD_CARD_PATH "switchU/assets/screenshots.png", main_renderer);
-    textures.browser = load_texture(SD_CARD_PATH "switchU/assets/browser.png", main_renderer);
-    textures.controller = load_texture(SD_CARD_PATH "switchU/assets/controller.png", main_renderer);
-    textures.downloads = load_texture(SD_CARD_PATH "switchU/assets/downloads.png", main_renderer);
-    textures.settings = load_texture(SD_CARD_PATH "switchU/assets/settings.png", main_renderer);
-    textures.power = load_texture(SD_CARD_PATH "switchU/assets/power.png", main_renderer);
-    textures.reference = load_texture(SD_CARD_PATH "switchU/assets/reference.png", main_renderer);
-
-    textures.a_button = load_texture(SD_CARD_PATH "switchU/assets/buttons/button_a.png", main_renderer);
-    textures.plus_button = load_texture(SD_CARD_PATH "switchU/assets/buttons/button_plus.png", main_renderer);
-
-    get_user_information();
+    load_ui_textures(false);
 
-    return EXIT_SUCCESS;
+    if (gamepad_screen_active()) {
+        gamepadText = new TTFText(gamepad_screen_renderer());
+        gamepadText->loadFont(SD_CARD_PATH "switchU/fonts/font.ttf", Config::GAMEPAD_FONT_SIZE, true);
+        for (size_t i = 0; i < fallback_count; ++i) {
+            gamepadText->addFallbackFont(fallback_fonts[i].data, fallback_fonts[i].size);
+        }
+        load_gamepad_textures();
+    }
 }
 
-void shutdown() {
-    textures.destroyAll(main_renderer);
+// Everything no view needs right away: the accounts shown on the user page
+// (read in the background) and the layout reference image
+void load_deferred_assets() {
+    TRACE_FUNCTION();
+    load_ui_textures(true);
 
-    for (auto& app : apps) {
-        if (app.icon) SDL_DestroyTexture(app.icon);
-    }
+    accounts_refresh();
+    audio_init();
+}
 
-    apps.clear();
+void shutdown() {
+    layers.destroyAll();
+    textures.destroyAll(main_renderer);
+    asset_pack_close();
 
-    nn::act::Finalize();
+    library_clear();
 
-    RPXLoader_DeInitLibrary();
+    delete textRenderer;
+    textRenderer = NULL;
 
-    AXQuit();
+    for (GamePadIcon& slot : gamepad_icons) {
+        if (slot.icon) SDL_DestroyTexture(slot.icon);
+        slot = GamePadIcon();
+    }
+    if (gamepad_textures.circle_big) SDL_DestroyTexture(gamepad_textures.circle_big);
+    if (gamepad_textures.all_titles) SDL_DestroyTexture(gamepad_textures.all_titles);
+    gamepad_textures = UITextures();
+    delete gamepadText;
+    gamepadText = NULL;
 
     TTF_Quit();
+    gamepad_screen_close();
     SDL_DestroyWindow(main_window);
     SDL_DestroyRenderer(main_renderer);
     SDL_Quit();
 }
 
-void input(Input &input) {
-    Uint32 now = SDL_GetTicks();
+void draw_frame();
+
+// Saves where we are so coming back from what is about to launch restores it
+// Everything that launches calls this first.
+void save_snapshot() {
+    launch_count++;
+
+    NavigationState nav = {};
+    nav.menu = cur_menu;
+    nav.row = cur_selected_row;
+    nav.tile = cur_selected_tile;
+    nav.subrow = cur_selected_subrow;
+    nav.camera_offset_x = target_camera_offset_x;
+    nav.load_homebrew_titles = load_homebrew_titles;
+    nav.apps_sort = apps_view_sort();
+    nav.apps_entry = apps_view_selected();
+    snapshot_write(SNAPSHOT_PATH, nav);
+
+    // Not presented, only kept as the first thing shown on the way back.
+    // draw_frame() doesn't move the camera, only update() eases it.
+    draw_frame();
+    snapshot_write_frame(SNAPSHOT_FRAME_PATH, main_renderer);
+}
+
+// Home row entries [first, last) whose tiles are on screen at the current camera position
+void visible_library_range(size_t& first, size_t& last) {
+    first = library.size();
+    last = 0;
+    for (size_t i = 0; i < library.size() && i < LIBRARY_HOME_ICONS; ++i) {
+        const SDL_Rect& tile = middle_tile_rect(i);
+        if (tile.x + tile.w <= camera_offset_x || tile.x >= camera_offset_x + layout.width) continue;
+        if (i < first) first = i;
+        last = i + 1;
+    }
+}
+
+// Library from the snapshot left by the last launch, or a full scan without one.
+// A restored library only gets the icons on screen, the rest load after startup.
+void load_library() {
+    TRACE_FUNCTION();
+    NavigationState nav;
+    if (!snapshot_restore(SNAPSHOT_PATH, nav)) {
+        scan_apps(main_renderer);
+        snapshot_fingerprint(load_homebrew_titles);
+        return;
+    }
+
+    cur_menu = nav.menu;
+    cur_selected_row = nav.row;
+    cur_selected_tile = nav.tile;
+    cur_selected_subrow = nav.subrow;
+    target_camera_offset_x = nav.camera_offset_x;
+    camera_offset_x = nav.camera_offset_x;
+    load_homebrew_titles = nav.load_homebrew_titles;
+
+    size_t first, last;
+    visible_library_range(first, last);
+    library_load_icons(first, last, main_renderer);
+
+    if (cur_menu == MENU_APPS) {
+        apps_view_open(layout_rect(BOX_VIEW_AREA), (AppsSort)nav.apps_sort, nav.apps_entry);
+    } else if (cur_menu != MENU_MAIN && cur_menu != MENU_USER && cur_menu != MENU_SETTINGS) {
+        cur_menu = MENU_MAIN;
+    }
+
+    snapshot_revalidate();
+}
+
+// Applies what sd_watch found changed, each change to only what it affects:
+// the entries a custom icon belongs to, the titles ignore.txt names, the one
+// texture swapped
+void apply_sd_changes(const SdChanges& changes) {
+    TRACE_FUNCTION();
+    std::vector<size_t> reloaded;
+    for (const std::string& folder : changes.custom_icons) {
+        library_reload_custom_icon(folder.c_str(), main_renderer, reloaded);
+    }
+    for (size_t entry : reloaded) apps_view_reload_icon(entry);
+    // The new texture may well be at the old one's address, the GamePad's copy is dropped instead of compared
+    for (GamePadIcon& slot : gamepad_icons) {
+        if (slot.entry < 0 || std::find(reloaded.begin(), reloaded.end(), (size_t)slot.entry) == reloaded.end()) continue;
+        if (slot.icon) SDL_DestroyTexture(slot.icon);
+        slot = GamePadIcon();
+        gamepad_drawn = false;
+    }
+
+    if (!changes.ignored.empty()) library_hide(changes.ignored);
+    if (!changes.unignored.empty()) library_unhide(changes.unignored, main_renderer);
+    if (!changes.custom_icons.empty() || !changes.ignored.empty() || !changes.unignored.empty()) {
+        snapshot_fingerprint(load_homebrew_titles);
+    }
+
+    bool ui_changed = false;
+    for (const std::string& asset : changes.assets) {
+        ui_changed = reload_ui_texture(asset.c_str()) || ui_changed;
+    }
+    // The static regions were drawn with the old textures
+    if (ui_changed) {
+        layers.invalidateAll();
+        gamepad_drawn = false;
+    }
+}
+
+// A new account list or Mii face from the accounts worker
+void on_accounts_changed() {
+    accounts_generation++;
+    const PlatformAccount* current = accounts_current();
+    if (current) user_page_title = (current->name.empty() ? current->account_id : current->name) + "'s Page";
+    if (cur_selected_subrow >= user_page_rows()) cur_selected_subrow = user_page_rows() - 1;
+}
+
+// The header shows the GamePad's battery, redrawn only when it changed
+void on_header_controller(const ControllerEvent& event) {
+    if (event.slot == 0) battery_level = controller_status(0).battery;
+}
+
+// The controllers page lists every slot, any change redraws it
+void on_page_controller(const ControllerEvent&) {
+    controllers_page_generation++;
+}
+
+// Switches to a menu, opening the view it needs
+void open_menu(int menu) {
+    cur_menu = menu;
+    if (menu == MENU_APPS) {
+        apps_view_open(layout_rect(BOX_VIEW_AREA), apps_view_sort(), 0);
+    } else if (menu == MENU_SCREENSHOT) {
+        album_open(layout_rect(BOX_VIEW_AREA));
+    }
+}
+
+// Back to the home menu, closing whatever view was open
+void close_menu() {
+    if (cur_menu == MENU_APPS) {
+        apps_view_close();
+    } else if (cur_menu == MENU_SCREENSHOT) {
+        album_close();
+    }
+    cur_menu = MENU_MAIN;
+}
+
+// Launches a library entry, saving where we are first
+void launch_library_entry(size_t index) {
+    uint64_t titleid = library.cold.titleid[index];
+    if (titleid == 0) {
+        const char* launch_path = get_app_path(index);
+        LOG_INFO(LOG_CAT_MAIN, "Launching app with path: %s", launch_path);
+        audio_play(SOUND_SELECT);
+
+        save_snapshot();
+        platform_launch_homebrew(launch_path);
+    } else {
+        LOG_INFO(LOG_CAT_MAIN, "Launching system app with title ID: %llu", (unsigned long long)titleid);
+        audio_play(SOUND_SELECT);
+        save_snapshot();
+        platform_launch_title(titleid);
+    }
+}
+
+// Acts on the current selection, same as pressing A
+void activate_selection() {
+    if ((cur_selected_row == ROW_TOP)) {
+        if (cur_menu == MENU_MAIN) {
+            cur_menu = MENU_USER;
+            cur_selected_row = ROW_MIDDLE;
+            accounts_refresh();
+        }
+    } else if (cur_selected_row == ROW_MIDDLE) {
+        if (cur_menu == MENU_MAIN) {
+            if (cur_selected_tile == Config::TILE_COUNT_MIDDLE - 1) {
+                open_menu(MENU_APPS);
+            } else if (static_cast<size_t>(cur_selected_tile) < library.size()) {
+                launch_library_entry(cur_selected_tile);
+            }
+        } else if (cur_menu == MENU_USER) {
+            if (cur_selected_subrow == 0) {
+                // Insert a profile subsubmenu thing
+            }
+        }
+    } else {
+        if (cur_selected_tile == 0) {
+            LOG_INFO(LOG_CAT_MAIN, "Launching MiiVerse !");
+            save_snapshot();
+            platform_switch_to(APPLET_MIIVERSE);
+        } else if (cur_selected_tile == 1) {
+            const char* launch_path = "wiiu/apps/appstore/appstore.wuhb";
+
+            save_snapshot();
+            platform_launch_homebrew(launch_path);
+        } else if (cur_selected_tile == 2) {
+            open_menu(MENU_SCREENSHOT);
+        } else if (cur_selected_tile == 3) {
+            LOG_INFO(LOG_CAT_MAIN, "Launching the Browser !");
+            save_snapshot();
+            platform_switch_to(APPLET_BROWSER);
+        } else if (cur_selected_tile == 4) {
+            open_menu(MENU_CONTROLLERS);
+        } else if (cur_selected_tile == 5) {
+            LOG_INFO(LOG_CAT_MAIN, "Launching Download Manager !");
+            save_snapshot();
+            platform_switch_to(APPLET_DOWNLOAD_MANAGER);
+        } else if (cur_selected_tile == 6) {
+            cur_menu = MENU_SETTINGS;
+        }
+    }
+}
+
+// Taps on the GamePad's own screen, with the same select-then-activate as on the TV's
+void gamepad_touch_input(Input &input) {
+    // Touches come in the TV's centred coordinates, the touch panel spans the GamePad screen
+    const int x = (input.data.x + layout.width / 2) * GAMEPAD_WIDTH / layout.width;
+    const int y = (layout.height / 2 - input.data.y) * GAMEPAD_HEIGHT / layout.height;
+
+    if (input.data.touched) {
+        touch_active = true;
+        touch_last_x = x;
+        touch_last_y = y;
+        return;
+    }
+    touch_active = false;
+
+    HitTarget hit;
+    if (!gamepad_hit_test(touch_last_x, touch_last_y, hit)) return;
+
+    if (hit.row == GAMEPAD_TILE) {
+        bool already_selected = cur_selected_row == ROW_MIDDLE && cur_selected_tile == hit.index;
+        cur_selected_row = ROW_MIDDLE;
+        cur_selected_tile = hit.index;
+        if (already_selected) activate_selection();
+    } else if (hit.row == GAMEPAD_PAGE) {
+        int page = gamepad_page() + hit.index;
+        cur_selected_row = ROW_MIDDLE;
+        cur_selected_tile = page * Config::GAMEPAD_PAGE_TILES;
+    } else if (hit.row == GAMEPAD_BACK) {
+        menuOpen = false;
+        close_menu();
+    }
+}
+
+// Touch taps select a target, tapping the selected one activates it. Dragging
+// on the carousel moves the camera directly and keeps coasting on release.
+// A Wii Remote pointer selects whatever it hovers.
+void pointer_input(Input &input) {
+    if (gamepad_screen_active() && (input.data.touched || touch_active)) {
+        gamepad_touch_input(input);
+        return;
+    }
+
+    const int screen_x = input.data.x + (layout.width / 2);
+    const int screen_y = (layout.height / 2) - input.data.y;
+
+    if (input.data.touched) {
+        if (!touch_active) {
+            touch_active = true;
+            touch_dragging = false;
+            touch_start_x = screen_x;
+            touch_start_camera_x = camera_offset_x;
+            touch_last_x = screen_x;
+            scroll_velocity = 0.0f;
+        }
+
+        int dx = screen_x - touch_start_x;
+        if (!touch_dragging && cur_menu == MENU_MAIN && abs(dx) > Config::TOUCH_DRAG_THRESHOLD) {
+            touch_dragging = true;
+            camera_free = true;
+        }
+
+        if (touch_dragging) {
+            target_camera_offset_x = touch_start_camera_x - dx;
+            if (target_camera_offset_x < 0) target_camera_offset_x = 0;
+            if (target_camera_offset_x > max_camera_offset()) target_camera_offset_x = max_camera_offset();
+            camera_offset_x = target_camera_offset_x;
+            // Smoothed so a single jittery sample doesn't decide the fling speed
+            scroll_velocity = scroll_velocity * 0.5f + (float)(touch_last_x - screen_x) * 0.5f;
+        }
+        touch_last_x = screen_x;
+        touch_last_y = screen_y;
+        return;
+    }
+
+    if (touch_active) {
+        touch_active = false;
+
+        HitTarget hit;
+        if (!touch_dragging && hit_test_screen(touch_last_x, touch_last_y, hit)) {
+            if (cur_menu == MENU_USER && hit.row != ROW_TOP) hit.index += user_page_first_row();
+            bool already_selected = (hit.row == cur_selected_row) &&
+                                    (cur_menu == MENU_USER ? hit.index == cur_selected_subrow : hit.index == cur_selected_tile);
+
+            if (cur_menu == MENU_USER && hit.row != ROW_TOP) {
+                if (hit.index < user_page_rows()) cur_selected_subrow = hit.index;
+            } else {
+                cur_selected_row = hit.row;
+                cur_selected_tile = hit.index;
+            }
+
+            if (already_selected) activate_selection();
+        }
+        touch_dragging = false;
+        return;
+    }
+
+    if (input.data.validPointer && (screen_x != pointer_last_x || screen_y != pointer_last_y)) {
+        pointer_last_x = screen_x;
+        pointer_last_y = screen_y;
+
+        HitTarget hit;
+        if (hit_test_screen(screen_x, screen_y, hit)) {
+            if (cur_menu == MENU_USER && hit.row != ROW_TOP) {
+                int row = user_page_first_row() + hit.index;
+                if (row < user_page_rows()) cur_selected_subrow = row;
+            } else if (cur_menu == MENU_MAIN) {
+                cur_selected_row = hit.row;
+                cur_selected_tile = hit.index;
+            }
+        }
+    }
+}
+
+// Reads sd:/switchU/input_mode.txt, which holds "record", "replay" or "stress"
+InputMode load_input_mode() {
+    FILE* file = fopen(Config::INPUT_MODE_PATH, "r");
+    if (!file) return INPUT_MODE_LIVE;
+
+    char mode[16] = {};
+    if (fscanf(file, "%15s", mode) != 1) mode[0] = '\0';
+    fclose(file);
+
+    if (strcmp(mode, "record") == 0) return INPUT_MODE_RECORD;
+    if (strcmp(mode, "replay") == 0) return INPUT_MODE_REPLAY;
+    if (strcmp(mode, "stress") == 0) return INPUT_MODE_STRESS;
+
+    LOG_WARN(LOG_CAT_MAIN, "Unknown input mode \"%s\", using live input", mode);
+    return INPUT_MODE_LIVE;
+}
+
+// Where the user is, compared before and after input() to pick its sound
+// and to tell that the input did something
+struct SelectionState {
+    int menu;
+    int row;
+    int tile;
+    int subrow;
+    bool menu_open;
+    size_t apps_entry;
+    int capture;                // in the album
+    bool viewing_capture;
+    int launches;
+
+    static SelectionState current() {
+        bool album = cur_menu == MENU_SCREENSHOT;
+        return { cur_menu, cur_selected_row, cur_selected_tile, cur_selected_subrow, menuOpen,
+                 cur_menu == MENU_APPS ? apps_view_selected() : 0,
+                 album ? album_selected() : 0, album && album_viewing(), launch_count };
+    }
+};
+
+// One sound for whatever an input changed: opening something, closing it or
+// moving the selection
+void play_input_sound(const SelectionState& before) {
+    SelectionState after = SelectionState::current();
+    if (after.menu != before.menu) {
+        audio_play(after.menu == MENU_MAIN ? SOUND_BACK : SOUND_SELECT);
+    } else if (after.menu_open != before.menu_open) {
+        audio_play(after.menu_open ? SOUND_SELECT : SOUND_BACK);
+    } else if (after.row != before.row || after.tile != before.tile || after.subrow != before.subrow ||
+               after.apps_entry != before.apps_entry) {
+        audio_play(SOUND_NAVIGATE);
+    }
+}
+
+// Times whatever an input visibly changed, see input_latency.hpp. What kind
+// of action it was comes from the input: A opening All Software is a select,
+// the album moving with the d-pad is a move.
+void mark_input_latency(const SelectionState& before, const Input& input, bool touch_released) {
+    SelectionState after = SelectionState::current();
+    if (after.launches != before.launches) {
+        input_latency_mark(LATENCY_LAUNCH, input.sampleTime);
+        return;
+    }
+
+    bool menu_changed = after.menu != before.menu || after.menu_open != before.menu_open;
+    bool moved = after.row != before.row || after.tile != before.tile || after.subrow != before.subrow ||
+                 after.apps_entry != before.apps_entry || after.capture != before.capture ||
+                 after.viewing_capture != before.viewing_capture;
+    if (!menu_changed && !moved) return;
+
+    const uint32_t pressed = input.data.buttons_d;
+    LatencyAction action;
+    if (pressed & Input::BUTTON_B) {
+        action = LATENCY_BACK;
+    } else if ((pressed & Input::BUTTON_A) || touch_released) {
+        action = LATENCY_SELECT;
+    } else if (menu_changed) {
+        action = LATENCY_OPEN_MENU;
+    } else {
+        // The d-pad or the stick, pressed or repeating while held, or the pointer
+        action = LATENCY_MOVE;
+    }
+    input_latency_mark(action, input.sampleTime);
+}
+
+void input(Input &input, Uint32 now) {
+    TRACE_FUNCTION();
+    SelectionState before = SelectionState::current();
+    bool touch_released = touch_active && !input.data.touched;
 
     bool holding_left = (input.data.buttons_h & Input::STICK_L_LEFT || input.data.buttons_h & Input::BUTTON_LEFT);
     bool holding_right = (input.data.buttons_h & Input::STICK_L_RIGHT || input.data.buttons_h & Input::BUTTON_RIGHT);
@@ -269,6 +1000,13 @@ void input(Input &input) {
     bool pressed_up = (input.data.buttons_d & Input::STICK_L_UP || input.data.buttons_d & Input::BUTTON_UP);
     bool pressed_down = (input.data.buttons_d & Input::STICK_L_DOWN || input.data.buttons_d & Input::BUTTON_DOWN);
 
+    if (pressed_left || pressed_right || pressed_up || pressed_down) {
+        camera_free = false;
+        scroll_velocity = 0.0f;
+    }
+
+    pointer_input(input);
+
     bool is_main_menu = (cur_menu == MENU_MAIN);
     bool is_middle_row = (cur_selected_row == ROW_MIDDLE);
     bool is_bottom_row = (cur_selected_row == ROW_BOTTOM);
@@ -340,13 +1078,13 @@ void input(Input &input) {
             if (cur_selected_row < 2) cur_selected_row++;
             if (cur_selected_tile >= 7) cur_selected_tile = 7;
         } else if (cur_menu == MENU_USER) {
-            if (cur_selected_subrow < Config::settings_row_count - 1) cur_selected_subrow++;
+            if (cur_selected_subrow < user_page_rows() - 1) cur_selected_subrow++;
         }
         down_hold_time = now;
         down_scrolling = true;
     } else if (holding_down && down_scrolling && cur_menu != MENU_MAIN) {
         if (now - down_hold_time >= Config::SCROLL_INITIAL_DELAY) {
-            if (cur_menu == MENU_USER && cur_selected_subrow < Config::settings_row_count - 1) {
+            if (cur_menu == MENU_USER && cur_selected_subrow < user_page_rows() - 1) {
                 cur_selected_subrow++;
                 down_hold_time = now - (Config::SCROLL_INITIAL_DELAY - Config::SCROLL_REPEAT_INTERVAL);
             }
@@ -355,251 +1093,314 @@ void input(Input &input) {
         down_scrolling = false;
     }
 
-    if (input.data.buttons_d & Input::BUTTON_A) {
-        if ((cur_selected_row == ROW_TOP)) {
-            if (cur_menu == MENU_MAIN) {
-                cur_menu = MENU_USER;
-                cur_selected_row = ROW_MIDDLE;
-            }
-        } else if (cur_selected_row == ROW_MIDDLE) {
-            if (cur_menu == MENU_MAIN) {
-                if (static_cast<size_t>(cur_selected_tile) < apps.size()) {
-                    if (apps[cur_selected_tile].titleid == 0) {
-                        const char* launch_path = get_selected_app_path();
-                        printf("Launching app with path: %s\n", launch_path);
-
-                        RPXLoaderStatus st = RPXLoader_LaunchHomebrew(launch_path);
-                        printf("Launch status: %s\n", RPXLoader_GetStatusStr(st));
-                    } else {
-                        printf("Launching system app with title ID: %llu\n", apps[cur_selected_tile].titleid);
-                        launch_system_title(apps[cur_selected_tile].titleid);
-                    }
-                } else {
-                    cur_menu = MENU_APPS;
-                }
-            } else if (cur_menu == MENU_USER) {
-                if (cur_selected_subrow == 0) {
-                    // Insert a profile subsubmenu thing
-                }
+    if (cur_menu == MENU_SCREENSHOT) {
+        // The album has a grid and a viewer of its own, B backs out of both
+        if (!album_input(input, now)) close_menu();
+    } else if (cur_menu == MENU_APPS) {
+        AppsViewAction action = apps_view_input(input, now);
+        if (action == APPS_VIEW_BACK) {
+            close_menu();
+        } else if (action == APPS_VIEW_LAUNCH) {
+            launch_library_entry(apps_view_selected());
+        }
+    } else {
+        if (input.data.buttons_d & Input::BUTTON_A) {
+            activate_selection();
+        }
+
+        if (input.data.buttons_d & Input::BUTTON_B) {
+            if (menuOpen) {
+                menuOpen = false;
             }
-        } else {
-            if (cur_selected_tile == 0) {
-                printf("Launching MiiVerse !\n");
-                _SYSSwitchTo(SysAppPFID::SYSAPP_PFID_MIIVERSE);
-            } else if (cur_selected_tile == 1) {
-                const char* launch_path = "wiiu/apps/appstore/appstore.wuhb";
-
-                RPXLoaderStatus st = RPXLoader_LaunchHomebrew(launch_path);
-                printf("Launch status: %s\n", RPXLoader_GetStatusStr(st));
-            } else if (cur_selected_tile == 3) {
-                printf("Launching the Browser !\n");
-                SYSSwitchToBrowser(nullptr);
-            } else if (cur_selected_tile == 5) {
-                printf("Launching Download Manager !\n");
-                _SYSSwitchTo(SysAppPFID::SYSAPP_PFID_DOWNLOAD_MANAGEMENT);
-            } else if (cur_selected_tile == 6) {
-                cur_menu = MENU_SETTINGS;
+            if (cur_menu != MENU_MAIN) {
+                cur_menu = MENU_MAIN;
             }
         }
-    }
 
-    if (input.data.buttons_d & Input::BUTTON_B) {
-        if (menuOpen) {
-            menuOpen = false;
-        }
-        if (cur_menu != MENU_MAIN) {
-            cur_menu = MENU_MAIN;
+        if (input.data.buttons_d & Input::BUTTON_PLUS) {
+            if ((cur_menu == MENU_MAIN) && (cur_selected_row == ROW_MIDDLE)) {
+                menuOpen = true;
+            }
         }
     }
 
-    if (input.data.buttons_d & Input::BUTTON_PLUS) {
-        if ((cur_menu == MENU_MAIN) && (cur_selected_row == ROW_MIDDLE)) {
-            menuOpen = true;
-        }
+    // ZL+ZR saves the running trace capture or starts a new one, see trace.hpp
+    const uint32_t trace_chord = Input::BUTTON_ZL | Input::BUTTON_ZR;
+    if ((input.data.buttons_h & trace_chord) == trace_chord && (input.data.buttons_d & trace_chord)) {
+        TRACE_TOGGLE();
     }
 
     // Developer note: make this an option toggle in the settings menu later
-    if (input.data.buttons_d & VPAD_BUTTON_MINUS) {
+    if (input.data.buttons_d & Input::BUTTON_MINUS) {
         load_homebrew_titles = !load_homebrew_titles;
-        printf("Toggled homebrew title loading: %s\n", load_homebrew_titles ? "ON" : "OFF");
+        LOG_INFO(LOG_CAT_MAIN, "Toggled homebrew title loading: %s", load_homebrew_titles ? "ON" : "OFF");
         scan_apps(main_renderer);
+        snapshot_fingerprint(load_homebrew_titles);
     }
 
     if (cur_selected_row == ROW_TOP) {
         cur_selected_tile = 0;
     }
 
+    // Let the camera coast after a touch fling
+    if (camera_free && !touch_active && scroll_velocity != 0.0f) {
+        target_camera_offset_x += (int)scroll_velocity;
+        scroll_velocity *= Config::KINETIC_FRICTION;
+        if (fabsf(scroll_velocity) < Config::KINETIC_MIN_VELOCITY) scroll_velocity = 0.0f;
+
+        if (target_camera_offset_x < 0 || target_camera_offset_x > max_camera_offset()) scroll_velocity = 0.0f;
+        if (target_camera_offset_x < 0) target_camera_offset_x = 0;
+        if (target_camera_offset_x > max_camera_offset()) target_camera_offset_x = max_camera_offset();
+    }
+
     // Only update camera if middle row is selected
-    if ((cur_selected_row == ROW_MIDDLE) && (cur_menu == MENU_MAIN)) {
-        const int outline_padding = 10;
-        int selected_tile_x = cur_selected_tile * seperation_space;
+    if ((cur_selected_row == ROW_MIDDLE) && (cur_menu == MENU_MAIN) && !camera_free) {
+        const int margin = layout_metric(METRIC_CAMERA_MARGIN);
+        int selected_tile_x = cur_selected_tile * layout_metric(METRIC_TILE_STEP);
 
-        int tile_left = selected_tile_x - outline_padding;
-        int tile_right = selected_tile_x + Config::spawn_box_size + outline_padding;
+        int tile_left = selected_tile_x - margin;
+        int tile_right = selected_tile_x + middle_tile_rect(0).w + margin;
 
         if (tile_left < target_camera_offset_x) {
             target_camera_offset_x = tile_left;
-        } else if (tile_right > target_camera_offset_x + Config::WINDOW_WIDTH) {
-            target_camera_offset_x = tile_right - Config::WINDOW_WIDTH + 220;
+        } else if (tile_right > target_camera_offset_x + layout.width) {
+            target_camera_offset_x = tile_right - layout.width + layout_metric(METRIC_CAMERA_LEAD);
         }
 
         // Clamp camera within bounds
         if (target_camera_offset_x < 0) target_camera_offset_x = 0;
-        int max_camera_offset = seperation_space * 24 - Config::WINDOW_WIDTH;
-        if (target_camera_offset_x > max_camera_offset) target_camera_offset_x = max_camera_offset;
+        if (target_camera_offset_x > max_camera_offset()) target_camera_offset_x = max_camera_offset();
     }
-}
-
-void update() {
-    render_set_color(main_renderer, COLOR_BACKGROUND);
-    SDL_RenderClear(main_renderer);
-
-    // Smooth camera movement
-    const float camera_speed = 0.2f;
-    camera_offset_x += (int)((target_camera_offset_x - camera_offset_x) * camera_speed);
-
-    // === Middle Row (Camera-dependent) ===
-    const int base_x = tiles_x - (Config::spawn_box_size / 2);
-    const int base_y = tiles_y - 170;
-    const int sub_base_y = tiles_y - 200;
 
-    if (cur_menu == MENU_MAIN) {
-        seperation_space = 270;
-
-        for (int i = 0; i < Config::TILE_COUNT_MIDDLE; ++i) {
-            int x = ((base_x + seperation_space * i) + 24) - camera_offset_x;
-            int title_x = (((base_x + seperation_space * i) + 24) + (Config::spawn_box_size/2)) - camera_offset_x;
+    play_input_sound(before);
+    mark_input_latency(before, input, touch_released);
+}
 
-            SDL_Rect icon_rect = { x, base_y, Config::spawn_box_size, Config::spawn_box_size };
+// === Layers ===
+// Each draws one static region in screen coordinates minus origin, see layer.hpp
+
+// The accounts, with their Mii and Nintendo Network ID, the signed in one marked
+void draw_user_page(SDL_Point origin) {
+    const std::vector<PlatformAccount>& accounts = accounts_list();
+    const int first = user_page_first_row();
+
+    for (int i = 0; i < Config::settings_row_count; ++i) {
+        const int row = first + i;
+        if (row >= (int)accounts.size() && row > 0) break;
+
+        SDL_Rect row_rect = user_row_rect(i);
+        row_rect.x -= origin.x;
+        row_rect.y -= origin.y;
+        const bool selected = row == cur_selected_subrow;
+        SDL_Color color = selected ? SDL_Color{15, 206, 185, 255} : SDL_Color{255, 255, 255, 255};
+        const int gap = layout_metric(METRIC_GAP);
+        const int inset = layout_metric(METRIC_TEXT_INSET);
+        const int mii_size = layout_metric(METRIC_MII_SIZE);
+        const int text_x = row_rect.x + mii_size + gap + inset;
+        const int text_y = row_rect.y + inset;
+
+        if (row < (int)accounts.size()) {
+            const PlatformAccount& account = accounts[row];
+            SDL_Rect mii_rect = { row_rect.x + gap, row_rect.y + (row_rect.h - mii_size) / 2, mii_size, mii_size };
+            SDL_Texture* mii = accounts_mii(account.persistent_id);
+            SDL_RenderCopy(main_renderer, mii ? mii : textures.circle, NULL, &mii_rect);
+
+            const std::string& name = account.name.empty() ? account.account_id : account.name;
+            textRenderer->renderTextAt(name.c_str(), color, text_x, text_y, TextAlign::Left);
+            const char* detail = account.current ? "Signed in" : account.account_id.c_str();
+            textRenderer->renderTextAt(detail, {160, 160, 160, 255}, row_rect.x + row_rect.w - inset, text_y, TextAlign::Right);
+        } else {
+            textRenderer->renderTextAt("Loading...", color, text_x, text_y, TextAlign::Left);
+        }
 
-            if (i < (Config::TILE_COUNT_MIDDLE - 1)) {
-                if (i < (int)apps.size() && apps[i].icon) {
-                    render_icon_with_background(main_renderer, apps[i].icon, x, base_y, Config::spawn_box_size);
-                } else {
-                    render_set_color(main_renderer, COLOR_UI_BOX);
-                    SDL_RenderDrawRect(main_renderer, &icon_rect);
-                }
-                if (i < (int)apps.size() && (i == cur_selected_tile && cur_selected_row == ROW_MIDDLE)) {
-                    textRenderer->renderTextAt(apps[i].title, {0, 255, 245, 255}, title_x, base_y - 35, TextAlign::Center);
-                }
-            } else {
-                SDL_RenderCopy(main_renderer, textures.circle_big, NULL, &icon_rect);
-                SDL_RenderCopy(main_renderer, textures.all_titles, NULL, &icon_rect);
-                if (i == cur_selected_tile && cur_selected_row == ROW_MIDDLE) {
-                    textRenderer->renderTextAt("All Software", {0, 255, 245, 255}, title_x, base_y, TextAlign::Center);
-                }
+        if (selected) {
+            const int outline_thickness = layout_metric(METRIC_ROW_OUTLINE);
+            render_set_color(main_renderer, COLOR_BLUE);
+            for (int t = 0; t < outline_thickness; ++t) {
+                SDL_Rect thick_rect = { row_rect.x - 2 - t, row_rect.y - 2 - t, row_rect.w + 4 + 2 * t, row_rect.h + 4 + 2 * t };
+                SDL_RenderDrawRect(main_renderer, &thick_rect);
             }
+        }
+    }
+}
 
-            if (i == cur_selected_tile && cur_selected_row == ROW_MIDDLE) {
-                const int outline_padding = 4;
-                const int outline_thickness = 5;
+// A slot's battery in percent, like the header shows it
+const char* controller_battery_text(int slot, const PlatformControllerStatus& status) {
+    static const char* const gamepad_levels[] = { "Charging", "0%", "20%", "30%", "50%", "80%", "100%" };
+    static const char* const remote_levels[] = { "0%", "25%", "50%", "75%", "100%" };
+    if (slot == 0) return status.battery >= 0 && status.battery <= 6 ? gamepad_levels[status.battery] : "???%";
+    return status.battery >= 0 && status.battery <= 4 ? remote_levels[status.battery] : "???%";
+}
 
-                SDL_Rect outline_rect = {
-                    x - outline_padding,
-                    base_y - outline_padding,
-                    Config::spawn_box_size + 2 * outline_padding,
-                    Config::spawn_box_size + 2 * outline_padding
-                };
+// One line per controller slot, with what is plugged into it and its battery
+void draw_controllers_page(SDL_Point origin) {
+    static const char* const extension_names[] = { "", "Nunchuk", "Classic Controller", "Pro Controller", "Other accessory" };
+    const int inset = layout_metric(METRIC_TEXT_INSET);
+    char name[32];
+
+    for (int slot = 0; slot < PLATFORM_CONTROLLER_SLOTS; ++slot) {
+        const PlatformControllerStatus& status = controller_status(slot);
+        const SDL_Rect& row = layout_rect(BOX_CONTROLLER_ROW, slot);
+        const int left = row.x + layout_metric(METRIC_GAP) - origin.x;
+        const int right = row.x + row.w - origin.x;
+        const int y = row.y + inset - origin.y;
+        SDL_Color color = status.connected ? SDL_Color{255, 255, 255, 255} : SDL_Color{128, 128, 128, 255};
+
+        if (slot == 0) {
+            snprintf(name, sizeof(name), "Wii U GamePad");
+        } else {
+            snprintf(name, sizeof(name), "Wii Remote %d", slot);
+        }
+        textRenderer->renderTextAt(name, color, left, y, TextAlign::Left);
 
-                render_set_color(main_renderer, COLOR_CYAN);
+        if (!status.connected) {
+            textRenderer->renderTextAt("Not connected", color, right, y, TextAlign::Right);
+            continue;
+        }
+        if (status.extension != EXTENSION_NONE) {
+            textRenderer->renderTextAt(extension_names[status.extension], color, layout.width / 2 - origin.x, y, TextAlign::Left);
+        }
+        textRenderer->renderTextAt(controller_battery_text(slot, status), color, right, y, TextAlign::Right);
+    }
+}
 
-                if (i < (Config::TILE_COUNT_MIDDLE - 1)) {
-                    for (int t = 0; t < outline_thickness; ++t) {
-                        SDL_Rect thick_rect = {
-                            outline_rect.x - t,
-                            outline_rect.y - t,
-                            outline_rect.w + 2 * t,
-                            outline_rect.h + 2 * t
-                        };
-                        SDL_RenderDrawRect(main_renderer, &thick_rect);
-                    }
-                } else {
-                    SDL_RenderCopy(main_renderer, textures.circle_big_selection, NULL, &icon_rect);
-                }
-            }
+// === Bottom Row (Fixed Position, 8 centered circles) ===
+void draw_bottom_row(SDL_Point origin) {
+    SDL_Texture* const icons[Config::TILE_COUNT_BOTTOM] = {
+        textures.miiverse, textures.eshop, textures.screenshots, textures.browser,
+        textures.controller, textures.downloads, textures.settings, textures.power
+    };
+
+    // Circles first, the icons are wider than their circle and overlap the neighbours'
+    for (int i = 0; i < Config::TILE_COUNT_BOTTOM; ++i) {
+        SDL_Rect dst_rect = bottom_tile_rect(i);
+        dst_rect.x -= origin.x;
+        dst_rect.y -= origin.y;
+        SDL_RenderCopy(main_renderer, textures.circle, NULL, &dst_rect);
+
+        if (i == cur_selected_tile && cur_selected_row == ROW_BOTTOM) {
+            SDL_RenderCopy(main_renderer, textures.circle_selection, NULL, &dst_rect);
         }
-    } else if (cur_menu == MENU_USER) {
-        seperation_space = 80;
+    }
 
-        for (int i = 0; i < Config::settings_row_count; ++i) {
-            int y = sub_base_y + seperation_space * i;
+    for (int i = 0; i < Config::TILE_COUNT_BOTTOM; ++i) {
+        SDL_Rect dst_rect = bottom_tile_rect(i);
+        dst_rect.x -= origin.x;
+        dst_rect.y -= origin.y;
+        SDL_RenderCopy(main_renderer, icons[i], NULL, &dst_rect);
+    }
+    //SDL_Rect reference_rect = { 0, 0, layout.width, layout.height };
+    //SDL_RenderCopy(main_renderer, textures.reference, NULL, &reference_rect);
+    // Uncomment this to view a reference for positions and stuff of that sort ^
+}
 
-            render_set_color(main_renderer, COLOR_WHITE);
+// Whether the slot holds the GamePad renderer's copy of entry i's current icon
+bool gamepad_icon_current(const GamePadIcon& cached, int i) {
+    return cached.entry == i && cached.source == library.hot.icon[i] && cached.generation == library.generation;
+}
 
-            if (i == cur_selected_subrow) {
-                const int outline_padding = 2;
-                const int outline_thickness = 3;
+// Loads the GamePad page's icons that aren't current, a few per frame like
+// the deferred ones. A page flip shows its tiles empty until theirs are in.
+void gamepad_load_icons() {
+    if (!gamepad_screen_active() || cur_menu != MENU_MAIN) return;
+
+    int first = gamepad_page() * Config::GAMEPAD_PAGE_TILES;
+    size_t loaded = 0;
+    for (int slot = 0; slot < Config::GAMEPAD_PAGE_TILES && loaded < Config::DEFERRED_ICONS_PER_FRAME; ++slot) {
+        int i = first + slot;
+        if (i >= (int)library.size()) break;
+        GamePadIcon& cached = gamepad_icons[slot];
+        if (gamepad_icon_current(cached, i)) continue;
+
+        if (cached.icon) SDL_DestroyTexture(cached.icon);
+        SDL_Texture* source = library.hot.icon[i];
+        cached.icon = source ? load_icon(library.cold.icon_path[i], gamepad_screen_renderer()) : nullptr;
+        cached.source = source;
+        cached.entry = i;
+        cached.generation = library.generation;
+        if (source) loaded++;
+        gamepad_icon_loads++;
+    }
+}
 
-                SDL_Rect setting_outline_rect = {
-                    base_x - outline_padding,
-                    y - outline_padding,
-                    128 * outline_padding,
-                    32 * outline_padding
-                };
+// === GamePad screen, when it has its own: the home row as pages of big tiles ===
+void draw_gamepad_screen() {
+    TRACE_FUNCTION();
+    SDL_Renderer* renderer = gamepad_screen_renderer();
+    render_set_color(renderer, COLOR_BACKGROUND);
+    SDL_RenderClear(renderer);
 
-                render_set_color(main_renderer, COLOR_BLUE);
-                textRenderer->renderTextAt("None" /*Put the name of the option here later*/, {15, 206, 185, 255}, base_x + 8, y + 16, TextAlign::Left);
-
-                for (int t = 0; t < outline_thickness; ++t) {
-                    SDL_Rect thick_setting_rect = {
-                        setting_outline_rect.x - t,
-                        setting_outline_rect.y - t,
-                        setting_outline_rect.w + 2 * t,
-                        setting_outline_rect.h + 2 * t
-                    };
-                    SDL_RenderDrawRect(main_renderer, &thick_setting_rect);
-                }
-            } else {
-                textRenderer->renderTextAt("None" /*Put the name of the option here later*/, {255, 255, 255, 255}, base_x + 8, y + 16, TextAlign::Left);
-            }
-        }
+    if (cur_menu != MENU_MAIN) {
+        // The TV has the view, the GamePad a big way back out of it
+        render_set_color(renderer, COLOR_UI_BOX);
+        SDL_RenderFillRect(renderer, &gamepad_back_rect);
+        render_set_color(renderer, COLOR_CYAN);
+        SDL_RenderDrawRect(renderer, &gamepad_back_rect);
+        gamepadText->renderTextAt("Back", {255, 255, 255, 255}, gamepad_back_rect.x + gamepad_back_rect.w / 2,
+                                  gamepad_back_rect.y + gamepad_back_rect.h / 2 - 12, TextAlign::Center);
+        return;
     }
 
-    // === Bottom Row (Fixed Position, 6 centered circles) ===
-    int bottom_y = Config::WINDOW_HEIGHT - 250;
-    int total_width = (Config::TILE_COUNT_BOTTOM * Config::circle_diameter) + ((Config::TILE_COUNT_BOTTOM - 1) * 32);
-    int start_x = (Config::WINDOW_WIDTH - total_width) / 2;
+    int first = gamepad_page() * Config::GAMEPAD_PAGE_TILES;
+    for (int slot = 0; slot < Config::GAMEPAD_PAGE_TILES && first + slot < Config::TILE_COUNT_MIDDLE; ++slot) {
+        int i = first + slot;
+        SDL_Rect tile = gamepad_tile_rect(slot);
+        const GamePadIcon& cached = gamepad_icons[slot];
+        SDL_Texture* icon = i < (int)library.size() && gamepad_icon_current(cached, i) ? cached.icon : nullptr;
+
+        if (i == Config::TILE_COUNT_MIDDLE - 1) {
+            SDL_RenderCopy(renderer, gamepad_textures.circle_big, NULL, &tile);
+            SDL_RenderCopy(renderer, gamepad_textures.all_titles, NULL, &tile);
+        } else if (icon) {
+            render_icon_with_background(renderer, icon, library.hot.background[i], tile, render_icon_fit(icon, tile));
+        } else {
+            render_set_color(renderer, COLOR_UI_BOX);
+            SDL_RenderDrawRect(renderer, &tile);
+        }
 
-    if (cur_menu == MENU_MAIN) {
-        for (int i = 0; i < Config::TILE_COUNT_BOTTOM; ++i) {
-            int cx = start_x + i * (Config::circle_diameter + 32);
-            int cy = bottom_y;
-
-            SDL_Rect dst_rect = { cx, cy, Config::circle_diameter * 2, Config::circle_diameter * 2 };
-            SDL_Rect miiverse_rect = { (start_x + 0 * 107), cy, Config::circle_diameter * 2, Config::circle_diameter * 2 };
-            SDL_Rect eshop_rect = { (start_x + 1 * 107), cy, Config::circle_diameter * 2, Config::circle_diameter * 2 };
-            SDL_Rect screenshots_rect = { (start_x + 2 * 107), cy, Config::circle_diameter * 2, Config::circle_diameter * 2 };
-            SDL_Rect browser_rect = { (start_x + 3 * 107), cy, Config::circle_diameter * 2, Config::circle_diameter * 2 };
-            SDL_Rect controller_rect = { (start_x + 4 * 107), cy, Config::circle_diameter * 2, Config::circle_diameter * 2 };
-            SDL_Rect downloads_rect = { (start_x + 5 * 107), cy, Config::circle_diameter * 2, Config::circle_diameter * 2 };
-            SDL_Rect settings_rect = { (start_x + 6 * 107), cy, Config::circle_diameter * 2, Config::circle_diameter * 2 };
-            SDL_Rect power_rect = { (start_x + 7 * 107), cy, Config::circle_diameter * 2, Config::circle_diameter * 2 };
-            SDL_Rect reference_rect = { 0, 0, 1280, 720 };
-
-            SDL_RenderCopy(main_renderer, textures.circle, NULL, &dst_rect);
-
-            if (i == cur_selected_tile && cur_selected_row == ROW_BOTTOM) {
-                SDL_RenderCopy(main_renderer, textures.circle_selection, NULL, &dst_rect);
+        if (i == cur_selected_tile && cur_selected_row == ROW_MIDDLE) {
+            render_set_color(renderer, COLOR_CYAN);
+            for (int t = 1; t <= 4; ++t) {
+                SDL_Rect outline = { tile.x - t, tile.y - t, tile.w + 2 * t, tile.h + 2 * t };
+                SDL_RenderDrawRect(renderer, &outline);
             }
-
-            SDL_RenderCopy(main_renderer, textures.miiverse, NULL, &miiverse_rect);
-            SDL_RenderCopy(main_renderer, textures.eshop, NULL, &eshop_rect);
-            SDL_RenderCopy(main_renderer, textures.screenshots, NULL, &screenshots_rect);
-            SDL_RenderCopy(main_renderer, textures.browser, NULL, &browser_rect);
-            SDL_RenderCopy(main_renderer, textures.controller, NULL, &controller_rect);
-            SDL_RenderCopy(main_renderer, textures.downloads, NULL, &downloads_rect);
-            SDL_RenderCopy(main_renderer, textures.settings, NULL, &settings_rect);
-            SDL_RenderCopy(main_renderer, textures.power, NULL, &power_rect);
-            //SDL_RenderCopy(main_renderer, textures.reference, NULL, &reference_rect);
-            // Uncomment this to view a reference for positions and stuff of that sort ^
         }
     }
 
-    // === Top Row (Fixed, 1 circle in top-right) ===
-    int top_x = 40;
-    int top_y = 16;
+    if (cur_selected_row == ROW_MIDDLE) {
+        const char* title = cur_selected_tile == Config::TILE_COUNT_MIDDLE - 1 ? "All Software"
+                          : cur_selected_tile < (int)library.size() ? library.cold.title[cur_selected_tile] : "";
+        gamepadText->renderTextAt(title, {0, 255, 245, 255}, GAMEPAD_WIDTH / 2, 24, TextAlign::Center);
+    }
+
+    for (int direction : { -1, 1 }) {
+        int page = gamepad_page() + direction;
+        if (page < 0 || page >= gamepad_page_count()) continue;
+        SDL_Rect area = gamepad_page_rect(direction);
+        gamepadText->renderTextAt(direction < 0 ? "<" : ">", {255, 255, 255, 255}, area.x + area.w / 2,
+                                  area.y + area.h / 2 - 24, TextAlign::Center);
+    }
+}
+
+// Everything the GamePad screen shows, it is drawn and presented only when this changes
+uint64_t gamepad_screen_key() {
+    LayerKey key;
+    key.add(cur_menu).add(cur_selected_row).add(cur_selected_tile).add(library.generation).add(library.size());
+    key.add(gamepad_icon_loads);
+    return key;
+}
 
-    SDL_Rect dst_rect_top = { top_x, top_y, 100, 100 };
+// A line box from layout.hpp, left to right along its top
+void draw_layout_line(LayoutBox box, SDL_Point origin) {
+    const SDL_Rect& line = layout_rect(box);
+    SDL_RenderDrawLine(main_renderer, line.x - origin.x, line.y - origin.y, line.x + line.w - origin.x, line.y - origin.y);
+}
+
+// === Top Row (Fixed, 1 circle in top-right), page title or battery ===
+void draw_header(SDL_Point origin) {
+    SDL_Rect dst_rect_top = top_tile_rect();
+    dst_rect_top.x -= origin.x;
+    dst_rect_top.y -= origin.y;
     if ((cur_menu == MENU_MAIN) || (cur_menu == MENU_USER)) {
         SDL_RenderCopy(main_renderer, textures.circle, NULL, &dst_rect_top);
 
@@ -608,14 +1409,24 @@ void update() {
         }
     }
 
+    const SDL_Rect& title = layout_rect(BOX_HEADER_TITLE);
+    const int title_x = title.x - origin.x;
+    const int title_y = title.y - origin.y;
     if (cur_menu == MENU_SETTINGS) {
-        textRenderer->renderTextAt("System Settings", {255, 255, 255, 255}, 128, 32, TextAlign::Left);
+        textRenderer->renderTextAt("System Settings", {255, 255, 255, 255}, title_x, title_y, TextAlign::Left);
+    } else if (cur_menu == MENU_APPS) {
+        textRenderer->renderTextAt("All Software", {255, 255, 255, 255}, title_x, title_y, TextAlign::Left);
+    } else if (cur_menu == MENU_CONTROLLERS) {
+        textRenderer->renderTextAt("Controllers", {255, 255, 255, 255}, title_x, title_y, TextAlign::Left);
+    } else if (cur_menu == MENU_SCREENSHOT) {
+        textRenderer->renderTextAt("Album", {255, 255, 255, 255}, title_x, title_y, TextAlign::Left);
     } else if (cur_menu == MENU_USER) {
-        std::string title = std::string(ACCOUNT_ID) + "'s Page";
-        textRenderer->renderTextAt(title.c_str(), {255, 255, 255, 255}, 128, 32, TextAlign::Left);
+        textRenderer->renderTextAt(user_page_title.c_str(), {255, 255, 255, 255}, title_x, title_y, TextAlign::Left);
     } else {
-        std::string battery;
-        SDL_Rect battery_rect = { Config::WINDOW_WIDTH - 102, 51, 46, 28 };
+        const char* battery = "";
+        SDL_Rect battery_rect = layout_rect(BOX_BATTERY);
+        battery_rect.x -= origin.x;
+        battery_rect.y -= origin.y;
 
         switch (battery_level) {
             case 0:
@@ -655,92 +1466,408 @@ void update() {
                 break;
         }
 
-        textRenderer->renderTextAt(battery, {255, 255, 255, 255}, Config::WINDOW_WIDTH - 110, 53, TextAlign::Right);
+        const SDL_Rect& battery_text = layout_rect(BOX_BATTERY_TEXT);
+        textRenderer->renderTextAt(battery, {255, 255, 255, 255}, battery_text.x - origin.x, battery_text.y - origin.y, TextAlign::Right);
         SDL_RenderCopy(main_renderer, textures.battery_base, NULL, &battery_rect);
     }
 
-    // === Misc ===
-    if (menuOpen) {
-        render_set_color(main_renderer, COLOR_UI_BOX);
-        render_rectangle(main_renderer, 100, 0, (Config::WINDOW_WIDTH - 200), Config::WINDOW_HEIGHT, true);
+    if (cur_menu != MENU_MAIN) {
+        render_set_color(main_renderer, COLOR_WHITE);
+        draw_layout_line(BOX_HEADER_LINE, origin);
     }
+}
 
+// Bottom line and button hints
+void draw_footer(SDL_Point origin) {
     render_set_color(main_renderer, COLOR_WHITE);
-    if (menuOpen) {
-        SDL_RenderDrawLine(main_renderer, ((Config::WINDOW_WIDTH / 40) + 85), Config::WINDOW_HEIGHT - 70, ((Config::WINDOW_WIDTH / 1.025) - 85), Config::WINDOW_HEIGHT - 70);
-    } else {
-        SDL_RenderDrawLine(main_renderer, Config::WINDOW_WIDTH / 40, Config::WINDOW_HEIGHT - 70, Config::WINDOW_WIDTH / 1.025, Config::WINDOW_HEIGHT - 70);
-    }
-
-    if (cur_menu != MENU_MAIN) {
-        SDL_RenderDrawLine(main_renderer, Config::WINDOW_WIDTH / 40, 90, Config::WINDOW_WIDTH / 1.025, 90);
-    }
-    if (menuOpen) {
-        SDL_RenderDrawLine(main_renderer, ((Config::WINDOW_WIDTH / 40) + 85), 90, ((Config::WINDOW_WIDTH / 1.025) - 85), 90);
+    draw_layout_line(menuOpen ? BOX_FOOTER_LINE_MENU : BOX_FOOTER_LINE, origin);
+
+    SDL_Rect button_a_rect_1 = layout_rect(BOX_HINT_A);
+    SDL_Rect button_a_rect_2 = layout_rect(BOX_HINT_A_WIDE);
+    SDL_Rect button_plus_rect = layout_rect(BOX_HINT_PLUS);
+    for (SDL_Rect* rect : { &button_a_rect_1, &button_a_rect_2, &button_plus_rect }) {
+        rect->x -= origin.x;
+        rect->y -= origin.y;
     }
-
-    SDL_Rect button_a_rect_1 = { Config::WINDOW_WIDTH - 145, Config::WINDOW_HEIGHT - 60, 48, 48 };
-    SDL_Rect button_a_rect_2 = { Config::WINDOW_WIDTH - 160, Config::WINDOW_HEIGHT - 60, 48, 48 };
-    SDL_Rect button_plus_rect = { Config::WINDOW_WIDTH - 328, Config::WINDOW_HEIGHT - 60, 48, 48 };
+    const SDL_Point ok_text = { layout_rect(BOX_HINT_OK_TEXT).x - origin.x, layout_rect(BOX_HINT_OK_TEXT).y - origin.y };
+    const SDL_Point start_text = { layout_rect(BOX_HINT_START_TEXT).x - origin.x, layout_rect(BOX_HINT_START_TEXT).y - origin.y };
+    const SDL_Point options_text = { layout_rect(BOX_HINT_OPTIONS_TEXT).x - origin.x, layout_rect(BOX_HINT_OPTIONS_TEXT).y - origin.y };
     if (cur_menu == MENU_MAIN) {
         if ((cur_selected_row == ROW_TOP) || (cur_selected_row == ROW_BOTTOM)) {
             SDL_RenderCopy(main_renderer, textures.a_button, NULL, &button_a_rect_1);
-            textRenderer->renderTextAt("OK", {255, 255, 255, 255}, Config::WINDOW_WIDTH - 96, Config::WINDOW_HEIGHT - 49, TextAlign::Left);
+            textRenderer->renderTextAt("OK", {255, 255, 255, 255}, ok_text.x, ok_text.y, TextAlign::Left);
         } else {
             SDL_RenderCopy(main_renderer, textures.a_button, NULL, &button_a_rect_2);
             SDL_RenderCopy(main_renderer, textures.plus_button, NULL, &button_plus_rect);
-            textRenderer->renderTextAt("Start", {255, 255, 255, 255}, Config::WINDOW_WIDTH - 115, Config::WINDOW_HEIGHT - 49, TextAlign::Left);
-            textRenderer->renderTextAt("Options", {255, 255, 255, 255}, Config::WINDOW_WIDTH - 283, Config::WINDOW_HEIGHT - 49, TextAlign::Left);
+            textRenderer->renderTextAt("Start", {255, 255, 255, 255}, start_text.x, start_text.y, TextAlign::Left);
+            textRenderer->renderTextAt("Options", {255, 255, 255, 255}, options_text.x, options_text.y, TextAlign::Left);
+        }
+    } else if (cur_menu == MENU_APPS) {
+        SDL_RenderCopy(main_renderer, textures.a_button, NULL, &button_a_rect_2);
+        textRenderer->renderTextAt("Start", {255, 255, 255, 255}, start_text.x, start_text.y, TextAlign::Left);
+    } else if (cur_menu == MENU_SCREENSHOT) {
+        SDL_RenderCopy(main_renderer, textures.a_button, NULL, &button_a_rect_2);
+        textRenderer->renderTextAt("View", {255, 255, 255, 255}, start_text.x, start_text.y, TextAlign::Left);
+    }
+}
+
+// What each layer shows, its key
+uint64_t user_page_key() {
+    return LayerKey().add(cur_selected_subrow).add(accounts_generation);
+}
+
+uint64_t controllers_page_key() {
+    return LayerKey().add(controllers_page_generation);
+}
+
+uint64_t bottom_row_key() {
+    return LayerKey().add(cur_selected_row == ROW_BOTTOM ? cur_selected_tile : -1);
+}
+
+uint64_t header_key() {
+    return LayerKey().add(cur_menu).add(cur_selected_row == ROW_TOP && cur_selected_tile == 0).add(battery_level).add(user_page_title.c_str());
+}
+
+uint64_t footer_key() {
+    bool row_hint = (cur_selected_row == ROW_TOP) || (cur_selected_row == ROW_BOTTOM);
+    return LayerKey().add(cur_menu).add(row_hint).add(menuOpen);
+}
+
+// Everything draw_frame() shows outside All Software and the album: the
+// layers' keys and the middle row under the camera
+uint64_t tv_frame_key() {
+    LayerKey key;
+    key.add(cur_menu).add(menuOpen).add(header_key()).add(footer_key());
+    if (cur_menu == MENU_USER) key.add(user_page_key());
+    if (cur_menu == MENU_CONTROLLERS) key.add(controllers_page_key());
+    if (cur_menu == MENU_MAIN) {
+        key.add(bottom_row_key()).add(camera_offset_x).add(cur_selected_row).add(cur_selected_tile);
+        key.add(library.generation).add(library.size()).add(library.layout_valid);
+        for (size_t i = 0; i < library.size() && i < LIBRARY_HOME_ICONS; ++i) key.add((uintptr_t)library.hot.icon[i]);
+    }
+    return key;
+}
+
+// Draws the current state without presenting it
+void draw_frame() {
+    render_set_color(main_renderer, COLOR_BACKGROUND);
+    SDL_RenderClear(main_renderer);
+
+    // === Middle Row (Camera-dependent) ===
+    const int base_y = middle_tile_rect(0).y;
+
+    if (cur_menu == MENU_MAIN) {
+        if (!library.layout_valid) layout_library();
+
+        for (int i = 0; i < Config::TILE_COUNT_MIDDLE; ++i) {
+            SDL_Rect icon_rect = middle_tile_rect(i);
+            icon_rect.x -= camera_offset_x;
+            int x = icon_rect.x;
+            int title_x = x + icon_rect.w / 2;
+
+            if (i < (Config::TILE_COUNT_MIDDLE - 1)) {
+                if (i < (int)library.size() && library.hot.icon[i]) {
+                    SDL_Rect icon_dst = library.hot.icon_rect[i];
+                    icon_dst.x -= camera_offset_x;
+                    render_icon_with_background(main_renderer, library.hot.icon[i], library.hot.background[i], icon_rect, icon_dst);
+                } else {
+                    render_set_color(main_renderer, COLOR_UI_BOX);
+                    SDL_RenderDrawRect(main_renderer, &icon_rect);
+                }
+                if (i < (int)library.size() && (i == cur_selected_tile && cur_selected_row == ROW_MIDDLE)) {
+                    // Kept to the tile's width, a second line grows upwards
+                    const TextTexture& title = textRenderer->layoutText(library.cold.title[i], {0, 255, 245, 255}, icon_rect.w, Config::TITLE_MAX_LINES, TextAlign::Center);
+                    textRenderer->drawText(title, title_x, base_y - layout_metric(METRIC_GAP) - title.height, TextAlign::Center);
+                }
+            } else {
+                SDL_RenderCopy(main_renderer, textures.circle_big, NULL, &icon_rect);
+                SDL_RenderCopy(main_renderer, textures.all_titles, NULL, &icon_rect);
+                if (i == cur_selected_tile && cur_selected_row == ROW_MIDDLE) {
+                    textRenderer->renderTextAt("All Software", {0, 255, 245, 255}, title_x, base_y, TextAlign::Center);
+                }
+            }
+
+            if (i == cur_selected_tile && cur_selected_row == ROW_MIDDLE) {
+                const int outline_padding = layout_metric(METRIC_OUTLINE_PADDING);
+                const int outline_thickness = layout_metric(METRIC_OUTLINE);
+
+                SDL_Rect outline_rect = {
+                    x - outline_padding,
+                    base_y - outline_padding,
+                    icon_rect.w + 2 * outline_padding,
+                    icon_rect.h + 2 * outline_padding
+                };
+
+                render_set_color(main_renderer, COLOR_CYAN);
+
+                if (i < (Config::TILE_COUNT_MIDDLE - 1)) {
+                    for (int t = 0; t < outline_thickness; ++t) {
+                        SDL_Rect thick_rect = {
+                            outline_rect.x - t,
+                            outline_rect.y - t,
+                            outline_rect.w + 2 * t,
+                            outline_rect.h + 2 * t
+                        };
+                        SDL_RenderDrawRect(main_renderer, &thick_rect);
+                    }
+                } else {
+                    SDL_RenderCopy(main_renderer, textures.circle_big_selection, NULL, &icon_rect);
+                }
+            }
+        }
+    } else if (cur_menu == MENU_USER) {
+        if (layer_begin(main_renderer, layers.page, user_page_key())) {
+            draw_user_page(layer_origin(layers.page));
+            layer_end(main_renderer, layers.page);
+        }
+        layer_composite(main_renderer, layers.page);
+    } else if (cur_menu == MENU_CONTROLLERS) {
+        if (layer_begin(main_renderer, layers.controllers, controllers_page_key())) {
+            draw_controllers_page(layer_origin(layers.controllers));
+            layer_end(main_renderer, layers.controllers);
         }
+        layer_composite(main_renderer, layers.controllers);
+    } else if (cur_menu == MENU_APPS) {
+        apps_view_draw(main_renderer, textRenderer);
+    } else if (cur_menu == MENU_SCREENSHOT) {
+        album_draw(main_renderer, textRenderer);
     }
 
+    if (cur_menu == MENU_MAIN) {
+        if (layer_begin(main_renderer, layers.bottom_row, bottom_row_key())) {
+            draw_bottom_row(layer_origin(layers.bottom_row));
+            layer_end(main_renderer, layers.bottom_row);
+        }
+        layer_composite(main_renderer, layers.bottom_row);
+    }
+
+    if (layer_begin(main_renderer, layers.header, header_key())) {
+        draw_header(layer_origin(layers.header));
+        layer_end(main_renderer, layers.header);
+    }
+    layer_composite(main_renderer, layers.header);
+
+    // === Misc ===
+    if (menuOpen) {
+        render_set_color(main_renderer, COLOR_UI_BOX);
+        const SDL_Rect& panel = layout_rect(BOX_MENU_PANEL);
+        render_rectangle(main_renderer, panel.x, panel.y, panel.w, panel.h, true);
+
+        render_set_color(main_renderer, COLOR_WHITE);
+        draw_layout_line(BOX_MENU_LINE, { 0, 0 });
+    }
+
+    if (layer_begin(main_renderer, layers.footer, footer_key())) {
+        draw_footer(layer_origin(layers.footer));
+        layer_end(main_renderer, layers.footer);
+    }
+    layer_composite(main_renderer, layers.footer);
+}
+
+void update() {
+    TRACE_FUNCTION();
+
+    // The GamePad's screen, on its own renderer and only when it changed
+    if (gamepad_screen_active()) {
+        uint64_t key = gamepad_screen_key();
+        if (!gamepad_drawn || key != gamepad_drawn_key) {
+            draw_gamepad_screen();
+            gamepad_screen_present();
+            gamepad_drawn = true;
+            gamepad_drawn_key = key;
+        }
+    }
+
+    // Smooth camera movement, once per presented frame and not per draw
+    const float camera_speed = 0.2f;
+    camera_offset_x += (int)((target_camera_offset_x - camera_offset_x) * camera_speed);
+
+    // The TV frame is kept in a layer and only drawn again when its key
+    // changed, a settled frame costs one copy. All Software and the album
+    // stream their thumbnails in and draw straight to the screen.
+    if (cur_menu == MENU_APPS || cur_menu == MENU_SCREENSHOT) {
+        layer_invalidate(layers.screen);
+        draw_frame();
+    } else {
+        if (layer_begin(main_renderer, layers.screen, tv_frame_key())) {
+            draw_frame();
+            layer_end(main_renderer, layers.screen);
+        }
+        layer_composite(main_renderer, layers.screen);
+    }
+
+    {
+        TRACE_SCOPE("SDL_RenderPresent");
+        SDL_RenderPresent(main_renderer);
+    }
+    input_latency_presented();
+
+    frame_arena_reset();
+}
+
+// Background plus, when coming back from a title, the frame it was launched
+// from. Drawn before anything is loaded so the screen isn't black meanwhile.
+void draw_startup_shell() {
+    TRACE_FUNCTION();
+    render_set_color(main_renderer, COLOR_BACKGROUND);
+    SDL_RenderClear(main_renderer);
+    if (snapshot_pending(SNAPSHOT_PATH)) snapshot_draw_frame(SNAPSHOT_FRAME_PATH, main_renderer);
     SDL_RenderPresent(main_renderer);
 }
 
+// Home row icons still to load, a few per frame after startup or a rescan
+static size_t deferred_icon = 0;
+static bool deferred_backgrounds = false;
+
+// The main loop's work once the pads were read: the pollers, input and the
+// frame. The benchmark counts the allocations of this same call.
+void main_loop_step(CombinedInput& baseInput, Uint32 now) {
+    baseInput.process();
+    controllers_poll(now);
+    if (accounts_poll(main_renderer)) on_accounts_changed();
+
+    input(baseInput, now);
+
+    // The restored library turned out to be out of date. It is rescanned
+    // in the background and the home row's new icons load like at startup.
+    if (snapshot_poll_stale()) scan_apps_start(load_homebrew_titles);
+    if (scan_apps_poll()) {
+        snapshot_fingerprint(load_homebrew_titles);
+        deferred_icon = 0;
+        deferred_backgrounds = true;
+    }
+
+    // Edits to the SD folder made while the launcher was in the background
+    if (platform_returned_to_foreground()) sd_watch_request();
+    SdChanges sd_changes;
+    if (sd_watch_poll(sd_changes)) apply_sd_changes(sd_changes);
+
+    gamepad_load_icons();
+    update();
+}
+
+// Logs how long each startup stage took and when it ended
+struct StartupTimer {
+    Uint64 begin = SDL_GetPerformanceCounter();
+    Uint64 stage_begin = begin;
+
+    static double ms_between(Uint64 from, Uint64 to) {
+        return (to - from) * 1000.0 / SDL_GetPerformanceFrequency();
+    }
+
+    void stage(const char* name) {
+        Uint64 now = SDL_GetPerformanceCounter();
+        LOG_INFO(LOG_CAT_MAIN, "Startup: %s took %.1f ms, at %.1f ms", name, ms_between(stage_begin, now), ms_between(begin, now));
+        stage_begin = now;
+    }
+};
+
+// The benchmark build links everything above and brings its own main()
+#ifndef SWITCHU_BENCH
 int main(int argc, char const *argv[]) {
+    log_init();
+    TRACE_THREAD_NAME("main");
+    TRACE_START();
+
+    // Startup runs in stages by how soon their result is on screen: a shell
+    // frame, then what the current view needs, then the rest over the first
+    // frames the user can already interact with
+    StartupTimer startup;
+
     if (initialize() != EXIT_SUCCESS) {
         shutdown();
     }
+    draw_startup_shell();
+    startup.stage("first frame");
 
-    scan_apps(main_renderer);
+    platform_init();
+    controllers_subscribe(on_header_controller);
+    controllers_subscribe(on_page_controller);
+    startup.stage("platform");
 
-    WHBProcInit();
+    load_view_assets();
+    load_library();
+    startup.stage("view");
 
-    RPXLoader_InitLibrary();
+    bool startup_interactive = false;
+    bool startup_complete = false;
 
-    AXInit();
+    CombinedInput baseInput;
 
-    KPADInit();
-    WPADEnableURCC(TRUE);
+    InputRecorder recorder;
+    ReplayInput replayInput;
+    StressInput stressInput(Config::TILE_COUNT_MIDDLE, Config::TILE_COUNT_BOTTOM, Config::settings_row_count);
+    ScriptedInput* scriptedInput = nullptr;
+    FrameStats frameStats;
+    Uint32 scriptedTime = SDL_GetTicks();
+
+    switch (load_input_mode()) {
+        case INPUT_MODE_RECORD:
+            recorder.open(Config::INPUT_RECORDING_PATH, SDL_GetTicks());
+            break;
+        case INPUT_MODE_REPLAY:
+            if (replayInput.load(Config::INPUT_RECORDING_PATH)) scriptedInput = &replayInput;
+            break;
+        case INPUT_MODE_STRESS:
+            scriptedInput = &stressInput;
+            break;
+        default:
+            break;
+    }
 
-    CombinedInput baseInput;
-    VPadInput vpadInput;
-    WPADInput wpadInputs[4] = {
-            WPAD_CHAN_0,
-            WPAD_CHAN_1,
-            WPAD_CHAN_2,
-            WPAD_CHAN_3};
-
-    while (WHBProcIsRunning()) {
+    while (platform_is_running()) {
         baseInput.reset();
-        if (vpadInput.update(1280, 720)) {
-            baseInput.combine(vpadInput);
-        }
-        for (auto &wpadInput : wpadInputs) {
-            if (wpadInput.update(1280, 720)) {
-                baseInput.combine(wpadInput);
+        baseInput.sampleTime = SDL_GetPerformanceCounter();
+
+        // Scripted input stands in for the pads, the pads are not read at all
+        Uint32 now = SDL_GetTicks();
+        if (scriptedInput) {
+            frameStats.tick();
+            if (scriptedInput->update(scriptedTime)) {
+                baseInput.combine(*scriptedInput);
+                now = scriptedTime;
+            } else {
+                frameStats.write_report(Config::FRAME_TIMES_PATH, scriptedInput->name());
+                input_latency_report(scriptedInput->name());
+                LOG_INFO(LOG_CAT_MAIN, "Finished %s run, returning to live input", scriptedInput->name());
+                scriptedInput = nullptr;
             }
+        } else {
+            platform_read_input(baseInput, layout.width, layout.height);
+            recorder.write(baseInput, now);
+        }
+        main_loop_step(baseInput, now);
+
+        // Deferred startup work, a few icons per frame so it doesn't hitch
+        if (!startup_interactive) {
+            startup.stage("interactive");
+            startup_interactive = true;
+            load_deferred_assets();
+            sd_watch_start();
+        } else if (deferred_icon < library.size() && deferred_icon < LIBRARY_HOME_ICONS) {
+            library_load_icons(deferred_icon, deferred_icon + Config::DEFERRED_ICONS_PER_FRAME, main_renderer, deferred_backgrounds);
+            deferred_icon += Config::DEFERRED_ICONS_PER_FRAME;
+        } else if (!startup_complete) {
+            startup.stage("deferred");
+            startup_complete = true;
         }
-        baseInput.process();
-        battery_level = vpadInput.data.battery;
-
-        input(baseInput);
-
-        update();
     }
 
+    recorder.close();
+    input_latency_report("session");
+
+    close_menu();
+    scan_apps_shutdown();
+    snapshot_shutdown();
+    sd_watch_shutdown();
+    accounts_shutdown();
+    audio_shutdown();
     shutdown();
 
-    WHBProcShutdown();
+    platform_shutdown();
+
+    TRACE_STOP();
+    log_shutdown();
     return EXIT_SUCCESS;
 }
+#endif
@@ -0,0 +1,20 @@
+#pragma once
+
+enum RowSelection {
+    ROW_TOP = 0,
+    ROW_MIDDLE = 1,
+    ROW_BOTTOM = 2
+};
+
+enum Menu {
+    MENU_MAIN = 0,
+    MENU_APPS = 1,
+    MENU_USER = 2,
+    MENU_MORE = 3,
+    MENU_SETTINGS = 4,
+    MENU_SCREENSHOT = 5,
+    MENU_CONTROLLERS = 6
+};
+
+extern int cur_menu;
+extern int cur_selected_row;
@@ -0,0 +1,213 @@
+#include <SDL2/SDL.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "input/CombinedInput.h"
+#include "input/SDLInput.h"
+
+#include "log.hpp"
+#include "platform/platform.hpp"
+#include "platform/mcp_standin.hpp"
+
+// Title directories are read from the same places the console keeps them,
+// relative to ROOT_PATH: /vol/storage_<device>01/usr/title/<high>/<low>
+static const char* title_storages[] = { "odd", "mlc", "usb" };
+static const char* title_types[] = { "00050000" };
+
+static bool running = true;
+static bool focus_gained = false;
+static SDLInput sdlInput;
+
+// Small enough that a sound starts within a few ms of being triggered
+static const int AUDIO_DEVICE_FRAMES = 256;
+static SDL_AudioDeviceID audio_device = 0;
+static PlatformAudioCallback audio_callback = nullptr;
+
+void platform_init() {
+    running = true;
+}
+
+bool platform_is_running() {
+    SDL_Event event;
+    while (SDL_PollEvent(&event)) {
+        if (event.type == SDL_QUIT) running = false;
+        // SDL only sends SDL_QUIT once the last window is gone, closing either screen's ends the launcher
+        if (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_CLOSE) running = false;
+        if (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_FOCUS_GAINED) focus_gained = true;
+    }
+    return running;
+}
+
+bool platform_returned_to_foreground() {
+    bool gained = focus_gained;
+    focus_gained = false;
+    return gained;
+}
+
+void platform_shutdown() {
+}
+
+SDL_Window* platform_create_window(PlatformScreen screen, const char* title, int width, int height) {
+    SDL_Window* window = SDL_CreateWindow(title, SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, width, height, 0);
+    if (window && screen == SCREEN_GAMEPAD) sdlInput.setTouchWindow(window);
+    return window;
+}
+
+// A 720p window unless SWITCHU_TV=1080p
+void platform_tv_size(int& width, int& height) {
+    const char* tv = getenv("SWITCHU_TV");
+    bool full_hd = tv && strcmp(tv, "1080p") == 0;
+    width = full_hd ? 1920 : 1280;
+    height = full_hd ? 1080 : 720;
+}
+
+bool platform_list_titles(std::pmr::vector<PlatformTitle>& out) {
+    if (mcp_standin_available()) {
+        return mcp_standin_list_titles(out);
+    }
+
+    for (const char* device : title_storages) {
+        for (const char* type : title_types) {
+            std::string type_path = std::string("/vol/storage_") + device + "01/usr/title/" + type;
+            std::string dir_path = ROOT_PATH + type_path;
+
+            DIR* dir = opendir(dir_path.c_str());
+            if (!dir) continue;
+
+            struct dirent* entry;
+            while ((entry = readdir(dir)) != nullptr) {
+                if (entry->d_name[0] == '.' || strlen(entry->d_name) != 8) continue;
+
+                uint64_t title_id = (strtoull(type, nullptr, 16) << 32) | strtoull(entry->d_name, nullptr, 16);
+                out.push_back(make_platform_title(title_id, (type_path + "/" + entry->d_name).c_str(), device));
+            }
+            closedir(dir);
+        }
+    }
+
+    LOG_INFO(LOG_CAT_PLATFORM, "Found %u titles under %s", (unsigned)out.size(), ROOT_PATH);
+    return true;
+}
+
+void platform_launch_title(uint64_t title_id) {
+    LOG_INFO(LOG_CAT_PLATFORM, "Would launch title %016llx", (unsigned long long)title_id);
+}
+
+void platform_launch_homebrew(const char* path) {
+    LOG_INFO(LOG_CAT_PLATFORM, "Would launch homebrew %s%s", SD_CARD_PATH, path);
+}
+
+void platform_switch_to(PlatformApplet applet) {
+    LOG_INFO(LOG_CAT_PLATFORM, "Would switch to system applet %d", (int)applet);
+}
+
+void platform_log_write(const char* line) {
+    fputs(line, stdout);
+}
+
+// There are no system fonts to borrow, an optional one on the SD card stands in
+size_t platform_fallback_fonts(PlatformFont* out, size_t max) {
+    static std::vector<char> fallback;
+    static bool loaded = false;
+
+    if (!loaded) {
+        loaded = true;
+        FILE* file = fopen(SD_CARD_PATH "switchU/fonts/fallback.ttf", "rb");
+        if (file) {
+            fseek(file, 0, SEEK_END);
+            fallback.resize(ftell(file));
+            fseek(file, 0, SEEK_SET);
+            if (fread(fallback.data(), 1, fallback.size(), file) != fallback.size()) fallback.clear();
+            fclose(file);
+        }
+    }
+
+    if (fallback.empty() || max == 0) return 0;
+    out[0] = { fallback.data(), fallback.size() };
+    return 1;
+}
+
+static const char* linux_user() {
+    const char* user = getenv("USER");
+    return user ? user : "linux";
+}
+
+bool platform_list_accounts(std::vector<PlatformAccount>& out) {
+    // The one user running it, who has no Mii. The name stands in for its
+    // data, so the cached profile follows a different user.
+    PlatformAccount account = {};
+    account.slot = 1;
+    account.persistent_id = 0x80000001;
+    account.mii_hash = 0xcbf29ce484222325ULL;
+    for (const char* p = linux_user(); *p; ++p) {
+        account.mii_hash ^= (unsigned char)*p;
+        account.mii_hash *= 0x100000001b3ULL;
+    }
+    account.current = true;
+    out.push_back(account);
+    return true;
+}
+
+bool platform_account_profile(PlatformAccount& account) {
+    account.account_id = linux_user();
+    account.name = account.account_id;
+    return true;
+}
+
+bool platform_account_mii_image(const PlatformAccount&, std::vector<uint8_t>&) {
+    return false;
+}
+
+static void sdl_audio_callback(void*, Uint8* stream, int length) {
+    audio_callback((int16_t*)stream, length / (2 * sizeof(int16_t)));
+}
+
+bool platform_audio_open(int rate, PlatformAudioCallback callback) {
+    if (SDL_InitSubSystem(SDL_INIT_AUDIO) != 0) {
+        LOG_ERROR(LOG_CAT_PLATFORM, "SDL audio failed to start: %s", SDL_GetError());
+        return false;
+    }
+
+    SDL_AudioSpec wanted = {};
+    wanted.freq = rate;
+    wanted.format = AUDIO_S16SYS;
+    wanted.channels = 2;
+    wanted.samples = AUDIO_DEVICE_FRAMES;
+    wanted.callback = sdl_audio_callback;
+
+    // SDL converts to whatever the device wants, the callback always gets this format
+    audio_callback = callback;
+    audio_device = SDL_OpenAudioDevice(nullptr, 0, &wanted, nullptr, 0);
+    if (audio_device == 0) {
+        LOG_ERROR(LOG_CAT_PLATFORM, "Failed to open audio device: %s", SDL_GetError());
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+        return false;
+    }
+    SDL_PauseAudioDevice(audio_device, 0);
+    return true;
+}
+
+void platform_audio_close() {
+    if (audio_device == 0) return;
+    SDL_CloseAudioDevice(audio_device);
+    SDL_QuitSubSystem(SDL_INIT_AUDIO);
+    audio_device = 0;
+}
+
+void platform_read_input(CombinedInput& input, int width, int height) {
+    if (sdlInput.update(width, height)) {
+        input.combine(sdlInput);
+    }
+}
+
+void platform_controller_status(int slot, PlatformControllerStatus& out) {
+    // Only the keyboard and mouse, standing in for a GamePad that is charging
+    out = PlatformControllerStatus();
+    out.connected = slot == 0;
+}
+
+bool platform_controllers_changed() {
+    return false;
+}
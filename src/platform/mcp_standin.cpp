@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "log.hpp"
+#include "platform/mcp_standin.hpp"
+
+static const uint32_t supported_app_types[] = {
+    MCP_STANDIN_APP_TYPE_GAME,
+    MCP_STANDIN_APP_TYPE_GAME_WII
+};
+
+// Re-read on every call like the real thing, a scan reads it twice per type
+static bool read_titles(std::vector<McpStandinTitle>& titles) {
+    FILE* file = fopen(MCP_STANDIN_PATH, "r");
+    if (!file) return false;
+
+    char line[256];
+    while (fgets(line, sizeof(line), file)) {
+        unsigned long long title_id;
+        unsigned int app_type;
+        McpStandinTitle title = {};
+        if (sscanf(line, "%16llx %8x %9s %55s", &title_id, &app_type, title.indexedDevice, title.path) != 4) continue;
+
+        title.titleId = title_id;
+        title.appType = app_type;
+        titles.push_back(title);
+    }
+
+    fclose(file);
+    return true;
+}
+
+bool mcp_standin_available() {
+    return access(MCP_STANDIN_PATH, R_OK) == 0;
+}
+
+int32_t mcp_standin_title_count() {
+    std::vector<McpStandinTitle> titles;
+    if (!read_titles(titles)) return -1;
+    return (int32_t)titles.size();
+}
+
+int32_t mcp_standin_title_list_by_app_type(uint32_t app_type, uint32_t* out_count, McpStandinTitle* out, uint32_t out_size) {
+    std::vector<McpStandinTitle> titles;
+    if (!read_titles(titles)) return -1;
+
+    uint32_t capacity = out_size / sizeof(McpStandinTitle);
+    uint32_t count = 0;
+    for (const auto& title : titles) {
+        if (title.appType != app_type) continue;
+        if (count == capacity) break;
+        out[count++] = title;
+    }
+
+    *out_count = count;
+    return 0;
+}
+
+bool mcp_standin_list_titles(std::pmr::vector<PlatformTitle>& out) {
+    int32_t title_count = mcp_standin_title_count();
+    if (title_count <= 0) {
+        LOG_WARN(LOG_CAT_PLATFORM, "No titles found in %s", MCP_STANDIN_PATH);
+        return false;
+    }
+    LOG_INFO(LOG_CAT_PLATFORM, "Found %d apps (stand-in)", title_count);
+
+    uint32_t game_count = 0;
+    std::pmr::vector<McpStandinTitle> titles(title_count, out.get_allocator());
+    for (uint32_t type : supported_app_types) {
+        uint32_t game_count_per_type = 0;
+        int32_t err = mcp_standin_title_list_by_app_type(
+                type, &game_count_per_type, titles.data() + game_count,
+                (titles.size() - game_count) * sizeof(McpStandinTitle));
+
+        if (err < 0) {
+            LOG_ERROR(LOG_CAT_PLATFORM, "Failed to get installed games of type %08x", type);
+            return false;
+        }
+
+        game_count += game_count_per_type;
+    }
+
+    out.reserve(out.size() + game_count);
+    for (uint32_t i = 0; i < game_count; ++i) {
+        out.push_back(make_platform_title(titles[i].titleId, titles[i].path, titles[i].indexedDevice));
+    }
+    return true;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+// Stand-in for MCP_TitleCount/MCP_TitleListByAppType backed by a title list
+// file, so scan_apps() can be run against a generated library (see
+// tools/make_library.cpp) instead of what is really installed. When
+// sd:/switchU/mcp_titles.txt exists both platforms list titles from it.
+//
+// Each line of the file is one title:
+//   <title id, 16 hex digits> <app type, 8 hex digits> <device> <path>
+
+#include <cstdint>
+#include <vector>
+
+#include "platform/platform.hpp"
+
+#define MCP_STANDIN_PATH SD_CARD_PATH "switchU/mcp_titles.txt"
+
+// Same values as MCPAppType
+constexpr uint32_t MCP_STANDIN_APP_TYPE_GAME = 0x80000000;
+constexpr uint32_t MCP_STANDIN_APP_TYPE_GAME_WII = 0x8000002E;
+
+// Mirrors the MCPTitleListType fields the launcher reads
+struct McpStandinTitle {
+    uint64_t titleId;
+    uint32_t appType;
+    char path[56];
+    char indexedDevice[10];
+};
+
+bool mcp_standin_available();
+
+// Same contract as the MCP calls they stand in for: a negative result is an
+// error, list_by_app_type fills at most out_size bytes of out
+int32_t mcp_standin_title_count();
+int32_t mcp_standin_title_list_by_app_type(uint32_t app_type, uint32_t* out_count, McpStandinTitle* out, uint32_t out_size);
+
+// platform_list_titles() for the stand-in, goes through the calls above the
+// same way the Wii U implementation goes through MCP
+bool mcp_standin_list_titles(std::pmr::vector<PlatformTitle>& out);
@@ -0,0 +1,153 @@
+#pragma once
+
+// Thin layer between the launcher and the system it runs on. There is one
+// implementation per target under src/platform/<target>/, the Makefile picks
+// which one gets built.
+
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+class CombinedInput;
+struct SDL_Window;
+
+// Filesystem roots. On Linux the console layout is mirrored under a plain
+// directory, "fs/vol/external01/" is the SD card.
+#if defined(__WIIU__)
+#define ROOT_PATH "fs:"
+#define SD_CARD_PATH "fs:/vol/external01/"
+#else
+#ifndef ROOT_PATH
+#define ROOT_PATH "fs"
+#endif
+#define SD_CARD_PATH ROOT_PATH "/vol/external01/"
+#endif
+
+// An installed title as reported by the system
+// Same sizes as MCPTitleListType, so listing titles doesn't allocate per title
+struct PlatformTitle {
+    uint64_t title_id;
+    char path[56];      // e.g. "/vol/storage_mlc01/usr/title/00050000/101c9500"
+    char device[10];    // "odd", "usb" or "mlc"
+};
+
+inline PlatformTitle make_platform_title(uint64_t title_id, const char* path, const char* device) {
+    PlatformTitle title = {};
+    title.title_id = title_id;
+    strncpy(title.path, path, sizeof(title.path) - 1);
+    strncpy(title.device, device, sizeof(title.device) - 1);
+    return title;
+}
+
+enum PlatformApplet {
+    APPLET_MIIVERSE = 0,
+    APPLET_BROWSER = 1,
+    APPLET_DOWNLOAD_MANAGER = 2
+};
+
+// === Process lifecycle ===
+// Starts the process loop and system services (launcher, audio, controllers)
+void platform_init();
+// False once the system asks the launcher to quit
+bool platform_is_running();
+// True once after each return to the foreground, e.g. from the HOME Menu
+bool platform_returned_to_foreground();
+void platform_shutdown();
+
+// === Screens ===
+enum PlatformScreen {
+    SCREEN_MIRRORED = 0,    // the TV and the GamePad show the same window
+    SCREEN_TV = 1,
+    SCREEN_GAMEPAD = 2
+};
+
+// Creates the window shown on screen. On Linux every screen is a desktop
+// window and the mouse touches the GamePad's, once there is one.
+SDL_Window* platform_create_window(PlatformScreen screen, const char* title, int width, int height);
+// The resolution the TV is set to output
+void platform_tv_size(int& width, int& height);
+
+// === Titles ===
+// Fills out with every installed game, returns false if the title list can't be read
+bool platform_list_titles(std::pmr::vector<PlatformTitle>& out);
+void platform_launch_title(uint64_t title_id);
+// path is relative to the SD card root, e.g. "wiiu/apps/foo/foo.wuhb"
+void platform_launch_homebrew(const char* path);
+void platform_switch_to(PlatformApplet applet);
+
+// === Logging ===
+// Writes one finished log line (see log.hpp) to the system log, called from the log thread
+void platform_log_write(const char* line);
+
+// === Fonts ===
+// A font file in memory, valid until the process exits
+struct PlatformFont {
+    const void* data;
+    size_t size;
+};
+
+// Fonts to fall back on for characters the launcher's font doesn't have
+// (e.g. CJK titles), in the order they should be tried. Returns how many
+// were written to out.
+size_t platform_fallback_fonts(PlatformFont* out, size_t max);
+
+// === Accounts ===
+// These go through nn::act on the console and can take a while, call them
+// off the main thread
+
+struct PlatformAccount {
+    uint8_t slot;               // the system's, for platform_account_mii_image()
+    uint32_t persistent_id;     // stable for as long as the account exists
+    std::string account_id;     // the Nintendo Network ID, empty if there is none
+    std::string name;           // the Mii's name, UTF-8
+    uint64_t mii_hash;          // of the Mii's data, changes whenever the Mii is edited
+    bool current;               // the account that is signed in
+};
+
+// Every account on the console, false if they can't be read. Only what
+// identifies each one and its Mii hash, name and account_id stay empty.
+bool platform_list_accounts(std::vector<PlatformAccount>& out);
+// Fills in the account's name and account_id, false if they can't be read
+bool platform_account_profile(PlatformAccount& account);
+// The account's Mii face as an image file (a TGA on the console), false if it has none
+bool platform_account_mii_image(const PlatformAccount& account, std::vector<uint8_t>& out);
+
+// === Audio ===
+// Fills frames interleaved stereo 16 bit frames, called on the platform's audio thread
+using PlatformAudioCallback = void (*)(int16_t* out, int frames);
+// Starts pulling audio at rate Hz from callback, false if there is no output
+bool platform_audio_open(int rate, PlatformAudioCallback callback);
+void platform_audio_close();
+
+// === Input ===
+// Reads the buttons and pointers of the connected controllers into input,
+// width/height are the screen size used for touch and pointer coordinates
+void platform_read_input(CombinedInput& input, int width, int height);
+
+// === Controllers ===
+// Slot 0 is the GamePad (the keyboard and mouse on Linux), 1 to 4 the Wii Remote channels
+constexpr int PLATFORM_CONTROLLER_SLOTS = 5;
+
+enum PlatformExtension {
+    EXTENSION_NONE,
+    EXTENSION_NUNCHUK,
+    EXTENSION_CLASSIC,
+    EXTENSION_PRO,
+    EXTENSION_OTHER
+};
+
+struct PlatformControllerStatus {
+    bool connected = false;
+    // In the controller's own scale: the GamePad's 0 (charging) to 6 (full),
+    // a Wii Remote's 0 (empty) to 4 (full)
+    int battery = 0;
+    PlatformExtension extension = EXTENSION_NONE;
+};
+
+// Probes a slot for what changes slowly, too costly to do every frame. Also
+// decides whether platform_read_input() reads the slot until the next probe.
+void platform_controller_status(int slot, PlatformControllerStatus& out);
+// True once after a controller connected or disconnected since the last call
+bool platform_controllers_changed();
@@ -0,0 +1,463 @@
+#include <SDL2/SDL.h>
+#include <rpxloader/rpxloader.h>
+#include <coreinit/cache.h>
+#include <coreinit/mcp.h>
+#include <coreinit/memory.h>
+#include <gx2/display.h>
+#include <padscore/kpad.h>
+#include <proc_ui/procui.h>
+#include <sndcore2/core.h>
+#include <sndcore2/voice.h>
+#include <sysapp/launch.h>
+#include <sysapp/title.h>
+#include <nn/acp/title.h>
+#include <nn/act.h>
+#include <whb/proc.h>
+#include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <initializer_list>
+
+#include "input/CombinedInput.h"
+#include "input/VPADInput.h"
+#include "input/WPADInput.h"
+
+#include "log.hpp"
+#include "platform/platform.hpp"
+#include "platform/mcp_standin.hpp"
+
+static const std::vector<MCPAppType> supported_sys_app_type {
+    MCP_APP_TYPE_GAME,
+    MCP_APP_TYPE_GAME_WII
+};
+
+static bool act_initialized = false;
+static bool foreground_acquired = false;
+
+// AX voices are mono, so the mix goes into one looping ring per channel. The
+// AX frame callback, every 3 ms, keeps the rings AUDIO_LEAD_FRAMES ahead of
+// where the voices are playing.
+static const uint32_t AUDIO_RING_FRAMES = 4096;    // power of two
+static const uint32_t AUDIO_LEAD_FRAMES = 576;     // 4 AX frames at 48 kHz
+static AXVoice* audio_voices[2] = {};
+alignas(64) static int16_t audio_rings[2][AUDIO_RING_FRAMES];
+static int16_t audio_mix[AUDIO_LEAD_FRAMES * 2];
+static uint32_t audio_write = 0;                    // next ring frame to fill
+static PlatformAudioCallback audio_callback = nullptr;
+
+static VPadInput vpadInput;
+static WPADInput wpadInputs[4] = {
+        WPAD_CHAN_0,
+        WPAD_CHAN_1,
+        WPAD_CHAN_2,
+        WPAD_CHAN_3};
+
+// Set by the KPAD connect callback, which runs on the system's thread
+static std::atomic<bool> controllers_changed{false};
+
+static void on_wpad_connect(KPADChan, int32_t) {
+    controllers_changed.store(true, std::memory_order_relaxed);
+}
+
+// Runs on the main thread from within WHBProcIsRunning()
+static uint32_t on_foreground_acquired(void*) {
+    foreground_acquired = true;
+    return 0;
+}
+
+void platform_init() {
+    WHBProcInit();
+    ProcUIRegisterCallback(PROCUI_CALLBACK_ACQUIRE, on_foreground_acquired, nullptr, 100);
+
+    if (RPXLoader_InitLibrary() != RPX_LOADER_RESULT_SUCCESS) {
+        LOG_ERROR(LOG_CAT_PLATFORM, "RPX_LOADER failed with an error");
+    }
+
+    // The launcher mixes at 48 kHz, so does the renderer and nothing resamples
+    AXInitParams ax_params = { AX_INIT_RENDERER_48KHZ, 0, AX_INIT_PIPELINE_SINGLE };
+    AXInitWithParams(&ax_params);
+
+    KPADInit();
+    WPADEnableURCC(TRUE);
+    for (int chan = WPAD_CHAN_0; chan <= WPAD_CHAN_3; chan++) {
+        KPADSetConnectCallback((KPADChan)chan, on_wpad_connect);
+    }
+}
+
+bool platform_is_running() {
+    return WHBProcIsRunning();
+}
+
+bool platform_returned_to_foreground() {
+    bool acquired = foreground_acquired;
+    foreground_acquired = false;
+    return acquired;
+}
+
+void platform_shutdown() {
+    if (act_initialized) {
+        nn::act::Finalize();
+        act_initialized = false;
+    }
+
+    RPXLoader_DeInitLibrary();
+
+    AXQuit();
+
+    WHBProcShutdown();
+}
+
+// The SDL port puts a window on both screens unless told otherwise
+SDL_Window* platform_create_window(PlatformScreen screen, const char* title, int width, int height) {
+    Uint32 flags = 0;
+    if (screen == SCREEN_TV) flags = SDL_WINDOW_WIIU_TV_ONLY;
+    else if (screen == SCREEN_GAMEPAD) flags = SDL_WINDOW_WIIU_GAMEPAD_ONLY;
+    return SDL_CreateWindow(title, SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, width, height, flags);
+}
+
+void platform_tv_size(int& width, int& height) {
+    switch (GX2GetSystemTVScanMode()) {
+        case GX2_TV_SCAN_MODE_1080I:
+        case GX2_TV_SCAN_MODE_1080P:
+            width = 1920;
+            height = 1080;
+            break;
+        default:
+            // 480p and 576i TVs get the 720p picture scaled down
+            width = 1280;
+            height = 720;
+            break;
+    }
+}
+
+bool platform_list_titles(std::pmr::vector<PlatformTitle>& out) {
+    if (mcp_standin_available()) {
+        return mcp_standin_list_titles(out);
+    }
+
+    MCPError handle = MCP_Open();
+    if (handle < 0) {
+        LOG_ERROR(LOG_CAT_PLATFORM, "Failed to start MCP");
+        return false;
+    }
+
+    uint32_t game_count = 0;
+    int32_t title_count = MCP_TitleCount(handle);
+    if (title_count <= 0) {
+        LOG_WARN(LOG_CAT_PLATFORM, "No titles found");
+        MCP_Close(handle);
+        return false;
+    }
+    LOG_INFO(LOG_CAT_PLATFORM, "Found %d apps", title_count);
+
+    // More stuff from Launchiine, my way only worked on Cemu for some reason
+    std::pmr::vector<MCPTitleListType> titles(title_count, out.get_allocator());
+    for (MCPAppType type : supported_sys_app_type) {
+        uint32_t game_count_per_type = 0;
+        MCPError err = MCP_TitleListByAppType(
+                 handle, type,&game_count_per_type, titles.data() + game_count,
+                 (titles.size() - game_count) * sizeof(decltype(titles)::value_type));
+
+        if (err < 0) {
+            LOG_ERROR(LOG_CAT_PLATFORM, "Failed to get installed games of type %d", type);
+            MCP_Close(handle);
+            return false;
+        }
+
+        game_count += game_count_per_type;
+    }
+    MCP_Close(handle);
+
+    out.reserve(out.size() + game_count);
+    for (uint32_t i = 0; i < game_count; ++i) {
+        out.push_back(make_platform_title(titles[i].titleId, titles[i].path, titles[i].indexedDevice));
+    }
+    return true;
+}
+
+void platform_launch_title(uint64_t title_id) {
+    MCPTitleListType titleInfo;
+    int32_t handle = MCP_Open();
+    auto err       = MCP_GetTitleInfo(handle, title_id, &titleInfo);
+    MCP_Close(handle);
+
+    if (SYSCheckTitleExists(title_id) && err == ACP_RESULT_SUCCESS) {
+        ACPAssignTitlePatch(&titleInfo);
+        SYSLaunchTitle(title_id);
+    } else {
+        LOG_ERROR(LOG_CAT_PLATFORM, "Title not found or ACP error.");
+    }
+}
+
+void platform_launch_homebrew(const char* path) {
+    RPXLoaderStatus st = RPXLoader_LaunchHomebrew(path);
+    LOG_INFO(LOG_CAT_PLATFORM, "Launch status: %s", RPXLoader_GetStatusStr(st));
+}
+
+void platform_switch_to(PlatformApplet applet) {
+    switch (applet) {
+        case APPLET_MIIVERSE:
+            _SYSSwitchTo(SysAppPFID::SYSAPP_PFID_MIIVERSE);
+            break;
+        case APPLET_BROWSER:
+            SYSSwitchToBrowser(nullptr);
+            break;
+        case APPLET_DOWNLOAD_MANAGER:
+            _SYSSwitchTo(SysAppPFID::SYSAPP_PFID_DOWNLOAD_MANAGEMENT);
+            break;
+    }
+}
+
+// The system fonts stay mapped for every process, CafeStd covers Latin and
+// Japanese and the others add Chinese and Korean
+size_t platform_fallback_fonts(PlatformFont* out, size_t max) {
+    static const OSSharedDataType font_types[] = {
+        OS_SHAREDDATATYPE_FONT_STANDARD,
+        OS_SHAREDDATATYPE_FONT_CHINESE,
+        OS_SHAREDDATATYPE_FONT_TAIWANESE,
+        OS_SHAREDDATATYPE_FONT_KOREAN
+    };
+
+    size_t count = 0;
+    for (OSSharedDataType type : font_types) {
+        void* data = nullptr;
+        uint32_t size = 0;
+        if (count < max && OSGetSharedData(type, 0, &data, &size)) {
+            out[count++] = { data, size };
+        }
+    }
+    return count;
+}
+
+// Only called from the accounts worker, platform_shutdown() runs after it is joined
+static void init_act() {
+    if (!act_initialized) {
+        nn::act::Initialize();
+        act_initialized = true;
+    }
+}
+
+static std::string utf16_to_utf8(const char16_t* text) {
+    std::string out;
+    for (; *text; ++text) {
+        uint32_t c = *text;
+        if (c >= 0xD800 && c < 0xDC00 && text[1] >= 0xDC00 && text[1] < 0xE000) {
+            c = 0x10000 + ((c - 0xD800) << 10) + (*++text - 0xDC00);
+        }
+        if (c < 0x80) {
+            out += (char)c;
+        } else if (c < 0x800) {
+            out += (char)(0xC0 | (c >> 6));
+            out += (char)(0x80 | (c & 0x3F));
+        } else if (c < 0x10000) {
+            out += (char)(0xE0 | (c >> 12));
+            out += (char)(0x80 | ((c >> 6) & 0x3F));
+            out += (char)(0x80 | (c & 0x3F));
+        } else {
+            out += (char)(0xF0 | (c >> 18));
+            out += (char)(0x80 | ((c >> 12) & 0x3F));
+            out += (char)(0x80 | ((c >> 6) & 0x3F));
+            out += (char)(0x80 | (c & 0x3F));
+        }
+    }
+    return out;
+}
+
+bool platform_list_accounts(std::vector<PlatformAccount>& out) {
+    static const nn::act::SlotNo MAX_SLOT = 12;
+    init_act();
+
+    nn::act::SlotNo current = nn::act::GetSlotNo();
+    for (nn::act::SlotNo slot = 1; slot <= MAX_SLOT; slot++) {
+        if (!nn::act::IsSlotOccupied(slot)) continue;
+
+        PlatformAccount account = {};
+        account.slot = slot;
+        account.persistent_id = nn::act::GetPersistentIdEx(slot);
+        account.current = slot == current;
+
+        FFLStoreData mii;
+        if (nn::act::GetMiiEx(&mii, slot).IsSuccess()) {
+            account.mii_hash = 0xcbf29ce484222325ULL;
+            for (uint8_t byte : mii.data) {
+                account.mii_hash ^= byte;
+                account.mii_hash *= 0x100000001b3ULL;
+            }
+        }
+        out.push_back(std::move(account));
+    }
+    return !out.empty();
+}
+
+bool platform_account_profile(PlatformAccount& account) {
+    init_act();
+    // Accounts without a Nintendo Network ID have none to read
+    char account_id[17] = {};
+    if (nn::act::GetAccountIdEx(account_id, account.slot).IsSuccess()) account.account_id = account_id;
+
+    char16_t name[11] = {};
+    if (nn::act::GetMiiNameEx(name, account.slot).IsFailure()) return false;
+    account.name = utf16_to_utf8(name);
+    return true;
+}
+
+bool platform_account_mii_image(const PlatformAccount& account, std::vector<uint8_t>& out) {
+    init_act();
+    out.resize(256 * 1024);
+    size_t size = 0;
+    if (nn::act::GetMiiImageEx(&size, out.data(), out.size(), 0, account.slot).IsFailure() || size == 0) {
+        out.clear();
+        return false;
+    }
+    out.resize(std::min(size, out.size()));
+    return true;
+}
+
+static void flush_ring_range(uint32_t start, uint32_t frames) {
+    for (int16_t* ring : { audio_rings[0], audio_rings[1] }) {
+        uint32_t first = std::min(frames, AUDIO_RING_FRAMES - start);
+        DCFlushRange(ring + start, first * sizeof(int16_t));
+        if (first < frames) DCFlushRange(ring, (frames - first) * sizeof(int16_t));
+    }
+}
+
+static void audio_frame_callback() {
+    AXVoiceOffsets offsets;
+    AXGetVoiceOffsets(audio_voices[0], &offsets);
+    uint32_t playing = offsets.currentOffset;
+
+    // Further ahead than we ever write means playback overtook us, start over just ahead of it
+    uint32_t ahead = (audio_write - playing) & (AUDIO_RING_FRAMES - 1);
+    if (ahead > AUDIO_LEAD_FRAMES) {
+        audio_write = playing;
+        ahead = 0;
+    }
+    uint32_t frames = AUDIO_LEAD_FRAMES - ahead;
+    if (frames == 0) return;
+
+    audio_callback(audio_mix, frames);
+    for (uint32_t i = 0; i < frames; ++i) {
+        uint32_t at = (audio_write + i) & (AUDIO_RING_FRAMES - 1);
+        audio_rings[0][at] = audio_mix[i * 2];
+        audio_rings[1][at] = audio_mix[i * 2 + 1];
+    }
+    flush_ring_range(audio_write, frames);
+    audio_write = (audio_write + frames) & (AUDIO_RING_FRAMES - 1);
+}
+
+bool platform_audio_open(int rate, PlatformAudioCallback callback) {
+    for (int channel = 0; channel < 2; ++channel) {
+        AXVoice* voice = AXAcquireVoice(31, nullptr, nullptr);
+        if (!voice) {
+            LOG_ERROR(LOG_CAT_PLATFORM, "No AX voice free for audio output");
+            platform_audio_close();
+            return false;
+        }
+        audio_voices[channel] = voice;
+
+        AXVoiceBegin(voice);
+        AXSetVoiceType(voice, 0);
+
+        AXVoiceVeData volume = { 0x8000, 0 };
+        AXSetVoiceVe(voice, &volume);
+
+        // Left voice to the left speaker, right to the right, on the TV and the GamePad
+        AXVoiceDeviceMixData mix[6] = {};
+        mix[channel].bus[0].volume = 0x8000;
+        AXSetVoiceDeviceMix(voice, AX_DEVICE_TYPE_TV, 0, mix);
+        AXSetVoiceDeviceMix(voice, AX_DEVICE_TYPE_DRC, 0, mix);
+
+        uint32_t renderer_rate = AXGetInputSamplesPerSec();
+        AXSetVoiceSrcType(voice, (uint32_t)rate == renderer_rate ? AX_VOICE_SRC_TYPE_NONE : AX_VOICE_SRC_TYPE_LINEAR);
+        AXSetVoiceSrcRatio(voice, (float)rate / renderer_rate);
+
+        memset(audio_rings[channel], 0, sizeof(audio_rings[channel]));
+        DCFlushRange(audio_rings[channel], sizeof(audio_rings[channel]));
+
+        AXVoiceOffsets offsets = {};
+        offsets.dataType = AX_VOICE_FORMAT_LPCM16;
+        offsets.loopingEnabled = AX_VOICE_LOOP_ENABLED;
+        offsets.loopOffset = 0;
+        offsets.endOffset = AUDIO_RING_FRAMES - 1;
+        offsets.currentOffset = 0;
+        offsets.data = audio_rings[channel];
+        AXSetVoiceOffsets(voice, &offsets);
+        AXVoiceEnd(voice);
+    }
+
+    audio_callback = callback;
+    audio_write = 0;
+    AXRegisterAppFrameCallback(audio_frame_callback);
+
+    // Both at once so the channels stay in step
+    for (AXVoice* voice : audio_voices) AXVoiceBegin(voice);
+    for (AXVoice* voice : audio_voices) AXSetVoiceState(voice, AX_VOICE_STATE_PLAYING);
+    for (AXVoice* voice : audio_voices) AXVoiceEnd(voice);
+    return true;
+}
+
+void platform_audio_close() {
+    if (audio_callback) AXDeregisterAppFrameCallback(audio_frame_callback);
+    audio_callback = nullptr;
+
+    for (AXVoice*& voice : audio_voices) {
+        if (!voice) continue;
+        AXVoiceBegin(voice);
+        AXSetVoiceState(voice, AX_VOICE_STATE_STOPPED);
+        AXVoiceEnd(voice);
+        AXFreeVoice(voice);
+        voice = nullptr;
+    }
+}
+
+void platform_read_input(CombinedInput& input, int width, int height) {
+    if (vpadInput.update(width, height)) {
+        input.combine(vpadInput);
+    }
+    for (auto &wpadInput : wpadInputs) {
+        if (wpadInput.update(width, height)) {
+            input.combine(wpadInput);
+        }
+    }
+}
+
+static PlatformExtension extension_of(WPADExtensionType type) {
+    switch (type) {
+        case WPAD_EXT_CORE:
+        case WPAD_EXT_MPLUS:
+            return EXTENSION_NONE;
+        case WPAD_EXT_NUNCHUK:
+        case WPAD_EXT_MPLUS_NUNCHUK:
+            return EXTENSION_NUNCHUK;
+        case WPAD_EXT_CLASSIC:
+        case WPAD_EXT_MPLUS_CLASSIC:
+            return EXTENSION_CLASSIC;
+        case WPAD_EXT_PRO_CONTROLLER:
+            return EXTENSION_PRO;
+        default:
+            return EXTENSION_OTHER;
+    }
+}
+
+void platform_controller_status(int slot, PlatformControllerStatus& out) {
+    out = PlatformControllerStatus();
+    if (slot == 0) {
+        // VPADRead already brings the battery level with the buttons
+        out.connected = true;
+        out.battery = vpadInput.data.battery;
+        return;
+    }
+
+    WPADChan chan = (WPADChan)(slot - 1);
+    WPADExtensionType type;
+    out.connected = WPADProbe(chan, &type) == 0;
+    wpadInputs[slot - 1].setConnected(out.connected);
+    if (!out.connected) return;
+
+    out.battery = WPADGetBatteryLevel(chan);
+    out.extension = extension_of(type);
+}
+
+bool platform_controllers_changed() {
+    return controllers_changed.exchange(false, std::memory_order_relaxed);
+}
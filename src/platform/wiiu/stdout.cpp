@@ -2,8 +2,8 @@
  * Automatically glue stdout to WHBLogWrite().
  */
 
-#include <string>
-#include <thread>
+#include <algorithm>
+#include <cstring>
 
 #include <sys/iosupport.h>      // devoptab_list, devoptab_t
 
@@ -12,6 +12,8 @@
 #include <whb/log_module.h>
 #include <whb/log_udp.h>
 
+#include "platform/platform.hpp"
+
 
 namespace {
 
@@ -56,20 +58,27 @@ namespace {
                          const char* buf,
                          size_t len)
         noexcept {
-        try {
-            /*static std::mutex mutex;
-            std::lock_guard guard{mutex};*/
-            std::string msg(buf, len);
-            WHBLogWrite(msg.data());
-            return len;
-        }
-        catch (...) {
-            return -1;
+        // WHBLogWrite wants a terminated string, copy through the stack
+        // rather than allocating one per write
+        char chunk[256];
+        for (size_t done = 0; done < len;) {
+            size_t size = std::min(len - done, sizeof(chunk) - 1);
+            memcpy(chunk, buf + done, size);
+            chunk[size] = '\0';
+            WHBLogWrite(chunk);
+            done += size;
         }
+        return len;
     }
 
 } // namespace
 
+// Log lines from log.hpp go to the same module, cafe or UDP log
+void
+platform_log_write(const char* line) {
+    WHBLogWrite(line);
+}
+
 __attribute__(( __constructor__ ))
 void
 init_stdout() {
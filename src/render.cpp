@@ -1,4 +1,6 @@
 #include <SDL_ttf.h>
+#include <algorithm>
+#include <vector>
 
 #include "render.hpp"
 
@@ -29,17 +31,69 @@ void render_circle(SDL_Renderer *renderer, int32_t centreX, int32_t centreY, int
     }
 }
 
-void render_icon_with_background(SDL_Renderer* renderer, SDL_Texture* icon, int x, int y, int box_size) {
-    if (!icon) return;
+SDL_Surface* render_scale_surface(SDL_Surface* surface, float scale) {
+    SDL_Surface* source = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0);
+    if (!source) return nullptr;
+
+    int width = (int)(source->w * scale + 0.5f);
+    int height = (int)(source->h * scale + 0.5f);
+    SDL_Surface* scaled = width > 0 && height > 0 ? SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_RGBA32) : nullptr;
+    if (!scaled) {
+        SDL_FreeSurface(source);
+        return nullptr;
+    }
+
+    // Where each output column samples the source, with weights in 1/256ths
+    struct Tap {
+        int x0, x1;
+        int fx;
+    };
+    std::vector<Tap> columns(width);
+    for (int x = 0; x < width; ++x) {
+        float sx = std::min(std::max((x + 0.5f) / scale - 0.5f, 0.0f), (float)(source->w - 1));
+        columns[x] = { (int)sx * 4, std::min((int)sx + 1, source->w - 1) * 4, (int)((sx - (int)sx) * 256) };
+    }
+
+    for (int y = 0; y < height; ++y) {
+        // Pixel centres of the output mapped onto the source's
+        float sy = std::min(std::max((y + 0.5f) / scale - 0.5f, 0.0f), (float)(source->h - 1));
+        int y0 = (int)sy;
+        int fy = (int)((sy - y0) * 256);
+        const uint8_t* row0 = (const uint8_t*)source->pixels + y0 * source->pitch;
+        const uint8_t* row1 = (const uint8_t*)source->pixels + std::min(y0 + 1, source->h - 1) * source->pitch;
+        uint8_t* out = (uint8_t*)scaled->pixels + y * scaled->pitch;
+
+        for (int x = 0; x < width; ++x) {
+            const Tap& tap = columns[x];
+            const uint8_t* taps[4] = { row0 + tap.x0, row0 + tap.x1, row1 + tap.x0, row1 + tap.x1 };
+            const int weights[4] = { (256 - tap.fx) * (256 - fy), tap.fx * (256 - fy), (256 - tap.fx) * fy, tap.fx * fy };
+
+            uint64_t rgb[3] = {}, alpha = 0;
+            for (int t = 0; t < 4; ++t) {
+                uint64_t weight = (uint64_t)weights[t] * taps[t][3];
+                for (int c = 0; c < 3; ++c) rgb[c] += taps[t][c] * weight;
+                alpha += weight;
+            }
+            for (int c = 0; c < 3; ++c) out[x * 4 + c] = alpha ? (uint8_t)((rgb[c] + alpha / 2) / alpha) : 0;
+            out[x * 4 + 3] = (uint8_t)((alpha + (1 << 15)) >> 16);
+        }
+    }
+
+    SDL_FreeSurface(source);
+    return scaled;
+}
+
+bool render_icon_background_color(SDL_Renderer* renderer, SDL_Texture* icon, SDL_Color& out) {
+    if (!icon) return false;
 
     int tex_w, tex_h;
     if (SDL_QueryTexture(icon, nullptr, nullptr, &tex_w, &tex_h) != 0 || tex_w == 0 || tex_h == 0)
-        return;
+        return false;
 
     // Create a surface to read one pixel from the original texture safely
     SDL_Surface* icon_surface = nullptr; {
         SDL_Texture* tmp = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, tex_w, tex_h);
-        if (!tmp) return;
+        if (!tmp) return false;
 
         SDL_SetRenderTarget(renderer, tmp);
         SDL_RenderCopy(renderer, icon, nullptr, nullptr);
@@ -48,14 +102,14 @@ void render_icon_with_background(SDL_Renderer* renderer, SDL_Texture* icon, int
         if (!icon_surface) {
             SDL_DestroyTexture(tmp);
             SDL_SetRenderTarget(renderer, nullptr);
-            return;
+            return false;
         }
 
         if (SDL_RenderReadPixels(renderer, nullptr, icon_surface->format->format, icon_surface->pixels, icon_surface->pitch) != 0) {
             SDL_FreeSurface(icon_surface);
             SDL_DestroyTexture(tmp);
             SDL_SetRenderTarget(renderer, nullptr);
-            return;
+            return false;
         }
 
         SDL_DestroyTexture(tmp);
@@ -63,26 +117,32 @@ void render_icon_with_background(SDL_Renderer* renderer, SDL_Texture* icon, int
     }
 
     Uint32 first_pixel = ((Uint32*)icon_surface->pixels)[0];
-    Uint8 r, g, b, a;
-    SDL_GetRGBA(first_pixel, icon_surface->format, &r, &g, &b, &a);
+    SDL_GetRGBA(first_pixel, icon_surface->format, &out.r, &out.g, &out.b, &out.a);
+    out.a = 255;
     SDL_FreeSurface(icon_surface);
+    return true;
+}
 
-    // Fill background
-    SDL_Rect box_rect = { x, y, box_size, box_size };
-    SDL_SetRenderDrawColor(renderer, r, g, b, 255);
-    SDL_RenderFillRect(renderer, &box_rect);
+SDL_Rect render_icon_fit(SDL_Texture* icon, const SDL_Rect& box) {
+    int tex_w = 0, tex_h = 0;
+    if (!icon || SDL_QueryTexture(icon, nullptr, nullptr, &tex_w, &tex_h) != 0 || tex_w == 0 || tex_h == 0)
+        return box;
 
     // Aspect-ratio scale the icon to fit vertically
     float aspect_ratio = (float)tex_h / tex_w;
-    int new_height = static_cast<int>(box_size * aspect_ratio);
-    if (new_height > box_size) new_height = box_size;
+    int new_height = static_cast<int>(box.w * aspect_ratio);
+    if (new_height > box.h) new_height = box.h;
 
-    SDL_Rect dst_rect = {
-        x,
-        y + (box_size - new_height) / 2,
-        box_size,
+    return {
+        box.x,
+        box.y + (box.h - new_height) / 2,
+        box.w,
         new_height
     };
+}
 
-    SDL_RenderCopy(renderer, icon, nullptr, &dst_rect);
+void render_icon_with_background(SDL_Renderer* renderer, SDL_Texture* icon, SDL_Color background, const SDL_Rect& box, const SDL_Rect& icon_rect) {
+    SDL_SetRenderDrawColor(renderer, background.r, background.g, background.b, background.a);
+    SDL_RenderFillRect(renderer, &box);
+    SDL_RenderCopy(renderer, icon, nullptr, &icon_rect);
 }
@@ -17,4 +17,16 @@ const RenderColor COLOR_BLUE = {60, 170, 230, SDL_ALPHA_OPAQUE};
 void render_set_color(SDL_Renderer *renderer, RenderColor color);
 void render_rectangle(SDL_Renderer *renderer, int xx, int yy, int ww, int hh, bool filled);
 void render_circle(SDL_Renderer *renderer, int32_t centreX, int32_t centreY, int32_t radius, bool fill);
-void render_icon_with_background(SDL_Renderer* renderer, SDL_Texture* icon, int x, int y, int box_size);
+
+// A copy of surface scaled by scale, filtered bilinearly with the colour
+// weighted by alpha so transparent edges don't darken. For artwork scaled
+// once when it's loaded instead of by the GPU on every draw. nullptr on failure.
+SDL_Surface* render_scale_surface(SDL_Surface* surface, float scale);
+
+// Reads the icon's top-left pixel back from the GPU, slow, call once per icon
+bool render_icon_background_color(SDL_Renderer* renderer, SDL_Texture* icon, SDL_Color& out);
+
+// Where the icon goes inside box, scaled to its width keeping the aspect ratio and centred vertically
+SDL_Rect render_icon_fit(SDL_Texture* icon, const SDL_Rect& box);
+
+void render_icon_with_background(SDL_Renderer* renderer, SDL_Texture* icon, SDL_Color background, const SDL_Rect& box, const SDL_Rect& icon_rect);
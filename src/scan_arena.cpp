@@ -0,0 +1,42 @@
+#include <algorithm>
+#include <cstdint>
+
+#include "scan_arena.hpp"
+
+ScanArena::Stats last_scan_arena_stats;
+
+ScanArena::ScanArena(void* buffer, size_t size)
+    : initial_buffer((char*)buffer), initial_size(size), current((char*)buffer), current_size(size) {
+}
+
+ScanArena::~ScanArena() {
+    release();
+}
+
+void ScanArena::release() {
+    for (char* block : overflow) delete[] block;
+    overflow.clear();
+    current = initial_buffer;
+    current_size = initial_size;
+    used = 0;
+}
+
+void* ScanArena::do_allocate(size_t bytes, size_t alignment) {
+    uintptr_t base = (uintptr_t)current;
+    size_t offset = ((base + used + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base;
+
+    if (offset + bytes > current_size) {
+        current_size = std::max(OVERFLOW_BLOCK_SIZE, bytes + alignment);
+        current = new char[current_size];
+        overflow.push_back(current);
+        counters.overflow_blocks++;
+
+        base = (uintptr_t)current;
+        offset = ((base + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base;
+    }
+
+    used = offset + bytes;
+    counters.allocations++;
+    counters.peak_bytes += bytes;
+    return current + offset;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+// Bump allocator for the temporaries of one library scan. Deallocation is a
+// no-op and everything is released at once when the arena goes away, so the
+// scan's paths, names and sets never reach the general heap unless the
+// buffer it starts with runs out. frame_arena.hpp reuses it for each frame.
+class ScanArena : public std::pmr::memory_resource {
+public:
+    struct Stats {
+        size_t allocations = 0;
+        size_t peak_bytes = 0;      // bytes handed out, nothing is given back before the end
+        size_t overflow_blocks = 0; // heap blocks taken once the initial buffer was full
+    };
+
+    ScanArena(void* buffer, size_t size);
+    ~ScanArena();
+
+    void release();
+
+    const Stats& stats() const { return counters; }
+
+private:
+    static constexpr size_t OVERFLOW_BLOCK_SIZE = 16 * 1024;
+
+    char* initial_buffer;
+    size_t initial_size;
+
+    char* current;
+    size_t current_size;
+    size_t used = 0;
+
+    std::vector<char*> overflow;
+    Stats counters;
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void*, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
+
+// Stats of the last scan_apps(), for the log and the benchmark
+extern ScanArena::Stats last_scan_arena_stats;
+
+// Concatenates parts into a string allocated from resource. operator+ would
+// give the result the default resource instead.
+template<typename... Parts>
+std::pmr::string concat(std::pmr::memory_resource* resource, const Parts&... parts) {
+    std::pmr::string out(resource);
+    (out.append(parts), ...);
+    return out;
+}
@@ -0,0 +1,211 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <dirent.h>
+#include <iterator>
+#include <mutex>
+#include <sys/stat.h>
+#include <thread>
+
+#include "log.hpp"
+#include "sd_watch.hpp"
+#include "title_extractor.hpp"
+#include "trace.hpp"
+
+namespace {
+    // Slow enough that the stats don't show up next to the SD's other traffic
+    constexpr Uint32 CHECK_INTERVAL_MS = 5000;
+
+    constexpr const char* CUSTOM_ICONS_DIR = SD_CARD_PATH "switchU/custom_icons";
+    constexpr const char* IGNORE_PATH = SD_CARD_PATH "switchU/ignore.txt";
+    constexpr const char* ASSETS_DIR = SD_CARD_PATH "switchU/assets";
+    constexpr int ASSETS_MAX_DEPTH = 2;     // assets/battery/, assets/buttons/
+
+    struct FileStamp {
+        std::string name;
+        int64_t size;
+        int64_t mtime;
+
+        bool operator==(const FileStamp& other) const {
+            return name == other.name && size == other.size && mtime == other.mtime;
+        }
+        bool operator<(const FileStamp& other) const { return name < other.name; }
+    };
+
+    struct SdState {
+        std::vector<FileStamp> custom_icons;    // by folder
+        std::vector<FileStamp> assets;          // by path under assets/
+        FileStamp ignore_file = { "", -1, 0 };  // size -1 while there is none
+        std::vector<std::string> ignored;       // sorted
+    };
+
+    // One worker for the whole session, sleeping between checks until the
+    // timer runs out or sd_watch_request() wakes it
+    std::thread watcher;
+    std::mutex watch_mutex;
+    std::condition_variable watch_wake;
+    bool check_requested = false;
+    bool stopping = false;
+
+    // What checks found that sd_watch_poll() hasn't taken yet, under watch_mutex.
+    // The flag lets the main thread skip the lock on the frames nothing did.
+    SdChanges found;
+    std::atomic<bool> found_ready{false};
+
+    // Only the worker touches these
+    SdState state;
+    bool have_state = false;
+
+    bool stamp(const std::string& path, const std::string& name, FileStamp& out) {
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) return false;
+        out = { name, (int64_t)st.st_size, (int64_t)st.st_mtime };
+        return true;
+    }
+
+    void stamp_custom_icons(std::vector<FileStamp>& out) {
+        DIR* dir = opendir(CUSTOM_ICONS_DIR);
+        if (!dir) return;
+
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != nullptr) {
+            if (entry->d_name[0] == '.') continue;
+            FileStamp icon;
+            if (stamp(std::string(CUSTOM_ICONS_DIR) + "/" + entry->d_name + "/icon.png", entry->d_name, icon)) out.push_back(icon);
+        }
+        closedir(dir);
+        std::sort(out.begin(), out.end());
+    }
+
+    void stamp_assets(const std::string& dir_path, const std::string& prefix, int depth, std::vector<FileStamp>& out) {
+        DIR* dir = opendir(dir_path.c_str());
+        if (!dir) return;
+
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != nullptr) {
+            if (entry->d_name[0] == '.') continue;
+            std::string path = dir_path + "/" + entry->d_name;
+            std::string name = prefix + entry->d_name;
+
+            struct stat st;
+            if (stat(path.c_str(), &st) != 0) continue;
+            if (S_ISDIR(st.st_mode)) {
+                if (depth < ASSETS_MAX_DEPTH) stamp_assets(path, name + "/", depth + 1, out);
+            } else {
+                out.push_back({ name, (int64_t)st.st_size, (int64_t)st.st_mtime });
+            }
+        }
+        closedir(dir);
+    }
+
+    std::vector<std::string> read_ignored() {
+        IgnoreList list = load_ignored_apps(std::pmr::get_default_resource());
+        std::vector<std::string> names;
+        for (const auto& name : list) names.emplace_back(name);
+        std::sort(names.begin(), names.end());
+        return names;
+    }
+
+    // Names added to, removed from or changed between two sorted stamp lists
+    void changed_names(const std::vector<FileStamp>& before, const std::vector<FileStamp>& after, std::vector<std::string>& out) {
+        auto b = before.begin(), a = after.begin();
+        while (b != before.end() || a != after.end()) {
+            if (a == after.end() || (b != before.end() && b->name < a->name)) {
+                out.push_back((b++)->name);
+            } else if (b == before.end() || a->name < b->name) {
+                out.push_back((a++)->name);
+            } else {
+                if (!(*b == *a)) out.push_back(a->name);
+                ++a;
+                ++b;
+            }
+        }
+    }
+
+    template <typename T>
+    void append(std::vector<T>& to, std::vector<T>& from) {
+        std::move(from.begin(), from.end(), std::back_inserter(to));
+    }
+
+    void check(SdChanges& changes) {
+        TRACE_SCOPE("sd_watch_check");
+        SdState next;
+        stamp_custom_icons(next.custom_icons);
+        stamp_assets(ASSETS_DIR, "", 0, next.assets);
+        std::sort(next.assets.begin(), next.assets.end());
+
+        // ignore.txt itself is only read when it changed
+        stamp(IGNORE_PATH, "", next.ignore_file);
+        bool ignore_changed = !have_state || !(next.ignore_file == state.ignore_file);
+        next.ignored = ignore_changed ? read_ignored() : state.ignored;
+
+        if (have_state) {
+            changed_names(state.custom_icons, next.custom_icons, changes.custom_icons);
+            changed_names(state.assets, next.assets, changes.assets);
+            if (ignore_changed) {
+                std::set_difference(next.ignored.begin(), next.ignored.end(), state.ignored.begin(), state.ignored.end(),
+                                    std::back_inserter(changes.ignored));
+                std::set_difference(state.ignored.begin(), state.ignored.end(), next.ignored.begin(), next.ignored.end(),
+                                    std::back_inserter(changes.unignored));
+            }
+        }
+        state = std::move(next);
+        have_state = true;
+    }
+
+    void watch_loop() {
+        TRACE_THREAD_NAME("sd_watch");
+        std::unique_lock<std::mutex> lock(watch_mutex);
+        while (!stopping) {
+            check_requested = false;
+            lock.unlock();
+            SdChanges changes;
+            check(changes);
+            lock.lock();
+
+            // Appended, a poll may not have taken the last check's yet
+            if (!changes.empty()) {
+                append(found.custom_icons, changes.custom_icons);
+                append(found.ignored, changes.ignored);
+                append(found.unignored, changes.unignored);
+                append(found.assets, changes.assets);
+                found_ready.store(true, std::memory_order_release);
+            }
+
+            watch_wake.wait_for(lock, std::chrono::milliseconds(CHECK_INTERVAL_MS), [] { return check_requested || stopping; });
+        }
+    }
+}
+
+void sd_watch_start() {
+    if (watcher.joinable()) return;
+    watcher = std::thread(watch_loop);
+}
+
+void sd_watch_request() {
+    std::lock_guard<std::mutex> lock(watch_mutex);
+    check_requested = true;
+    watch_wake.notify_one();
+}
+
+bool sd_watch_poll(SdChanges& out) {
+    if (!found_ready.load(std::memory_order_acquire)) return false;
+
+    std::lock_guard<std::mutex> lock(watch_mutex);
+    found_ready.store(false);
+    LOG_INFO(LOG_CAT_MAIN, "SD changes: %zu custom icons, %zu ignored, %zu unignored, %zu assets",
+             found.custom_icons.size(), found.ignored.size(), found.unignored.size(), found.assets.size());
+    out = std::move(found);
+    found = SdChanges();
+    return true;
+}
+
+void sd_watch_shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(watch_mutex);
+        stopping = true;
+    }
+    watch_wake.notify_one();
+    if (watcher.joinable()) watcher.join();
+}
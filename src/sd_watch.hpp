@@ -0,0 +1,37 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <string>
+#include <vector>
+
+// Notices the edits people make to the launcher's SD folder by hand: an icon
+// dropped into custom_icons/, a line added to ignore.txt, a file swapped in
+// assets/. A check only stats those files (names, sizes and mtimes) on a
+// background thread, every few seconds and right after coming back to the
+// foreground, and reports what changed so each change can be applied on its
+// own instead of rescanning the library. The thread lives from
+// sd_watch_start() to sd_watch_shutdown() and sleeps between checks.
+
+struct SdChanges {
+    std::vector<std::string> custom_icons;  // folders in custom_icons/ whose icon.png appeared, changed or went away
+    std::vector<std::string> ignored;       // names ignore.txt lists that it didn't before
+    std::vector<std::string> unignored;     // names it stopped listing
+    std::vector<std::string> assets;        // files under assets/ that changed, e.g. "battery/battery_full.png"
+
+    bool empty() const {
+        return custom_icons.empty() && ignored.empty() && unignored.empty() && assets.empty();
+    }
+};
+
+// Starts the thread, its first check records the state later ones compare against
+void sd_watch_start();
+
+// Wakes the thread for a check now instead of waiting for the timer
+void sd_watch_request();
+
+// Once per frame. Returns true when a finished check found changes, which are
+// moved into out. Doesn't allocate or lock on the frames there are none.
+bool sd_watch_poll(SdChanges& out);
+
+// Stops the thread, waiting for a check that is still running
+void sd_watch_shutdown();
@@ -0,0 +1,254 @@
+#include <SDL2/SDL_image.h>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "log.hpp"
+#include "snapshot.hpp"
+#include "title_extractor.hpp"
+#include "trace.hpp"
+
+namespace {
+    const char SNAPSHOT_MAGIC[4] = { 'S', 'U', 'S', 'S' };
+    constexpr uint32_t SNAPSHOT_VERSION = 2;
+
+    // Written after the magic, everything before the entries
+    struct SnapshotHeader {
+        uint32_t version;
+        uint32_t entry_count;
+        uint64_t fingerprint;
+        NavigationState nav;
+    };
+
+    struct SnapshotEntry {
+        uint64_t titleid;
+        SDL_Color background;
+        uint8_t device;
+        uint16_t title_length;
+        uint16_t app_path_length;
+        uint16_t icon_path_length;
+    };
+
+    uint64_t restored_fingerprint = 0;
+    bool restored_homebrew_titles = false;
+
+    // library_fingerprint() runs on one long-lived worker, woken by each
+    // snapshot_fingerprint(). The last one it finished is what the library
+    // was built from, until the next request.
+    std::thread fingerprint_worker;
+    std::mutex fingerprint_mutex;
+    std::condition_variable fingerprint_wake;
+    bool fingerprint_requested = false;
+    bool fingerprint_stopping = false;
+    bool requested_homebrew_titles = false;
+    bool fingerprint_valid = false;
+    bool fingerprint_homebrew_titles = false;
+    uint64_t fingerprint = 0;
+    bool revalidating = false;          // compare the next one with the restored snapshot's
+
+    void fingerprint_loop() {
+        TRACE_THREAD_NAME("fingerprint");
+        std::unique_lock<std::mutex> lock(fingerprint_mutex);
+        while (true) {
+            fingerprint_wake.wait(lock, [] { return fingerprint_requested || fingerprint_stopping; });
+            if (fingerprint_stopping) return;
+            fingerprint_requested = false;
+            bool homebrew_titles = requested_homebrew_titles;
+
+            lock.unlock();
+            uint64_t value;
+            {
+                TRACE_SCOPE("library_fingerprint");
+                value = library_fingerprint(homebrew_titles);
+            }
+            lock.lock();
+
+            // A request that came in meanwhile is for a newer library
+            if (fingerprint_requested) continue;
+            fingerprint = value;
+            fingerprint_homebrew_titles = homebrew_titles;
+            fingerprint_valid = true;
+        }
+    }
+
+    bool read_string(FILE* file, uint16_t length, std::string& out) {
+        out.resize(length);
+        return length == 0 || fread(&out[0], 1, length, file) == length;
+    }
+}
+
+bool snapshot_write(const char* path, const NavigationState& nav) {
+    TRACE_FUNCTION();
+
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        LOG_ERROR(LOG_CAT_MAIN, "Failed to open %s for writing", path);
+        return false;
+    }
+
+    SnapshotHeader header = {};
+    header.version = SNAPSHOT_VERSION;
+    header.entry_count = library.size();
+    {
+        // Worked out in the background, 0 never matches and the next return rescans
+        std::lock_guard<std::mutex> lock(fingerprint_mutex);
+        bool current = fingerprint_valid && fingerprint_homebrew_titles == (nav.load_homebrew_titles != 0);
+        header.fingerprint = current ? fingerprint : 0;
+    }
+    if (header.fingerprint == 0) LOG_INFO(LOG_CAT_MAIN, "Library fingerprint not ready, the snapshot will be rescanned");
+    header.nav = nav;
+
+    fwrite(SNAPSHOT_MAGIC, 1, sizeof(SNAPSHOT_MAGIC), file);
+    fwrite(&header, sizeof(header), 1, file);
+
+    for (size_t i = 0; i < library.size(); ++i) {
+        const char* title = library.cold.title[i];
+        const char* app_path = library.cold.app_path[i];
+        const char* icon_path = library.cold.icon_path[i];
+
+        SnapshotEntry entry = {};
+        entry.titleid = library.cold.titleid[i];
+        entry.background = library.hot.background[i];
+        entry.device = library.cold.device[i];
+        entry.title_length = strlen(title);
+        entry.app_path_length = strlen(app_path);
+        entry.icon_path_length = strlen(icon_path);
+
+        fwrite(&entry, sizeof(entry), 1, file);
+        fwrite(title, 1, entry.title_length, file);
+        fwrite(app_path, 1, entry.app_path_length, file);
+        fwrite(icon_path, 1, entry.icon_path_length, file);
+    }
+
+    bool ok = !ferror(file);
+    fclose(file);
+    if (!ok) {
+        LOG_ERROR(LOG_CAT_MAIN, "Failed to write %s", path);
+        remove(path);
+        return false;
+    }
+
+    LOG_INFO(LOG_CAT_MAIN, "Saved snapshot of %u apps", (unsigned)library.size());
+    return true;
+}
+
+bool snapshot_restore(const char* path, NavigationState& nav) {
+    TRACE_FUNCTION();
+
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+
+    char magic[sizeof(SNAPSHOT_MAGIC)];
+    SnapshotHeader header;
+    bool ok = fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+              memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) == 0 &&
+              fread(&header, sizeof(header), 1, file) == 1 &&
+              header.version == SNAPSHOT_VERSION;
+
+    library_clear();
+
+    std::string title, app_path, icon_path;
+    for (uint32_t i = 0; ok && i < header.entry_count; ++i) {
+        SnapshotEntry entry;
+        ok = fread(&entry, sizeof(entry), 1, file) == 1 &&
+             entry.device <= DEVICE_ODD &&
+             read_string(file, entry.title_length, title) &&
+             read_string(file, entry.app_path_length, app_path) &&
+             read_string(file, entry.icon_path_length, icon_path);
+        if (!ok) break;
+
+        library_add_entry(nullptr, entry.background, library_strings.intern(icon_path), library_strings.intern(title),
+                          library_strings.intern(app_path), (StorageDevice)entry.device, entry.titleid);
+    }
+
+    fclose(file);
+    remove(path);
+
+    if (!ok) {
+        LOG_WARN(LOG_CAT_MAIN, "Ignoring unreadable snapshot %s", path);
+        library_clear();
+        return false;
+    }
+
+    nav = header.nav;
+    restored_fingerprint = header.fingerprint;
+    restored_homebrew_titles = header.nav.load_homebrew_titles;
+    LOG_INFO(LOG_CAT_MAIN, "Restored snapshot of %u apps", (unsigned)library.size());
+    return true;
+}
+
+bool snapshot_pending(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+    fclose(file);
+    return true;
+}
+
+bool snapshot_write_frame(const char* path, SDL_Renderer* renderer) {
+    TRACE_FUNCTION();
+
+    int width, height;
+    if (SDL_GetRendererOutputSize(renderer, &width, &height) != 0) return false;
+
+    SDL_Surface* frame = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_RGBA32);
+    SDL_Surface* small = SDL_CreateRGBSurfaceWithFormat(0, width / 2, height / 2, 32, SDL_PIXELFORMAT_RGBA32);
+    bool ok = frame && small &&
+              SDL_RenderReadPixels(renderer, nullptr, SDL_PIXELFORMAT_RGBA32, frame->pixels, frame->pitch) == 0 &&
+              SDL_BlitScaled(frame, nullptr, small, nullptr) == 0 &&
+              IMG_SavePNG(small, path) == 0;
+
+    if (!ok) LOG_WARN(LOG_CAT_MAIN, "Failed to save the last frame: %s", SDL_GetError());
+    SDL_FreeSurface(frame);
+    SDL_FreeSurface(small);
+    return ok;
+}
+
+bool snapshot_draw_frame(const char* path, SDL_Renderer* renderer) {
+    TRACE_FUNCTION();
+
+    SDL_Texture* frame = load_texture(path, renderer);
+    if (!frame) return false;
+
+    SDL_RenderCopy(renderer, frame, nullptr, nullptr);
+    SDL_DestroyTexture(frame);
+    return true;
+}
+
+void snapshot_fingerprint(bool homebrew_titles) {
+    std::lock_guard<std::mutex> lock(fingerprint_mutex);
+    fingerprint_requested = true;
+    requested_homebrew_titles = homebrew_titles;
+    fingerprint_valid = false;
+    if (!fingerprint_worker.joinable()) fingerprint_worker = std::thread(fingerprint_loop);
+    fingerprint_wake.notify_one();
+}
+
+void snapshot_revalidate() {
+    snapshot_fingerprint(restored_homebrew_titles);
+    std::lock_guard<std::mutex> lock(fingerprint_mutex);
+    revalidating = true;
+}
+
+bool snapshot_poll_stale() {
+    std::lock_guard<std::mutex> lock(fingerprint_mutex);
+    if (!revalidating || !fingerprint_valid) return false;
+
+    revalidating = false;
+    bool stale = fingerprint != restored_fingerprint || fingerprint_homebrew_titles != restored_homebrew_titles;
+    // Until the rescan is in, the library isn't what this fingerprint describes
+    if (stale) fingerprint_valid = false;
+    LOG_INFO(LOG_CAT_MAIN, "Snapshot revalidated, library %s", stale ? "changed, rescanning" : "unchanged");
+    return stale;
+}
+
+void snapshot_shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(fingerprint_mutex);
+        fingerprint_stopping = true;
+    }
+    fingerprint_wake.notify_one();
+    if (fingerprint_worker.joinable()) fingerprint_worker.join();
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <cstdint>
+
+#include "platform/platform.hpp"
+
+// Launcher state saved just before handing over to a title, so coming back
+// from it lands where the user left instead of cold booting: navigation, the
+// library in its resolved order with where each icon came from, and a
+// fingerprint of what the library was built from (see library_fingerprint).
+// The file is native endian, it is only ever read back on the same machine.
+
+#define SNAPSHOT_PATH SD_CARD_PATH "switchU/snapshot.bin"
+// The last frame drawn before launching, shown while starting back up
+#define SNAPSHOT_FRAME_PATH SD_CARD_PATH "switchU/snapshot_frame.png"
+
+struct NavigationState {
+    int32_t menu;
+    int32_t row;
+    int32_t tile;
+    int32_t subrow;
+    int32_t camera_offset_x;
+    int32_t load_homebrew_titles;
+    int32_t apps_sort;          // All Software's sort mode and selected entry
+    int32_t apps_entry;
+};
+
+// Writes the current library and nav to path
+bool snapshot_write(const char* path, const NavigationState& nav);
+
+// Rebuilds the library from the snapshot at path and fills nav, then deletes
+// the file so only the next return from a title restores it. Entries come
+// back without icons, load them with library_load_icons(). Returns false
+// if there is no usable snapshot, the library is left empty then.
+bool snapshot_restore(const char* path, NavigationState& nav);
+
+// True if a snapshot is waiting to be restored
+bool snapshot_pending(const char* path);
+
+// Saves what the renderer currently holds, at half size, for
+// snapshot_draw_frame(). Call after drawing a frame and before presenting it.
+bool snapshot_write_frame(const char* path, SDL_Renderer* renderer);
+// Stretches the saved frame over the whole target, false if there is none
+bool snapshot_draw_frame(const char* path, SDL_Renderer* renderer);
+
+// Works out library_fingerprint() on a background thread for the next
+// snapshot_write(). Call whenever the library was rebuilt or changed.
+void snapshot_fingerprint(bool homebrew_titles);
+
+// Checks the restored library against the SD card and title list on the same
+// thread. snapshot_poll_stale() returns true once, when that check found the
+// library out of date and it should be scanned again.
+void snapshot_revalidate();
+bool snapshot_poll_stale();
+
+// Stops the fingerprint thread, waiting for one still running
+void snapshot_shutdown();
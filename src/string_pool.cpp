@@ -0,0 +1,42 @@
+#include <cstring>
+
+#include "string_pool.hpp"
+
+StringPool::~StringPool() {
+    clear();
+}
+
+const char* StringPool::intern(std::string_view str) {
+    auto it = strings.find(str);
+    if (it != strings.end()) return it->data();
+
+    size_t size = str.size() + 1;
+    char* copy;
+    if (size > BLOCK_SIZE / 4) {
+        copy = new char[size];
+        oversized.push_back(copy);
+        oversized_bytes += size;
+    } else {
+        if (block_used + size > BLOCK_SIZE) {
+            blocks.push_back(new char[BLOCK_SIZE]);
+            block_used = 0;
+        }
+        copy = blocks.back() + block_used;
+        block_used += size;
+    }
+
+    memcpy(copy, str.data(), str.size());
+    copy[str.size()] = '\0';
+    strings.insert(std::string_view(copy, str.size()));
+    return copy;
+}
+
+void StringPool::clear() {
+    for (char* block : blocks) delete[] block;
+    for (char* str : oversized) delete[] str;
+    blocks.clear();
+    oversized.clear();
+    oversized_bytes = 0;
+    block_used = BLOCK_SIZE;
+    strings.clear();
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+// Keeps one copy of each distinct string in large blocks and hands out
+// pointers to it, valid until clear(). Used for library strings so entries
+// can be compared and passed around without copying.
+class StringPool {
+public:
+    StringPool() = default;
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+    ~StringPool();
+
+    const char* intern(std::string_view str);
+
+    void clear();
+
+    // Bytes held in blocks, used or not
+    size_t capacity() const { return blocks.size() * BLOCK_SIZE + oversized_bytes; }
+
+private:
+    static constexpr size_t BLOCK_SIZE = 4096;
+
+    std::vector<char*> blocks;
+    std::vector<char*> oversized; // strings too long to share a block
+    size_t oversized_bytes = 0;
+    size_t block_used = BLOCK_SIZE;
+    std::unordered_set<std::string_view> strings;
+};
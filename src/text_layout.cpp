@@ -0,0 +1,287 @@
+#include <cstring>
+
+#include "text_layout.hpp"
+
+namespace {
+    const char ELLIPSIS[] = "\xE2\x80\xA6";
+    const char ELLIPSIS_ASCII[] = "...";
+
+    // Scripts written without spaces, a line may break between any two of these
+    bool is_cjk(uint32_t c) {
+        return (c >= 0x2E80 && c <= 0x9FFF) ||  // radicals, kana, CJK symbols and ideographs
+               (c >= 0xAC00 && c <= 0xD7AF) ||  // hangul
+               (c >= 0xF900 && c <= 0xFAFF) ||  // compatibility ideographs
+               (c >= 0xFF00 && c <= 0xFFEF);    // full width forms
+    }
+
+    uint16_t font_for(const FontStack& fonts, uint32_t c) {
+        for (size_t i = 0; i < fonts.size(); ++i) {
+            if (TTF_GlyphIsProvided32(fonts[i], c)) return i;
+        }
+        return 0;
+    }
+
+    struct Glyph {
+        uint32_t start;     // byte offset in the text
+        uint32_t codepoint;
+        uint16_t font;
+    };
+
+    // Words and CJK characters, the pieces lines are filled with
+    struct Unit {
+        size_t start;
+        size_t core_end;    // start of the trailing spaces
+        size_t end;
+        bool forced_break;  // a '\n' follows
+    };
+
+    struct LineRange {
+        size_t start;
+        size_t end;
+    };
+
+    class Layouter {
+    public:
+        Layouter(const FontStack& fonts, TextLayout& out)
+            : lines(out.text.get_allocator()), fonts(fonts), out(out),
+              glyphs(out.text.get_allocator()), units(out.text.get_allocator()), scratch(out.text.get_allocator()) {}
+
+        void decode() {
+            // At most a glyph per byte, growing would leave the old arrays behind in an arena
+            glyphs.reserve(out.text.size());
+            const char* begin = out.text.c_str();
+            const char* p = begin;
+            while (*p) {
+                Glyph glyph;
+                glyph.start = p - begin;
+                glyph.codepoint = utf8_next(p);
+                glyph.font = font_for(fonts, glyph.codepoint);
+                glyphs.push_back(glyph);
+            }
+            content_end = out.text.size();
+        }
+
+        uint32_t byte_at(size_t glyph) const {
+            return glyph < glyphs.size() ? glyphs[glyph].start : content_end;
+        }
+
+        int measure_bytes(uint16_t font, uint32_t start, uint32_t end) {
+            scratch.assign(out.text, start, end - start);
+            int width = 0;
+            TTF_SizeUTF8(fonts[font], scratch.c_str(), &width, nullptr);
+            return width;
+        }
+
+        // Calls piece(font, first, last) for each same font stretch of glyphs [first, last)
+        template <typename F>
+        void for_each_font_run(size_t first, size_t last, F piece) {
+            while (first < last) {
+                size_t run_end = first + 1;
+                while (run_end < last && glyphs[run_end].font == glyphs[first].font) ++run_end;
+                piece(glyphs[first].font, first, run_end);
+                first = run_end;
+            }
+        }
+
+        int measure(size_t first, size_t last) {
+            int width = 0;
+            for_each_font_run(first, last, [&](uint16_t font, size_t a, size_t b) {
+                width += measure_bytes(font, byte_at(a), byte_at(b));
+            });
+            return width;
+        }
+
+        void split_units() {
+            size_t i = 0;
+            const size_t n = glyphs.size();
+            units.reserve(n);
+            while (i < n) {
+                Unit unit;
+                unit.start = i;
+                if (is_cjk(glyphs[i].codepoint)) {
+                    ++i;
+                } else {
+                    while (i < n && glyphs[i].codepoint != ' ' && glyphs[i].codepoint != '\n' && !is_cjk(glyphs[i].codepoint)) ++i;
+                }
+                unit.core_end = i;
+                while (i < n && glyphs[i].codepoint == ' ') ++i;
+                unit.end = i;
+                unit.forced_break = i < n && glyphs[i].codepoint == '\n';
+                if (unit.forced_break) ++i;
+                units.push_back(unit);
+            }
+        }
+
+        void break_lines(int max_width) {
+            bool line_empty = true;
+            LineRange line = { 0, 0 };
+            int line_width = 0;
+
+            for (const Unit& unit : units) {
+                size_t start = unit.start;
+                int core_width = measure(start, unit.core_end);
+
+                if (max_width > 0 && !line_empty && line_width + core_width > max_width) {
+                    lines.push_back(line);
+                    line_empty = true;
+                }
+
+                // Too long for any line, break it between characters
+                if (max_width > 0 && line_empty && core_width > max_width) {
+                    while (true) {
+                        size_t fit = start + 1;
+                        while (fit < unit.core_end && measure(start, fit + 1) <= max_width) ++fit;
+                        if (fit == unit.core_end) break;
+                        lines.push_back({ start, fit });
+                        start = fit;
+                    }
+                    core_width = measure(start, unit.core_end);
+                }
+
+                if (line_empty) {
+                    line.start = start;
+                    line_width = 0;
+                    line_empty = false;
+                }
+                line.end = unit.core_end;
+                line_width += core_width + (unit.end > unit.core_end ? measure(unit.core_end, unit.end) : 0);
+
+                if (unit.forced_break) {
+                    lines.push_back(line);
+                    line_empty = true;
+                }
+            }
+
+            if (!line_empty || lines.empty()) lines.push_back(line);
+        }
+
+        // Keeps max_lines lines and cuts the last one back until it and an
+        // ellipsis fit. The last line first takes in the next one so the cut
+        // lands mid word rather than leaving the line short.
+        void truncate(size_t max_lines, int max_width, TextRun& ellipsis) {
+            LineRange& line = lines[max_lines - 1];
+            const LineRange& next = lines[max_lines];
+            bool forced_break = false;
+            for (size_t i = line.end; i < next.start; ++i) {
+                if (glyphs[i].codepoint == '\n') forced_break = true;
+            }
+            if (!forced_break) line.end = next.end;
+            lines.resize(max_lines);
+
+            const char* mark = ELLIPSIS_ASCII;
+            uint16_t mark_font = 0;
+            for (size_t i = 0; i < fonts.size(); ++i) {
+                if (TTF_GlyphIsProvided32(fonts[i], 0x2026)) {
+                    mark = ELLIPSIS;
+                    mark_font = i;
+                    break;
+                }
+            }
+
+            ellipsis.start = out.text.size();
+            out.text += mark;
+            ellipsis.end = out.text.size();
+            ellipsis.font = mark_font;
+            ellipsis.width = measure_bytes(mark_font, ellipsis.start, ellipsis.end);
+
+            if (max_width > 0) {
+                while (line.end > line.start && measure(line.start, line.end) + ellipsis.width > max_width) --line.end;
+            }
+            while (line.end > line.start && glyphs[line.end - 1].codepoint == ' ') --line.end;
+        }
+
+        void build_runs(const TextRun* ellipsis) {
+            out.lines.reserve(lines.size());
+            for (size_t i = 0; i < lines.size(); ++i) {
+                TextLine line;
+                line.first_run = out.runs.size();
+                line.width = 0;
+                for_each_font_run(lines[i].start, lines[i].end, [&](uint16_t font, size_t a, size_t b) {
+                    TextRun run;
+                    run.start = byte_at(a);
+                    run.end = byte_at(b);
+                    run.font = font;
+                    run.x = line.width;
+                    run.width = measure_bytes(font, run.start, run.end);
+                    line.width += run.width;
+                    out.runs.push_back(run);
+                });
+
+                if (ellipsis && i == lines.size() - 1) {
+                    TextRun run = *ellipsis;
+                    run.x = line.width;
+                    line.width += run.width;
+                    out.runs.push_back(run);
+                }
+
+                line.run_count = out.runs.size() - line.first_run;
+                if (line.width > out.width) out.width = line.width;
+                out.lines.push_back(line);
+            }
+        }
+
+        std::pmr::vector<LineRange> lines;
+
+    private:
+        const FontStack& fonts;
+        TextLayout& out;
+        std::pmr::vector<Glyph> glyphs;
+        std::pmr::vector<Unit> units;
+        std::pmr::string scratch;
+        size_t content_end = 0;
+    };
+}
+
+uint32_t utf8_next(const char*& p) {
+    const unsigned char* s = (const unsigned char*)p;
+    uint32_t c = s[0];
+    int extra = c < 0x80 ? 0 : (c >> 5) == 0x6 ? 1 : (c >> 4) == 0xE ? 2 : (c >> 3) == 0x1E ? 3 : -1;
+    if (extra < 0) {
+        ++p;
+        return 0xFFFD;
+    }
+
+    c &= 0x7F >> extra;
+    for (int i = 1; i <= extra; ++i) {
+        if ((s[i] & 0xC0) != 0x80) {
+            p += i;
+            return 0xFFFD;
+        }
+        c = (c << 6) | (s[i] & 0x3F);
+    }
+    p += extra + 1;
+    return c;
+}
+
+void layout_text(const FontStack& fonts, const char* text, int max_width, int max_lines, TextLayout& out) {
+    // Room for an ellipsis, so adding one doesn't move the text
+    out.text.reserve(strlen(text) + sizeof(ELLIPSIS_ASCII));
+    out.text = text;
+    out.runs.clear();
+    out.lines.clear();
+    out.width = 0;
+    out.height = 0;
+    out.line_skip = 0;
+    out.truncated = false;
+    if (fonts.empty()) return;
+
+    if (max_lines == 1) {
+        for (char& c : out.text) {
+            if (c == '\n') c = ' ';
+        }
+    }
+
+    Layouter layouter(fonts, out);
+    layouter.decode();
+    layouter.split_units();
+    layouter.break_lines(max_width);
+
+    TextRun ellipsis;
+    bool truncated = max_lines > 0 && layouter.lines.size() > (size_t)max_lines;
+    if (truncated) layouter.truncate(max_lines, max_width, ellipsis);
+    layouter.build_runs(truncated ? &ellipsis : nullptr);
+
+    out.truncated = truncated;
+    out.line_skip = TTF_FontLineSkip(fonts[0]);
+    out.height = (out.lines.size() - 1) * out.line_skip + TTF_FontHeight(fonts[0]);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <SDL2/SDL_ttf.h>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+// Width constrained text layout over SDL_ttf (which shapes with harfbuzz and
+// rasterizes with freetype). Breaks lines at spaces, between CJK characters
+// and at '\n', ellipsizes what doesn't fit in max_lines, and picks for every
+// character the first font in the stack that has a glyph for it.
+
+// Primary font first, then fallbacks in the order they are tried
+typedef std::vector<TTF_Font*> FontStack;
+
+// A stretch of one line drawn with one font, a byte range of TextLayout::text
+struct TextRun {
+    uint32_t start;
+    uint32_t end;
+    uint16_t font;      // index into the FontStack
+    int x;
+    int width;
+};
+
+struct TextLine {
+    uint32_t first_run; // into TextLayout::runs
+    uint32_t run_count;
+    int width;
+};
+
+// Everything in one resource, a layout that is only drawn once lives in the
+// frame arena (see frame_arena.hpp)
+struct TextLayout {
+    explicit TextLayout(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : text(resource), runs(resource), lines(resource) {}
+
+    std::pmr::string text;  // what the runs point into, the input plus an ellipsis if one was needed
+    std::pmr::vector<TextRun> runs;
+    std::pmr::vector<TextLine> lines;
+    int width = 0;
+    int height = 0;
+    int line_skip = 0;
+    bool truncated = false;
+};
+
+// Lays text out in lines no wider than max_width (0 for no limit) and at most
+// max_lines of them, a single line turns '\n' into spaces. The layout's
+// working memory comes from out's resource.
+void layout_text(const FontStack& fonts, const char* text, int max_width, int max_lines, TextLayout& out);
+
+// Decodes the UTF-8 character at p and moves p past it, invalid bytes become U+FFFD
+uint32_t utf8_next(const char*& p);
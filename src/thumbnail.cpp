@@ -0,0 +1,527 @@
+#include <SDL2/SDL_image.h>
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+
+#include <jpeglib.h>
+#include <png.h>
+
+#include "log.hpp"
+#include "thumbnail.hpp"
+#include "trace.hpp"
+#include "wuhb.hpp"
+
+namespace {
+    constexpr int THUMBNAIL_QUALITY = 85;
+
+    void fit_size(int src_w, int src_h, int max_w, int max_h, int& w, int& h) {
+        w = src_w;
+        h = src_h;
+        if (w > max_w) {
+            h = (int)((int64_t)h * max_w / w);
+            w = max_w;
+        }
+        if (h > max_h) {
+            w = (int)((int64_t)w * max_h / h);
+            h = max_h;
+        }
+        if (w < 1) w = 1;
+        if (h < 1) h = 1;
+    }
+
+    // Box filters rows of a src_w x src_h image down to the output's size as
+    // they come in, only one output row is ever being summed
+    class RowDownscaler {
+    public:
+        void begin(int src_w, int src_h, int dst_w, int dst_h, DecodedImage& out) {
+            this->src_h = src_h;
+            this->dst_w = dst_w;
+            this->dst_h = dst_h;
+            this->out = &out;
+            src_y = 0;
+            dst_y = 0;
+            rows_summed = 0;
+
+            column.resize(src_w);
+            column_width.assign(dst_w, 0);
+            for (int x = 0; x < src_w; ++x) {
+                column[x] = (int)((int64_t)x * dst_w / src_w);
+                column_width[column[x]]++;
+            }
+            sums.assign(dst_w * 4, 0);
+
+            out.width = dst_w;
+            out.height = dst_h;
+            out.pixels.assign((size_t)dst_w * dst_h * 4, 0);
+        }
+
+        // channels is 3 (RGB) or 4 (RGBA)
+        void push(const uint8_t* row, int channels) {
+            int row_dst_y = (int)((int64_t)src_y * dst_h / src_h);
+            if (row_dst_y != dst_y) flush();
+            dst_y = row_dst_y;
+
+            const int src_w = column.size();
+            for (int x = 0; x < src_w; ++x) {
+                uint32_t* sum = &sums[column[x] * 4];
+                sum[0] += row[0];
+                sum[1] += row[1];
+                sum[2] += row[2];
+                sum[3] += channels == 4 ? row[3] : 255;
+                row += channels;
+            }
+            rows_summed++;
+            src_y++;
+        }
+
+        void finish() {
+            flush();
+        }
+
+    private:
+        std::vector<int> column;            // output column of each input column
+        std::vector<uint32_t> column_width; // input columns per output column
+        std::vector<uint32_t> sums;
+        DecodedImage* out = nullptr;
+        int src_h = 0, dst_w = 0, dst_h = 0;
+        int src_y = 0, dst_y = 0, rows_summed = 0;
+
+        void flush() {
+            if (rows_summed == 0 || dst_y >= dst_h) return;
+            uint8_t* dst = &out->pixels[(size_t)dst_y * dst_w * 4];
+            for (int x = 0; x < dst_w; ++x) {
+                uint32_t count = column_width[x] * rows_summed;
+                if (count == 0) count = 1;
+                for (int c = 0; c < 4; ++c) dst[x * 4 + c] = sums[x * 4 + c] / count;
+            }
+            sums.assign(sums.size(), 0);
+            rows_summed = 0;
+        }
+    };
+
+    struct JpegError {
+        jpeg_error_mgr mgr;
+        jmp_buf jump;
+    };
+
+    void jpeg_error_exit(j_common_ptr info) {
+        JpegError* error = (JpegError*)info->err;
+        char message[JMSG_LENGTH_MAX];
+        (*info->err->format_message)(info, message);
+        LOG_WARN(LOG_CAT_RENDER, "JPEG decode failed: %s", message);
+        longjmp(error->jump, 1);
+    }
+
+    void jpeg_quiet(j_common_ptr) {
+        // Warnings about slightly broken files, the image is still usable
+    }
+
+    // Everything that must outlive a longjmp is declared before the setjmp
+    bool decode_jpeg(FILE* file, int max_w, int max_h, DecodedImage& out) {
+        jpeg_decompress_struct info;
+        JpegError error;
+        RowDownscaler scaler;
+        std::vector<uint8_t> row;
+
+        info.err = jpeg_std_error(&error.mgr);
+        error.mgr.error_exit = jpeg_error_exit;
+        error.mgr.output_message = jpeg_quiet;
+        if (setjmp(error.jump)) {
+            jpeg_destroy_decompress(&info);
+            return false;
+        }
+
+        jpeg_create_decompress(&info);
+        jpeg_stdio_src(&info, file);
+        jpeg_read_header(&info, TRUE);
+
+        int w, h;
+        fit_size(info.image_width, info.image_height, max_w, max_h, w, h);
+
+        // The largest IDCT scaling that still leaves at least the target size
+        info.scale_num = 1;
+        info.scale_denom = 1;
+        for (unsigned denom = 8; denom > 1; denom /= 2) {
+            if (info.image_width / denom >= (unsigned)w && info.image_height / denom >= (unsigned)h) {
+                info.scale_denom = denom;
+                break;
+            }
+        }
+        info.out_color_space = JCS_RGB;
+        info.dct_method = JDCT_IFAST;
+        info.do_fancy_upsampling = FALSE;
+
+        jpeg_start_decompress(&info);
+        fit_size(info.output_width, info.output_height, max_w, max_h, w, h);
+        scaler.begin(info.output_width, info.output_height, w, h, out);
+
+        row.resize(info.output_width * info.output_components);
+        JSAMPROW rows[1] = { row.data() };
+        while (info.output_scanline < info.output_height) {
+            jpeg_read_scanlines(&info, rows, 1);
+            scaler.push(row.data(), info.output_components);
+        }
+        scaler.finish();
+
+        jpeg_finish_decompress(&info);
+        jpeg_destroy_decompress(&info);
+        return true;
+    }
+
+    void png_error_exit(png_structp png, png_const_charp message) {
+        LOG_WARN(LOG_CAT_RENDER, "PNG decode failed: %s", message);
+        png_longjmp(png, 1);
+    }
+
+    void png_quiet(png_structp, png_const_charp) {
+    }
+
+    bool decode_png(FILE* file, int max_w, int max_h, DecodedImage& out) {
+        png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, png_error_exit, png_quiet);
+        if (!png) return false;
+        png_infop info = png_create_info_struct(png);
+        RowDownscaler scaler;
+        std::vector<uint8_t> pixels;
+        std::vector<png_bytep> rows;
+
+        if (!info || setjmp(png_jmpbuf(png))) {
+            png_destroy_read_struct(&png, &info, nullptr);
+            return false;
+        }
+
+        png_init_io(png, file);
+        png_read_info(png, info);
+
+        // Everything to 8 bit RGBA
+        png_set_expand(png);
+        png_set_strip_16(png);
+        png_set_gray_to_rgb(png);
+        png_set_filler(png, 0xFF, PNG_FILLER_AFTER);
+        int passes = png_set_interlace_handling(png);
+        png_read_update_info(png, info);
+
+        const int src_w = png_get_image_width(png, info);
+        const int src_h = png_get_image_height(png, info);
+        const size_t stride = png_get_rowbytes(png, info);
+
+        int w, h;
+        fit_size(src_w, src_h, max_w, max_h, w, h);
+        scaler.begin(src_w, src_h, w, h, out);
+
+        if (passes > 1) {
+            // Interlaced rows are only complete after the last pass, this
+            // needs the whole image. Screenshots are never interlaced.
+            pixels.resize(stride * src_h);
+            rows.resize(src_h);
+            for (int y = 0; y < src_h; ++y) rows[y] = &pixels[stride * y];
+            png_read_image(png, rows.data());
+            for (int y = 0; y < src_h; ++y) scaler.push(rows[y], 4);
+        } else {
+            pixels.resize(stride);
+            for (int y = 0; y < src_h; ++y) {
+                png_read_row(png, pixels.data(), nullptr);
+                scaler.push(pixels.data(), 4);
+            }
+        }
+        scaler.finish();
+
+        png_read_end(png, nullptr);
+        png_destroy_read_struct(&png, &info, nullptr);
+        return true;
+    }
+
+    // Takes ownership of loaded
+    bool decode_surface(SDL_Surface* loaded, int max_w, int max_h, DecodedImage& out) {
+        SDL_Surface* surface = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+        SDL_FreeSurface(loaded);
+        if (!surface) return false;
+
+        int w, h;
+        fit_size(surface->w, surface->h, max_w, max_h, w, h);
+        RowDownscaler scaler;
+        scaler.begin(surface->w, surface->h, w, h, out);
+        for (int y = 0; y < surface->h; ++y) {
+            scaler.push((const uint8_t*)surface->pixels + y * surface->pitch, 4);
+        }
+        scaler.finish();
+
+        SDL_FreeSurface(surface);
+        return true;
+    }
+
+    bool decode_other(const char* path, int max_w, int max_h, DecodedImage& out) {
+        SDL_Surface* loaded = IMG_Load(path);
+        if (!loaded) {
+            LOG_WARN(LOG_CAT_RENDER, "IMG_Load failed: %s", IMG_GetError());
+            return false;
+        }
+        return decode_surface(loaded, max_w, max_h, out);
+    }
+
+    // The iconTex.tga inside a bundle, read on its own
+    bool decode_wuhb_icon(const char* path, int max_w, int max_h, DecodedImage& out) {
+        WuhbFile bundle;
+        std::vector<uint8_t> tga;
+        if (!bundle.open(path) || !bundle.read_icon(tga)) return false;
+
+        SDL_RWops* source = SDL_RWFromConstMem(tga.data(), tga.size());
+        if (!source) return false;
+        SDL_Surface* loaded = IMG_LoadTGA_RW(source);
+        SDL_RWclose(source);
+        if (!loaded) {
+            LOG_WARN(LOG_CAT_RENDER, "Bad icon in %s: %s", path, IMG_GetError());
+            return false;
+        }
+        return decode_surface(loaded, max_w, max_h, out);
+    }
+
+    bool write_jpeg(const char* path, const DecodedImage& image) {
+        // Written next to the final name first so a half written file is never read back
+        std::string temp = std::string(path) + ".tmp";
+        FILE* file = fopen(temp.c_str(), "wb");
+        if (!file) return false;
+
+        jpeg_compress_struct info;
+        JpegError error;
+        std::vector<uint8_t> row(image.width * 3);
+
+        info.err = jpeg_std_error(&error.mgr);
+        error.mgr.error_exit = jpeg_error_exit;
+        if (setjmp(error.jump)) {
+            jpeg_destroy_compress(&info);
+            fclose(file);
+            remove(temp.c_str());
+            return false;
+        }
+
+        jpeg_create_compress(&info);
+        jpeg_stdio_dest(&info, file);
+        info.image_width = image.width;
+        info.image_height = image.height;
+        info.input_components = 3;
+        info.in_color_space = JCS_RGB;
+        jpeg_set_defaults(&info);
+        jpeg_set_quality(&info, THUMBNAIL_QUALITY, TRUE);
+        jpeg_start_compress(&info, TRUE);
+
+        JSAMPROW rows[1] = { row.data() };
+        while (info.next_scanline < info.image_height) {
+            const uint8_t* src = &image.pixels[(size_t)info.next_scanline * image.width * 4];
+            for (int x = 0; x < image.width; ++x) {
+                row[x * 3 + 0] = src[x * 4 + 0];
+                row[x * 3 + 1] = src[x * 4 + 1];
+                row[x * 3 + 2] = src[x * 4 + 2];
+            }
+            jpeg_write_scanlines(&info, rows, 1);
+        }
+
+        jpeg_finish_compress(&info);
+        jpeg_destroy_compress(&info);
+        fclose(file);
+        return rename(temp.c_str(), path) == 0;
+    }
+
+    std::string cache_path(const char* path, const struct stat& st, int max_w, int max_h) {
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        auto add = [&hash](uint64_t value) {
+            hash ^= value;
+            hash *= 0x100000001b3ULL;
+        };
+        for (const char* p = path; *p; ++p) add((unsigned char)*p);
+        add((uint64_t)st.st_size);
+        add((uint64_t)st.st_mtime);
+        add(((uint64_t)max_w << 32) | (uint32_t)max_h);
+
+        char name[64];
+        snprintf(name, sizeof(name), "/%016llx.jpg", (unsigned long long)hash);
+        return std::string(THUMBNAIL_CACHE_DIR) + name;
+    }
+}
+
+bool decode_image_scaled(const char* path, int max_w, int max_h, DecodedImage& out) {
+    TRACE_FUNCTION();
+    if (is_wuhb_path(path)) return decode_wuhb_icon(path, max_w, max_h, out);
+
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+
+    unsigned char magic[8] = {};
+    size_t got = fread(magic, 1, sizeof(magic), file);
+    rewind(file);
+
+    bool ok;
+    if (got >= 3 && magic[0] == 0xFF && magic[1] == 0xD8 && magic[2] == 0xFF) {
+        ok = decode_jpeg(file, max_w, max_h, out);
+    } else if (got == 8 && png_sig_cmp(magic, 0, 8) == 0) {
+        ok = decode_png(file, max_w, max_h, out);
+    } else {
+        ok = decode_other(path, max_w, max_h, out);
+    }
+
+    fclose(file);
+    return ok;
+}
+
+bool decode_image_memory(const void* data, size_t size, const char* type, int max_w, int max_h, DecodedImage& out) {
+    SDL_RWops* source = SDL_RWFromConstMem(data, (int)size);
+    if (!source) return false;
+    SDL_Surface* loaded = IMG_LoadTyped_RW(source, 1, type);
+    if (!loaded) {
+        LOG_WARN(LOG_CAT_RENDER, "IMG_LoadTyped_RW failed: %s", IMG_GetError());
+        return false;
+    }
+    return decode_surface(loaded, max_w, max_h, out);
+}
+
+bool thumbnail_load(const char* path, int max_w, int max_h, DecodedImage& out) {
+    struct stat st;
+    if (stat(path, &st) != 0) return false;
+
+    std::string cached = cache_path(path, st, max_w, max_h);
+    if (decode_image_scaled(cached.c_str(), max_w, max_h, out)) return true;
+
+    if (!decode_image_scaled(path, max_w, max_h, out)) return false;
+    if (!write_jpeg(cached.c_str(), out)) {
+        LOG_WARN(LOG_CAT_RENDER, "Couldn't write thumbnail %s", cached.c_str());
+    }
+    return true;
+}
+
+SDL_Texture* thumbnail_texture(SDL_Renderer* renderer, const DecodedImage& image) {
+    SDL_Texture* texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, image.width, image.height);
+    if (!texture) return nullptr;
+    SDL_UpdateTexture(texture, nullptr, image.pixels.data(), image.width * 4);
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    return texture;
+}
+
+SDL_Texture* TextureResidency::use(uint32_t id) {
+    auto it = textures.find(id);
+    if (it == textures.end()) return nullptr;
+    it->second.last_used = frame;
+    return it->second.texture;
+}
+
+void TextureResidency::insert(uint32_t id, SDL_Texture* texture) {
+    auto existing = textures.find(id);
+    if (existing != textures.end()) SDL_DestroyTexture(existing->second.texture);
+    textures[id] = { texture, frame };
+
+    while (textures.size() > capacity) {
+        auto oldest = textures.begin();
+        for (auto it = textures.begin(); it != textures.end(); ++it) {
+            if (it->second.last_used < oldest->second.last_used) oldest = it;
+        }
+        SDL_DestroyTexture(oldest->second.texture);
+        textures.erase(oldest);
+    }
+}
+
+void TextureResidency::erase(uint32_t id) {
+    auto it = textures.find(id);
+    if (it == textures.end()) return;
+    SDL_DestroyTexture(it->second.texture);
+    textures.erase(it);
+}
+
+void TextureResidency::clear() {
+    for (auto& entry : textures) SDL_DestroyTexture(entry.second.texture);
+    textures.clear();
+}
+
+void ThumbnailLoader::start() {
+    if (worker.joinable()) return;
+
+    mkdir(THUMBNAIL_CACHE_DIR, 0777);
+    stopping = false;
+    worker = std::thread([this] { run(); });
+}
+
+void ThumbnailLoader::stop() {
+    if (!worker.joinable()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        wanted.clear();
+        full_pending = false;
+    }
+    wake.notify_one();
+    worker.join();
+    results.clear();
+}
+
+void ThumbnailLoader::set_wanted(std::vector<ThumbnailRequest>& requests) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        wanted.clear();
+        for (ThumbnailRequest& request : requests) {
+            if (request.id == in_flight) continue;
+            bool finished = false;
+            for (const ThumbnailResult& result : results) {
+                if (!result.full && result.id == request.id) finished = true;
+            }
+            if (!finished) wanted.push_back(std::move(request));
+        }
+    }
+    wake.notify_one();
+}
+
+void ThumbnailLoader::request_full(const ThumbnailRequest& request) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        full_request = request;
+        full_pending = true;
+    }
+    wake.notify_one();
+}
+
+bool ThumbnailLoader::poll(ThumbnailResult& out) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (results.empty()) return false;
+    out = std::move(results.front());
+    results.pop_front();
+    return true;
+}
+
+void ThumbnailLoader::run() {
+    TRACE_THREAD_NAME("thumbnails");
+    while (true) {
+        ThumbnailRequest request;
+        bool full;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopping || full_pending || !wanted.empty(); });
+            if (stopping) return;
+
+            full = full_pending;
+            if (full) {
+                request = full_request;
+                full_pending = false;
+            } else {
+                request = std::move(wanted.front());
+                wanted.pop_front();
+                in_flight = request.id;
+            }
+        }
+
+        ThumbnailResult result;
+        result.id = request.id;
+        result.full = full;
+        if (full) {
+            TRACE_SCOPE("decode_full");
+            result.ok = decode_image_scaled(request.path.c_str(), request.max_w, request.max_h, result.image);
+        } else if (request.use_cache) {
+            TRACE_SCOPE("load_thumbnail");
+            result.ok = thumbnail_load(request.path.c_str(), request.max_w, request.max_h, result.image);
+        } else {
+            TRACE_SCOPE("decode_thumbnail");
+            result.ok = decode_image_scaled(request.path.c_str(), request.max_w, request.max_h, result.image);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        in_flight = UINT32_MAX;
+        results.push_back(std::move(result));
+    }
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "platform/platform.hpp"
+
+// Reduced size decoding of JPEG and PNG files, a persistent cache of the
+// results on the SD card and a worker thread that does both off the main
+// thread. Images are never decoded whole: JPEGs are scaled down by the
+// decoder itself (1/2, 1/4 or 1/8 while doing the IDCT) and every format is
+// box filtered down row by row as it is decoded, so a thumbnail only ever
+// costs a couple of rows of memory on top of its own size.
+
+// Thumbnails are kept here as small JPEGs named after a hash of the source
+// path, size, modification time and thumbnail size, a changed file gets a new one
+#define THUMBNAIL_CACHE_DIR SD_CARD_PATH "switchU/thumbnails"
+
+// RGBA32 pixels, rows tightly packed
+struct DecodedImage {
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> pixels;
+};
+
+// Decodes the image at path to fit in max_w x max_h, keeping its aspect
+// ratio and never scaling up. JPEG and PNG are streamed, other formats go
+// through SDL_image whole. For a .wuhb bundle it is the icon inside.
+bool decode_image_scaled(const char* path, int max_w, int max_h, DecodedImage& out);
+
+// Same for an image file already in memory, through SDL_image. type is its
+// name for the format ("TGA", "PNG"...), TGAs have no signature to go by.
+bool decode_image_memory(const void* data, size_t size, const char* type, int max_w, int max_h, DecodedImage& out);
+
+// decode_image_scaled() through the thumbnail cache
+bool thumbnail_load(const char* path, int max_w, int max_h, DecodedImage& out);
+
+// A static texture with the image's pixels
+SDL_Texture* thumbnail_texture(SDL_Renderer* renderer, const DecodedImage& image);
+
+struct ThumbnailRequest {
+    uint32_t id;        // the caller's, handed back with the result
+    std::string path;
+    int max_w;
+    int max_h;
+    bool use_cache;     // through the thumbnail cache, which drops alpha
+};
+
+struct ThumbnailResult {
+    uint32_t id;
+    bool full;          // from request_full()
+    bool ok;
+    DecodedImage image;
+};
+
+// Loads thumbnails on a worker thread. The caller says which ones it wants
+// right now with set_wanted(), in the order it wants them, and collects them
+// with poll() on the main thread.
+class ThumbnailLoader {
+public:
+    ~ThumbnailLoader() { stop(); }
+
+    void start();
+    // Drops whatever is still queued and waits for the current image
+    void stop();
+
+    // Replaces the queue, requests missing from it are dropped. Ones that
+    // are being decoded or already finished are left out.
+    void set_wanted(std::vector<ThumbnailRequest>& wanted);
+    // One uncached image, decoded before any queued thumbnail. Replaces the
+    // previous one if that hasn't started yet.
+    void request_full(const ThumbnailRequest& request);
+
+    bool poll(ThumbnailResult& out);
+
+private:
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    std::deque<ThumbnailRequest> wanted;
+    ThumbnailRequest full_request;
+    bool full_pending = false;
+    uint32_t in_flight = UINT32_MAX;
+    std::deque<ThumbnailResult> results;
+
+    void run();
+};
+
+// Textures for the items of a virtualized view, by the view's item id. Keeps
+// at most capacity of them and lets go of the ones drawn longest ago first.
+class TextureResidency {
+public:
+    explicit TextureResidency(size_t capacity) : capacity(capacity) {}
+
+    // The texture, marked as drawn this frame, or nullptr if it isn't resident
+    SDL_Texture* use(uint32_t id);
+    bool contains(uint32_t id) const { return textures.count(id) != 0; }
+    // Takes ownership of texture
+    void insert(uint32_t id, SDL_Texture* texture);
+    // Destroys one texture, e.g. when what it was made from changed
+    void erase(uint32_t id);
+    // Once per frame, before the frame's use() calls
+    void next_frame() { ++frame; }
+    void clear();
+
+private:
+    struct Resident {
+        SDL_Texture* texture;
+        uint64_t last_used;
+    };
+
+    std::unordered_map<uint32_t, Resident> textures;
+    size_t capacity;
+    uint64_t frame = 0;
+};
@@ -1,6 +1,10 @@
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <unordered_map>
 #include <unordered_set>
 #include <fstream>
 #include <cstring>
@@ -8,29 +12,119 @@
 #include <dirent.h>
 #include <sys/types.h>
 
+#include "log.hpp"
+#include "render.hpp"
+#include "scan_arena.hpp"
+#include "trace.hpp"
 #include "util.hpp"
 #include "title_extractor.hpp"
+#include "wuhb.hpp"
 
-int MAX_GAME_LOADS = 12;
 extern bool load_homebrew_titles;
 
-std::vector<App> apps;
+Library library;
+StringPool library_strings;
 
-std::unordered_set<std::string> load_ignored_apps() {
-    std::unordered_set<std::string> ignored;
+static const char* storage_device_names[] = { "sd", "mlc", "usb", "odd" };
+
+StorageDevice storage_device_from_name(const char* name) {
+    for (int i = DEVICE_MLC; i <= DEVICE_ODD; ++i) {
+        if (strcmp(name, storage_device_names[i]) == 0) return (StorageDevice)i;
+    }
+    return DEVICE_SD;
+}
+
+const char* storage_device_name(StorageDevice device) {
+    return storage_device_names[device];
+}
+
+void library_add(SDL_Texture* icon, const char* icon_path, const char* title, const char* app_path, StorageDevice device, uint64_t titleid, SDL_Renderer* renderer) {
+    // The readback is far too slow for every frame, the colour is kept instead
+    TRACE_SCOPE("render_icon_background_color");
+    SDL_Color background = { 0, 0, 0, 255 };
+    render_icon_background_color(renderer, icon, background);
+
+    library_add_entry(icon, background, icon_path, title, app_path, device, titleid);
+}
+
+void library_add_entry(SDL_Texture* icon, SDL_Color background, const char* icon_path, const char* title, const char* app_path, StorageDevice device, uint64_t titleid) {
+    library.hot.icon.push_back(icon);
+    library.hot.background.push_back(background);
+    library.hot.tile.push_back({});
+    library.hot.icon_rect.push_back({});
+
+    library.cold.title.push_back(title);
+    library.cold.app_path.push_back(app_path);
+    library.cold.icon_path.push_back(icon_path);
+    library.cold.device.push_back(device);
+    library.cold.titleid.push_back(titleid);
+
+    library.layout_valid = false;
+}
+
+// Moves the last entry to the front, keeping the others in order
+static void library_move_last_to_front() {
+    auto rotate = [](auto& array) {
+        std::rotate(array.begin(), array.end() - 1, array.end());
+    };
+    rotate(library.hot.icon);
+    rotate(library.hot.background);
+    rotate(library.hot.tile);
+    rotate(library.hot.icon_rect);
+    rotate(library.cold.title);
+    rotate(library.cold.app_path);
+    rotate(library.cold.icon_path);
+    rotate(library.cold.device);
+    rotate(library.cold.titleid);
+    library.layout_valid = false;
+}
+
+void library_remove(size_t index) {
+    if (library.hot.icon[index]) SDL_DestroyTexture(library.hot.icon[index]);
+
+    auto erase = [index](auto& array) {
+        array.erase(array.begin() + index);
+    };
+    erase(library.hot.icon);
+    erase(library.hot.background);
+    erase(library.hot.tile);
+    erase(library.hot.icon_rect);
+    erase(library.cold.title);
+    erase(library.cold.app_path);
+    erase(library.cold.icon_path);
+    erase(library.cold.device);
+    erase(library.cold.titleid);
+    library.layout_valid = false;
+    library.generation++;
+}
+
+void library_clear() {
+    for (SDL_Texture* icon : library.hot.icon) {
+        if (icon) SDL_DestroyTexture(icon);
+    }
+
+    library.hot = LibraryHot();
+    library.cold = LibraryCold();
+    library.layout_valid = false;
+    library.generation++;
+    library_strings.clear();
+}
+
+IgnoreList load_ignored_apps(std::pmr::memory_resource* resource) {
+    IgnoreList ignored(resource);
     std::ifstream file(SD_CARD_PATH "switchU/ignore.txt");
     if (!file.is_open()) {
-        printf("No ignore.txt found or failed to open.\n");
+        LOG_INFO(LOG_CAT_SCAN, "No ignore.txt found or failed to open.");
         return ignored;
     }
 
-    std::string line;
+    std::pmr::string line(resource);
     while (std::getline(file, line)) {
         // Trim whitespace and \r
         line.erase(0, line.find_first_not_of(" \t\r\n")); // left trim
         line.erase(line.find_last_not_of(" \t\r\n") + 1); // right trim
         if (!line.empty()) {
-            printf("Ignoring app: %s\n", line.c_str());
+            LOG_DEBUG(LOG_CAT_SCAN, "Ignoring app: %s", line.c_str());
             ignored.insert(line);
         }
     }
@@ -39,103 +133,189 @@ std::unordered_set<std::string> load_ignored_apps() {
     return ignored;
 }
 
-std::string get_title_from_meta(const char* path) {
+std::pmr::string get_title_from_meta(const char* path, std::pmr::memory_resource* resource) {
     FILE* file = fopen(path, "r");
-    if (!file) return "Unknown";
+    if (!file) return std::pmr::string(resource);
 
     char line[512];
     while (fgets(line, sizeof(line), file)) {
-        char* start = strstr(line, "<title>");
+        char* start = strstr(line, "<name>");
         if (start) {
-            start += strlen("<title>");
-            char* end = strstr(start, "</title>");
+            start += strlen("<name>");
+            char* end = strstr(start, "</name>");
             if (end) {
                 *end = '\0';
                 fclose(file);
-                return std::string(start);
+                return std::pmr::string(start, resource);
             }
         }
     }
 
     fclose(file);
-    return "Unknown";
-}
-
-App create_sysapp_entry(const MCPTitleListType& title_info, SDL_Renderer* renderer) {
-    std::string title = "Unknown / Error";
-    std::string base_path = ROOT_PATH + std::string(title_info.path);
-    std::string meta_path = base_path + "/meta/meta.xml";
-    std::string app_icon = base_path + "/meta/iconTex.tga";
-
-    // Parse title from meta.xml
-    FILE* file = fopen(meta_path.c_str(), "r");
-    if (file) {
-        char line[512];
-        while (fgets(line, sizeof(line), file)) {
-            char* start = strstr(line, "<longname_en type=\"string\" length=\"512\">");
-            if (start) {
-                start += strlen("<longname_en type=\"string\" length=\"512\">");
-                char* end = strstr(start, "</longname_en>");
-                if (end) {
-                    *end = '\0';
-                    title = std::string(start);
-                    break;
-                }
-            }
-        }
-        fclose(file);
-    } else {
-        printf("Failed to open meta.xml for %s\n", meta_path.c_str());
-    }
-
-    // Attempt to load custom icon from SD
-    std::string safe_folder_name = sanitize_title_for_path(title);
-    std::string custom_icon_path = SD_CARD_PATH "switchU/custom_icons/" + safe_folder_name + "/icon.png";
-    SDL_Texture* icon = load_texture(custom_icon_path.c_str(), renderer);
-
-    // Fallback to iconTex.tga if custom icon not found
-    if (!icon) {
-        SDL_RWops* tmp = SDL_RWFromFile(app_icon.c_str(), "rb");
-        if (tmp) {
-            SDL_Surface* surface = IMG_LoadTGA_RW(tmp);
-            if (surface) {
-                icon = SDL_CreateTextureFromSurface(renderer, surface);
-                SDL_FreeSurface(surface);
+    return std::pmr::string(resource);
+}
+
+std::pmr::string get_longname_from_meta(const char* path, std::pmr::memory_resource* resource) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        LOG_WARN(LOG_CAT_SCAN, "Failed to open meta.xml for %s", path);
+        return std::pmr::string(resource);
+    }
+
+    char line[512];
+    while (fgets(line, sizeof(line), file)) {
+        char* start = strstr(line, "<longname_en type=\"string\" length=\"512\">");
+        if (start) {
+            start += strlen("<longname_en type=\"string\" length=\"512\">");
+            char* end = strstr(start, "</longname_en>");
+            if (end) {
+                *end = '\0';
+                fclose(file);
+                return std::pmr::string(start, resource);
             }
-            SDL_FreeRW(tmp);
         }
-        if (!icon) {
-            printf("Failed to load icon for system app: %s\n", title.c_str());
+    }
+
+    fclose(file);
+    return std::pmr::string(resource);
+}
+
+// SDL_image can't detect TGA from the data, it has to be asked for
+static SDL_Texture* load_tga(SDL_RWops* source, SDL_Renderer* renderer) {
+    SDL_Texture* icon = nullptr;
+    if (source) {
+        SDL_Surface* surface = IMG_LoadTGA_RW(source);
+        if (surface) {
+            icon = SDL_CreateTextureFromSurface(renderer, surface);
+            SDL_FreeSurface(surface);
         }
+        SDL_RWclose(source);
     }
+    return icon;
+}
 
-    App entry = {
-        title,
-        base_path,
-        title_info.indexedDevice,
-        title_info.titleId,
-        icon
-    };
+// A bundle's icon goes straight from its one read to the decoder
+static SDL_Texture* load_wuhb_icon(WuhbFile& bundle, SDL_Renderer* renderer) {
+    std::vector<uint8_t> tga;
+    if (!bundle.read_icon(tga)) return nullptr;
+    return load_tga(SDL_RWFromConstMem(tga.data(), tga.size()), renderer);
+}
+
+SDL_Texture* load_icon(const char* path, SDL_Renderer* renderer) {
+    if (is_wuhb_path(path)) {
+        WuhbFile bundle;
+        return bundle.open(path) ? load_wuhb_icon(bundle, renderer) : nullptr;
+    }
+
+    size_t length = strlen(path);
+    if (length < 4 || strcmp(path + length - 4, ".tga") != 0) {
+        return load_texture(path, renderer);
+    }
+    return load_tga(SDL_RWFromFile(path, "rb"), renderer);
+}
+
+void library_load_icons(size_t first, size_t last, SDL_Renderer* renderer, bool sample_background) {
+    TRACE_FUNCTION();
+    if (last > library.size()) last = library.size();
+
+    for (size_t i = first; i < last; ++i) {
+        if (library.hot.icon[i] || library.cold.icon_path[i][0] == '\0') continue;
+        library.hot.icon[i] = load_icon(library.cold.icon_path[i], renderer);
+        if (sample_background) render_icon_background_color(renderer, library.hot.icon[i], library.hot.background[i]);
+        library.layout_valid = false;
+    }
+}
+
+static bool file_exists(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+    fclose(file);
+    return true;
+}
+
+// What a scan finds for one app, before it's added to the library. A scan on
+// another thread only gets this far, the library and SDL are the main thread's.
+struct ScannedApp {
+    std::pmr::string title;
+    std::pmr::string app_path;
+    std::pmr::string icon_path;     // empty if there is none
+    StorageDevice device = DEVICE_SD;
+    uint64_t titleid = 0;           // 0 for homebrew
+
+    explicit ScannedApp(std::pmr::memory_resource* resource) : title(resource), app_path(resource), icon_path(resource) {}
+};
+
+// A custom icon if there is one, the title's own iconTex.tga otherwise
+static std::pmr::string sysapp_icon_path(const std::pmr::string& safe_folder_name, const std::pmr::string& base_path, std::pmr::memory_resource* resource) {
+    std::pmr::string custom_icon_path = concat(resource, SD_CARD_PATH "switchU/custom_icons/", safe_folder_name, "/icon.png");
+    if (file_exists(custom_icon_path.c_str())) return custom_icon_path;
+    return concat(resource, base_path, "/meta/iconTex.tga");
+}
 
-    return entry;
+// Resolves a system title's name and icon, false if it is ignored
+static bool resolve_sysapp(const PlatformTitle& title_info, const IgnoreList& ignored_apps, ScannedApp& app, std::pmr::memory_resource* resource) {
+    TRACE_FUNCTION();
+    std::pmr::string base_path = concat(resource, ROOT_PATH, title_info.path);
+    std::pmr::string meta_path = concat(resource, base_path, "/meta/meta.xml");
+
+    std::pmr::string title = get_longname_from_meta(meta_path.c_str(), resource);
+    if (title.empty()) title = "Unknown / Error";
+
+    std::pmr::string safe_folder_name = sanitize_title_for_path(title, resource);
+    if (ignored_apps.find(safe_folder_name) != ignored_apps.end()) {
+        LOG_DEBUG(LOG_CAT_SCAN, "Skipping ignored system app: %s (safe: %s)", title.c_str(), safe_folder_name.c_str());
+        return false;
+    }
+
+    app.icon_path = sysapp_icon_path(safe_folder_name, base_path, resource);
+    app.title = std::move(title);
+    app.app_path = std::move(base_path);
+    app.device = storage_device_from_name(title_info.device);
+    app.titleid = title_info.title_id;
+    return true;
+}
+
+// Appends what a scan found, loading the icon only if with_icon is set
+static void add_scanned_app(const ScannedApp& app, bool with_icon, SDL_Renderer* renderer) {
+    const char* title = library_strings.intern(app.title);
+    const char* app_path = library_strings.intern(app.app_path);
+    if (!with_icon) {
+        library_add_entry(nullptr, { 0, 0, 0, 255 }, library_strings.intern(app.icon_path), title, app_path, app.device, app.titleid);
+        return;
+    }
+
+    const char* icon_path = app.icon_path.c_str();
+    SDL_Texture* icon = icon_path[0] ? load_icon(icon_path, renderer) : nullptr;
+    if (!icon && icon_path[0]) {
+        LOG_WARN(LOG_CAT_SCAN, "Failed to load icon for app: %s", title);
+        icon_path = "";
+    }
+    library_add(icon, library_strings.intern(icon_path), title, app_path, app.device, app.titleid, renderer);
 }
 
-static std::string find_launchable_file(const std::string& app_dir) {
+bool create_sysapp_entry(const PlatformTitle& title_info, const IgnoreList& ignored_apps, bool with_icon, SDL_Renderer* renderer, std::pmr::memory_resource* resource) {
+    ScannedApp app(resource);
+    if (!resolve_sysapp(title_info, ignored_apps, app, resource)) return false;
+    add_scanned_app(app, with_icon, renderer);
+    return true;
+}
+
+static std::pmr::string find_launchable_file(const std::pmr::string& app_dir, std::pmr::memory_resource* resource) {
+    std::pmr::string found_rpx(resource), found_wuhb(resource);
+
     DIR* dir = opendir(app_dir.c_str());
-    if (!dir) return "";
+    if (!dir) return found_rpx;
 
-    std::string found_rpx, found_wuhb;
     struct dirent* entry;
-    int loaded_count = 0;
 
-    while ((entry = readdir(dir)) != nullptr && loaded_count < MAX_GAME_LOADS) {
-        std::string fname = entry->d_name;
+    while ((entry = readdir(dir)) != nullptr) {
+        std::string_view fname = entry->d_name;
 
-        if (fname.size() >= 5 && fname.substr(fname.size() - 5) == ".wuhb") {
-            found_wuhb = app_dir + "/" + fname;
+        if (fname.size() >= 5 && fname.compare(fname.size() - 5, 5, ".wuhb") == 0) {
+            found_wuhb = concat(resource, app_dir, "/", fname);
             break;
-        } else if (fname.size() >= 4 && fname.substr(fname.size() - 4) == ".rpx") {
-            found_rpx = app_dir + "/" + fname;
+        } else if (fname.size() >= 4 && fname.compare(fname.size() - 4, 4, ".rpx") == 0) {
+            found_rpx = concat(resource, app_dir, "/", fname);
         }
     }
 
@@ -145,143 +325,403 @@ static std::string find_launchable_file(const std::string& app_dir) {
     return found_rpx;
 }
 
-void scan_apps(SDL_Renderer* renderer) {
-    apps.clear();
+// A custom icon, the bundle's own, or the icon.png next to the app, in that
+// order. Empty if there is none.
+static std::pmr::string homebrew_icon_path(const std::pmr::string& app_folder, const std::pmr::string& app_path, const std::pmr::string& launch_file,
+                                           bool bundle_has_icon, std::pmr::memory_resource* resource) {
+    std::pmr::string custom_icon_path = concat(resource, SD_CARD_PATH "switchU/custom_icons/", app_folder, "/icon.png");
+    if (file_exists(custom_icon_path.c_str())) return custom_icon_path;
+    if (bundle_has_icon) return launch_file;
+
+    std::pmr::string folder_icon_path = concat(resource, app_path, "/icon.png");
+    if (file_exists(folder_icon_path.c_str())) return folder_icon_path;
+    return std::pmr::string(resource);
+}
 
+// Name and icon come from the bundle for .wuhb apps, and from the meta.xml
+// and icon.png next to it for .rpx apps or a bundle without them. A custom
+// icon wins over both; the folder name stands in for a missing name and the
+// placeholder tile for a missing icon.
+static void resolve_homebrew(const std::pmr::string& app_folder, const std::pmr::string& app_path, const std::pmr::string& launch_file,
+                             ScannedApp& app, std::pmr::memory_resource* resource) {
+    TRACE_FUNCTION();
+    WuhbFile bundle(resource);
+    WuhbMeta meta(resource);
+    bool from_bundle = is_wuhb_path(launch_file.c_str()) && bundle.open(launch_file.c_str()) && bundle.read_meta(meta);
+
+    std::pmr::string title = from_bundle ? std::move(meta.name) : get_title_from_meta(concat(resource, app_path, "/meta.xml").c_str(), resource);
+    if (title.empty()) title = app_folder;
+
+    app.icon_path = homebrew_icon_path(app_folder, app_path, launch_file, from_bundle && meta.has_icon, resource);
+    if (app.icon_path.empty()) LOG_WARN(LOG_CAT_SCAN, "No icon for app: %s", app_folder.c_str());
+
+    app.title = std::move(title);
+    app.app_path = launch_file;
+    app.device = DEVICE_SD;
+    app.titleid = 0;
+}
+
+// Start of every scan's arena, big enough for a few hundred titles before
+// it has to take blocks from the heap
+static char scan_arena_buffer[64 * 1024];
+
+// Everything a scan finds, in library order with the disc title first
+static void scan_collect(bool homebrew_titles, std::pmr::vector<ScannedApp>& apps, std::pmr::memory_resource* resource) {
     const char* apps_dir = SD_CARD_PATH "wiiu/apps/";
-    const char* custom_icons_dir = SD_CARD_PATH "switchU/custom_icons/";
 
-    std::unordered_set<std::string> ignored_apps = load_ignored_apps();
+    IgnoreList ignored_apps = load_ignored_apps(resource);
 
-    if (load_homebrew_titles) {
+    if (homebrew_titles) {
         DIR* dir = opendir(apps_dir);
         if (!dir) {
-            printf("Failed to open apps directory\n");
+            LOG_ERROR(LOG_CAT_SCAN, "Failed to open apps directory");
             return;
         }
 
-        printf("Starting Hombrew app scan...\n");
+        LOG_INFO(LOG_CAT_SCAN, "Starting Hombrew app scan...");
         struct dirent* entry;
-        int loaded_count = 0;
 
-        while ((entry = readdir(dir)) != nullptr && loaded_count < MAX_GAME_LOADS) {
+        while ((entry = readdir(dir)) != nullptr) {
             if (entry->d_type == DT_DIR && strcmp(entry->d_name, ".") && strcmp(entry->d_name, "..")) {
-                std::string app_folder = entry->d_name;
+                std::pmr::string app_folder(entry->d_name, resource);
 
                 if (ignored_apps.find(app_folder) != ignored_apps.end()) {
-                    printf("Skipping ignored app: %s\n", app_folder.c_str());
+                    LOG_DEBUG(LOG_CAT_SCAN, "Skipping ignored app: %s", app_folder.c_str());
                     continue;
                 }
 
-                std::string app_path = std::string(apps_dir) + app_folder;
+                std::pmr::string app_path = concat(resource, apps_dir, app_folder);
 
-                std::string launch_file = find_launchable_file(app_path);
+                std::pmr::string launch_file = find_launchable_file(app_path, resource);
                 if (launch_file.empty()) {
-                    printf("No launchable .wuhb or .rpx found in %s\n", app_folder.c_str());
+                    LOG_DEBUG(LOG_CAT_SCAN, "No launchable .wuhb or .rpx found in %s", app_folder.c_str());
                     continue;
                 }
 
-                std::string custom_icon_path = std::string(custom_icons_dir) + app_folder + "/icon.png";
-                std::string default_icon_path = app_path + "/icon.png";
-
-                SDL_Texture* icon = nullptr;
-
-                FILE* test = fopen(custom_icon_path.c_str(), "rb");
-                if (test) {
-                    fclose(test);
-                    icon = load_texture(custom_icon_path.c_str(), renderer);
-                } else {
-                    icon = load_texture(default_icon_path.c_str(), renderer);
-                }
-
-                if (!icon) {
-                    printf("No icon for app: %s\n", app_folder.c_str());
-                    continue;
-                }
-
-                App entry = { app_folder, launch_file, "sd", 0, icon };
-                apps.push_back(entry);
-                loaded_count++;
-                printf("Loaded app: %s -> %s\n", app_folder.c_str(), launch_file.c_str());
+                apps.emplace_back(resource);
+                resolve_homebrew(app_folder, app_path, launch_file, apps.back(), resource);
+                LOG_DEBUG(LOG_CAT_SCAN, "Found app: %s -> %s", apps.back().title.c_str(), launch_file.c_str());
             }
         }
         closedir(dir);
     } else {
-        printf("Skipping Homebrew application scan due to its setting being disabled.\n");
+        LOG_INFO(LOG_CAT_SCAN, "Skipping Homebrew application scan due to its setting being disabled.");
     }
 
-    printf("Starting System app scan...\n");
-    MCPError handle = MCP_Open();
-    if (handle < 0) {
-        printf("Failed to start MCP\n");
+    LOG_INFO(LOG_CAT_SCAN, "Starting System app scan...");
+    std::pmr::vector<PlatformTitle> titles(resource);
+    if (!platform_list_titles(titles)) {
         return;
     }
+    LOG_INFO(LOG_CAT_SCAN, "Found %d system games", (int)titles.size());
 
-    uint32_t game_count = 0;
-    uint32_t title_count = MCP_TitleCount(handle);
-    if (title_count <= 0) {
-        printf("No titles found\n");
-        MCP_Close(handle);
-        return;
+    for (const auto& game : titles) {
+        ScannedApp app(resource);
+        if (!resolve_sysapp(game, ignored_apps, app, resource)) continue;
+        LOG_DEBUG(LOG_CAT_SCAN, "Found system app: %s -> %s", app.title.c_str(), app.app_path.c_str());
+
+        if (app.device == DEVICE_ODD) {
+            apps.insert(apps.begin(), std::move(app)); // Making ODD Always First
+        } else {
+            apps.push_back(std::move(app));
+        }
     }
-    printf("Found %d apps\n", title_count);
+}
+
+static void write_scan_result() {
+    FILE* out = fopen(SD_CARD_PATH "scanresult.txt", "w");
+    if (!out) return;
+    for (size_t i = 0; i < library.size(); ++i) {
+        fprintf(out,    "App: %s, Path: %s, Device: %s, TitleID: %llu\n",
+               library.cold.title[i], library.cold.app_path[i], storage_device_name(library.cold.device[i]),
+               (unsigned long long)library.cold.titleid[i]);
+    }
+    fclose(out);
+}
 
-    // More stuff from Launchiine, my way only worked on Cemu for some reason
-    std::vector<MCPTitleListType> titles(title_count);
-    for (MCPAppType type : supported_sys_app_type) {
-        uint32_t game_count_per_type = 0;
-        MCPError err = MCP_TitleListByAppType(
-                 handle, type,&game_count_per_type, titles.data() + game_count,
-                 (titles.size() - game_count) * sizeof(decltype(titles)::value_type));
+// The main loop's rescan, see scan_apps_start()
+static std::thread rescan;
+static std::atomic<bool> rescan_done{false};
+static std::pmr::vector<ScannedApp> rescan_result;
+static uint32_t rescan_generation = 0;      // the library's when the rescan started
+static bool rescan_homebrew = false;
+static bool rescan_superseded = false;      // a full scan ran meanwhile, the result is older than it
 
-        if (err < 0) {
-            printf("Failed to get installed games of type %d\n", type);
-            MCP_Close(handle);
-            return;
-        }
+void scan_apps(SDL_Renderer* renderer) {
+    TRACE_FUNCTION();
+
+    if (rescan.joinable()) rescan_superseded = true;
+    library_clear();
 
-        game_count += game_count_per_type;
+    ScanArena arena(scan_arena_buffer, sizeof(scan_arena_buffer));
+    {
+        std::pmr::vector<ScannedApp> apps(&arena);
+        scan_collect(load_homebrew_titles, apps, &arena);
+        for (size_t i = 0; i < apps.size(); ++i) add_scanned_app(apps[i], i < LIBRARY_HOME_ICONS, renderer);
     }
+    write_scan_result();
 
-    if (game_count != titles.size()) {
-        titles.resize(game_count);
+    last_scan_arena_stats = arena.stats();
+    LOG_INFO(LOG_CAT_SCAN, "Scan arena: %u allocations, %u bytes, %u overflow blocks",
+             (unsigned)last_scan_arena_stats.allocations, (unsigned)last_scan_arena_stats.peak_bytes,
+             (unsigned)last_scan_arena_stats.overflow_blocks);
+}
+
+// Swaps a scan's result in for the library. Entries that were already there
+// from the same icon keep it and its background, the rest come in without one.
+static void library_replace(const std::pmr::vector<ScannedApp>& apps) {
+    TRACE_FUNCTION();
+    struct KeptIcon {
+        SDL_Texture* icon;
+        SDL_Color background;
+        std::string icon_path;
+    };
+    std::unordered_map<std::string, KeptIcon> kept;
+    for (size_t i = 0; i < library.size(); ++i) {
+        if (!library.hot.icon[i]) continue;
+        KeptIcon icon = { library.hot.icon[i], library.hot.background[i], library.cold.icon_path[i] };
+        if (kept.emplace(library.cold.app_path[i], std::move(icon)).second) library.hot.icon[i] = nullptr;
     }
-    printf("Found %d system games\n", game_count);
 
-    for (auto game : titles) {
-        if (apps.size() >= static_cast<size_t>(MAX_GAME_LOADS)) break;
-        App entry = create_sysapp_entry(game, renderer);
-        std::string safe_name = sanitize_title_for_path(entry.title);
+    library_clear();
 
-        if (ignored_apps.find(safe_name) != ignored_apps.end()) {
-            printf("Skipping ignored system app: %s (safe: %s)\n", entry.title.c_str(), safe_name.c_str());
+    size_t reused = 0;
+    for (const ScannedApp& app : apps) {
+        auto found = kept.find(std::string(app.app_path.data(), app.app_path.size()));
+        if (found == kept.end() || std::string_view(found->second.icon_path) != app.icon_path) {
+            add_scanned_app(app, false, nullptr);
             continue;
         }
+        library_add_entry(found->second.icon, found->second.background, library_strings.intern(app.icon_path),
+                          library_strings.intern(app.title), library_strings.intern(app.app_path), app.device, app.titleid);
+        kept.erase(found);
+        reused++;
+    }
+
+    for (auto& entry : kept) SDL_DestroyTexture(entry.second.icon);
+    LOG_INFO(LOG_CAT_SCAN, "Rescan found %u apps, kept %u icons", (unsigned)library.size(), (unsigned)reused);
+}
+
+void scan_apps_start(bool homebrew_titles) {
+    // Rescans come once per return from a title, one already running is left to finish
+    if (rescan.joinable()) return;
+
+    rescan_generation = library.generation;
+    rescan_homebrew = homebrew_titles;
+    rescan_superseded = false;
+    rescan_done.store(false);
+    rescan = std::thread([homebrew_titles] {
+        TRACE_THREAD_NAME("rescan");
+        TRACE_SCOPE("scan_collect");
+        std::pmr::vector<ScannedApp> apps;
+        scan_collect(homebrew_titles, apps, std::pmr::get_default_resource());
+        rescan_result = std::move(apps);
+        rescan_done.store(true, std::memory_order_release);
+    });
+}
+
+bool scan_apps_poll() {
+    if (!rescan.joinable() || !rescan_done.load(std::memory_order_acquire)) return false;
+
+    rescan.join();
+    std::pmr::vector<ScannedApp> apps = std::move(rescan_result);
+    rescan_result = std::pmr::vector<ScannedApp>();
+
+    // The library changed while the rescan ran, e.g. MINUS or an ignore.txt
+    // edit. Its result would undo that, so it is thrown away. A full scan
+    // already is up to date, anything else is scanned again.
+    if (rescan_superseded) return false;
+    if (library.generation != rescan_generation || load_homebrew_titles != rescan_homebrew) {
+        LOG_INFO(LOG_CAT_SCAN, "Library changed during the rescan, scanning again");
+        scan_apps_start(load_homebrew_titles);
+        return false;
+    }
 
-        if (entry.storage_device == device_odd) {
-            apps.insert(apps.begin(), entry); // Making ODD Always First
+    library_replace(apps);
+    write_scan_result();
+    return true;
+}
+
+void scan_apps_shutdown() {
+    if (rescan.joinable()) rescan.join();
+    rescan_result = std::pmr::vector<ScannedApp>();
+}
+
+std::pmr::string library_entry_key(size_t index, std::pmr::memory_resource* resource) {
+    if (library.cold.titleid[index] != 0) return sanitize_title_for_path(library.cold.title[index], resource);
+
+    // Homebrew is known by its folder, .../wiiu/apps/<folder>/<file>
+    const char* folder = strstr(library.cold.app_path[index], "wiiu/apps/");
+    if (!folder) return std::pmr::string(resource);
+    folder += strlen("wiiu/apps/");
+    const char* end = strchr(folder, '/');
+    return std::pmr::string(folder, end ? end - folder : strlen(folder), resource);
+}
+
+void library_reload_custom_icon(const char* folder, SDL_Renderer* renderer, std::vector<size_t>& changed) {
+    TRACE_FUNCTION();
+    std::pmr::memory_resource* resource = std::pmr::get_default_resource();
+    std::pmr::string key(folder, resource);
+
+    for (size_t i = 0; i < library.size(); ++i) {
+        if (library_entry_key(i, resource) != key) continue;
+
+        std::pmr::string app_path(library.cold.app_path[i], resource);
+        std::pmr::string icon_path(resource);
+        if (library.cold.titleid[i] != 0) {
+            icon_path = sysapp_icon_path(key, app_path, resource);
         } else {
-            apps.push_back(entry);
+            WuhbFile bundle(resource);
+            WuhbMeta meta(resource);
+            bool bundle_has_icon = is_wuhb_path(app_path.c_str()) && bundle.open(app_path.c_str()) && bundle.read_meta(meta) && meta.has_icon;
+            std::pmr::string app_dir = app_path.substr(0, app_path.rfind('/'));
+            icon_path = homebrew_icon_path(key, app_dir, app_path, bundle_has_icon, resource);
+        }
+        library.cold.icon_path[i] = library_strings.intern(icon_path);
+
+        // Same path or not, the file behind it changed. Icons nothing loaded
+        // yet are loaded from the new path whenever they are.
+        if (library.hot.icon[i] || i < LIBRARY_HOME_ICONS) {
+            if (library.hot.icon[i]) SDL_DestroyTexture(library.hot.icon[i]);
+            library.hot.icon[i] = icon_path.empty() ? nullptr : load_icon(icon_path.c_str(), renderer);
+            library.hot.background[i] = { 0, 0, 0, 255 };
+            render_icon_background_color(renderer, library.hot.icon[i], library.hot.background[i]);
         }
-        printf("Loaded system app: %s -> %s\n", entry.title.c_str(), entry.app_path.c_str());
+        library.layout_valid = false;
+        changed.push_back(i);
+        LOG_INFO(LOG_CAT_SCAN, "Reloaded icon of %s", library.cold.title[i]);
     }
-    MCP_Close(handle);
+}
 
-    const char* path_char = SD_CARD_PATH "scanresult.txt";
-    std::string path = path_char;
-    FILE* out = fopen(path.c_str(), "w");
-    for (auto app : apps) {
-        fprintf(out,    "App: %s, Path: %s, Device: %s, TitleID: %llu\n",
-               app.title.c_str(), app.app_path.c_str(), app.storage_device.c_str(), app.titleid);
+static bool name_listed(const std::vector<std::string>& names, std::string_view name) {
+    return std::find(names.begin(), names.end(), name) != names.end();
+}
+
+bool library_hide(const std::vector<std::string>& names) {
+    TRACE_FUNCTION();
+    bool removed = false;
+    for (size_t i = library.size(); i-- > 0;) {
+        if (!name_listed(names, library_entry_key(i))) continue;
+        LOG_INFO(LOG_CAT_SCAN, "Hiding ignored app: %s", library.cold.title[i]);
+        library_remove(i);
+        removed = true;
     }
-    fclose(out);
+    return removed;
+}
+
+bool library_unhide(const std::vector<std::string>& names, SDL_Renderer* renderer) {
+    TRACE_FUNCTION();
+    std::pmr::memory_resource* resource = std::pmr::get_default_resource();
+    IgnoreList ignored_apps = load_ignored_apps(resource);
+    size_t count = library.size();
+
+    // Added at the end, the next full scan puts them back in scan order
+    if (load_homebrew_titles) {
+        for (const std::string& name : names) {
+            std::pmr::string app_folder(name, resource);
+            std::pmr::string app_path = concat(resource, SD_CARD_PATH "wiiu/apps/", app_folder);
+            std::pmr::string launch_file = find_launchable_file(app_path, resource);
+            if (launch_file.empty()) continue;
+
+            bool present = false;
+            for (const char* path : library.cold.app_path) present = present || launch_file == path;
+            if (present) continue;
+
+            ScannedApp app(resource);
+            resolve_homebrew(app_folder, app_path, launch_file, app, resource);
+            add_scanned_app(app, library.size() < LIBRARY_HOME_ICONS, renderer);
+            LOG_INFO(LOG_CAT_SCAN, "Unhiding app: %s", library.cold.title.back());
+        }
+    }
+
+    std::pmr::vector<PlatformTitle> titles(resource);
+    if (platform_list_titles(titles)) {
+        for (const auto& game : titles) {
+            auto& ids = library.cold.titleid;
+            if (std::find(ids.begin(), ids.end(), game.title_id) != ids.end()) continue;
+
+            // Only what ignore.txt stopped listing, not anything else that's missing
+            std::pmr::string title = get_longname_from_meta(concat(resource, ROOT_PATH, game.path, "/meta/meta.xml").c_str(), resource);
+            if (!name_listed(names, sanitize_title_for_path(title, resource))) continue;
+
+            bool with_icon = library.size() < LIBRARY_HOME_ICONS || strcmp(game.device, "odd") == 0;
+            if (!create_sysapp_entry(game, ignored_apps, with_icon, renderer, resource)) continue;
+            LOG_INFO(LOG_CAT_SCAN, "Unhiding system app: %s", library.cold.title.back());
+            if (library.cold.device.back() == DEVICE_ODD) library_move_last_to_front();
+        }
+    }
+
+    if (library.size() == count) return false;
+
+    // The disc title moving to the front shifts every index
+    library.generation++;
+    return true;
+}
+
+static void fingerprint_add(uint64_t& hash, const void* data, size_t size) {
+    // FNV-1a
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+}
+
+// Entry names of a directory in a fixed order, readdir() doesn't promise one
+static std::vector<std::string> sorted_entries(const char* path) {
+    std::vector<std::string> names;
+    DIR* dir = opendir(path);
+    if (!dir) return names;
+
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (strcmp(entry->d_name, ".") && strcmp(entry->d_name, "..")) names.push_back(entry->d_name);
+    }
+    closedir(dir);
+
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+uint64_t library_fingerprint(bool homebrew_titles) {
+    uint64_t hash = 14695981039346656037ull;
+    fingerprint_add(hash, &homebrew_titles, sizeof(homebrew_titles));
+
+    FILE* ignore = fopen(SD_CARD_PATH "switchU/ignore.txt", "rb");
+    if (ignore) {
+        char buffer[512];
+        size_t size;
+        while ((size = fread(buffer, 1, sizeof(buffer), ignore)) > 0) fingerprint_add(hash, buffer, size);
+        fclose(ignore);
+    }
+
+    if (homebrew_titles) {
+        for (const auto& name : sorted_entries(SD_CARD_PATH "wiiu/apps")) {
+            std::pmr::string launch_file = find_launchable_file(std::pmr::string(SD_CARD_PATH "wiiu/apps/" + name), std::pmr::get_default_resource());
+            fingerprint_add(hash, name.data(), name.size() + 1);
+            fingerprint_add(hash, launch_file.data(), launch_file.size() + 1);
+        }
+    }
+
+    for (const auto& name : sorted_entries(SD_CARD_PATH "switchU/custom_icons")) {
+        fingerprint_add(hash, name.data(), name.size() + 1);
+    }
+
+    std::pmr::vector<PlatformTitle> titles;
+    platform_list_titles(titles);
+    for (const auto& title : titles) {
+        fingerprint_add(hash, &title.title_id, sizeof(title.title_id));
+        fingerprint_add(hash, title.path, strlen(title.path) + 1);
+        fingerprint_add(hash, title.device, strlen(title.device) + 1);
+    }
+
+    return hash;
 }
 
-const char* get_selected_app_path() {
-    if (apps.empty()) return nullptr;
-    const std::string& full_path = apps[cur_selected_tile].app_path;
-    size_t pos = full_path.find("wiiu/apps/");
-    if (pos == std::string::npos) return nullptr;
-    printf("Selected index: %d, full path: %s, trimmed path: %s\n", cur_selected_tile, full_path.c_str(), full_path.c_str() + pos);
-    return full_path.c_str() + pos;
+const char* get_app_path(size_t index) {
+    if (index >= library.size()) return nullptr;
+    const char* full_path = library.cold.app_path[index];
+    const char* trimmed = strstr(full_path, "wiiu/apps/");
+    if (!trimmed) return nullptr;
+    LOG_DEBUG(LOG_CAT_SCAN, "Selected index: %d, full path: %s, trimmed path: %s", (int)index, full_path, trimmed);
+    return trimmed;
 }
@@ -1,40 +1,133 @@
 #pragma once
 
-#include <coreinit/mcp.h>
 #include <SDL2/SDL.h>
+#include <cstdint>
+#include <memory_resource>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
-struct App {
-    std::string title;
-    std::string app_path;
-    std::string storage_device;
-    uint64_t titleid;
-    SDL_Texture* icon;
+#include "platform/platform.hpp"
+#include "string_pool.hpp"
+
+enum StorageDevice : uint8_t {
+    DEVICE_SD,
+    DEVICE_MLC,
+    DEVICE_USB,
+    DEVICE_ODD
+};
+
+// The library is kept as parallel arrays, one element per app. The draw loop
+// only walks the hot ones; the cold ones are read when an app is selected or
+// launched. Strings live in library_strings.
+struct LibraryHot {
+    std::vector<SDL_Texture*> icon;
+    std::vector<SDL_Color> background;  // sampled once from the icon
+    std::vector<SDL_Rect> tile;         // camera space, set by the layout
+    std::vector<SDL_Rect> icon_rect;    // camera space, set by the layout
+};
+
+struct LibraryCold {
+    std::vector<const char*> title;
+    std::vector<const char*> app_path;
+    std::vector<const char*> icon_path;  // where the icon was loaded from, empty if it wasn't
+    std::vector<StorageDevice> device;
+    std::vector<uint64_t> titleid;      // 0 for homebrew
 };
 
-static const std::vector<MCPAppType> supported_sys_app_type {
-    MCP_APP_TYPE_GAME,
-    MCP_APP_TYPE_GAME_WII
+struct Library {
+    LibraryHot hot;
+    LibraryCold cold;
+    bool layout_valid = false;          // cleared whenever entries change
+    uint32_t generation = 0;            // bumped by library_clear(), indices from before don't hold
+
+    size_t size() const { return hot.icon.size(); }
+    bool empty() const { return hot.icon.empty(); }
 };
 
-static const char device_odd[10] = "odd";
-static const char device_usb[10] = "usb";
-static const char device_mlc[10] = "mlc";
+// Icons the scan loads itself, the home row's. Every other entry is added
+// with its icon_path only and whatever shows it loads the icon.
+constexpr size_t LIBRARY_HOME_ICONS = 12;
+
+// Folder names and sanitized titles from ignore.txt
+using IgnoreList = std::pmr::unordered_set<std::pmr::string>;
 
-extern std::vector<App> apps;
+extern Library library;
+extern StringPool library_strings;
 extern int cur_selected_tile;
 
+StorageDevice storage_device_from_name(const char* name);
+const char* storage_device_name(StorageDevice device);
+
+// Appends an app, the library takes ownership of icon. Strings must be
+// interned in library_strings.
+void library_add(SDL_Texture* icon, const char* icon_path, const char* title, const char* app_path, StorageDevice device, uint64_t titleid, SDL_Renderer* renderer);
+// Same, with the icon's background colour already known
+void library_add_entry(SDL_Texture* icon, SDL_Color background, const char* icon_path, const char* title, const char* app_path, StorageDevice device, uint64_t titleid);
+
+// Removes one entry and destroys its icon, the ones after it move down
+void library_remove(size_t index);
+
+// Destroys every icon and empties the library and its strings
+void library_clear();
+
 SDL_Texture* load_texture(const char* path, SDL_Renderer* renderer);
 
-// Parses and returns the <name> from a given meta.xml path
-std::string get_title_from_meta(const char* path);
+// Loads an app icon, iconTex.tga, the icon inside a .wuhb bundle or any
+// format SDL_image detects
+SDL_Texture* load_icon(const char* path, SDL_Renderer* renderer);
+
+// Loads the icons of entries [first, last) that were added without one but
+// know where it lives, e.g. everything restored from a snapshot. Entries a
+// scan added that way don't know their background yet, sample_background
+// reads it back from the icon.
+void library_load_icons(size_t first, size_t last, SDL_Renderer* renderer, bool sample_background = false);
+
+// Hash of everything a scan's result depends on that is cheap to look at:
+// the title list, homebrew folders, custom icon folders and ignore.txt.
+// Doesn't touch the library or SDL, safe to call from another thread.
+uint64_t library_fingerprint(bool homebrew_titles);
+
+// Parses and returns the <name> from a homebrew app's meta.xml, empty if there is none
+std::pmr::string get_title_from_meta(const char* path, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+// Parses and returns the <longname_en> from a title's meta.xml, empty if there is none
+std::pmr::string get_longname_from_meta(const char* path, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 
-// Returns a new App entry for a system app with icon and all
-App create_sysapp_entry(const MCPTitleListType& title_info, SDL_Renderer* renderer);
+IgnoreList load_ignored_apps(std::pmr::memory_resource* resource);
 
-// Fills the apps vector with valid launchable apps (populates icon, launch_path, etc.)
+// Adds a system app to the library, returns false if it is ignored. The icon
+// is only loaded if with_icon is set. Temporaries are allocated from resource.
+bool create_sysapp_entry(const PlatformTitle& title_info, const IgnoreList& ignored_apps, bool with_icon, SDL_Renderer* renderer, std::pmr::memory_resource* resource);
+
+// Fills the library with valid launchable apps (populates icon, launch_path, etc.).
+// Everything it allocates along the way comes from a scan arena.
 void scan_apps(SDL_Renderer* renderer);
 
-// Returns the selected app's path to pass into RPXLoader_LaunchHomebrew()
-const char* get_selected_app_path();
\ No newline at end of file
+// The same scan for the main loop: the SD card and title list are read on a
+// background thread and scan_apps_poll() swaps the result in once it is
+// ready, returning true. Entries that were already there keep their icons,
+// new ones come in without and load with library_load_icons(..., true).
+// A result the library changed under since the start is dropped instead.
+void scan_apps_start(bool homebrew_titles);
+bool scan_apps_poll();
+// Waits for a rescan that is still running
+void scan_apps_shutdown();
+
+// Name an entry goes by in ignore.txt and custom_icons/: the app's folder
+// for homebrew, the sanitized title for system titles
+std::pmr::string library_entry_key(size_t index, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+// custom_icons/<folder>/ changed: finds the icon again for the entries known
+// by that name and reloads it where it was loaded. Appends those entries to
+// changed.
+void library_reload_custom_icon(const char* folder, SDL_Renderer* renderer, std::vector<size_t>& changed);
+
+// ignore.txt started or stopped listing names: removes the entries they match,
+// or adds back the apps and titles they match without rescanning the rest.
+// Both return true if the library changed.
+bool library_hide(const std::vector<std::string>& names);
+bool library_unhide(const std::vector<std::string>& names, SDL_Renderer* renderer);
+
+// Returns an app's path to pass into RPXLoader_LaunchHomebrew()
+const char* get_app_path(size_t index);
\ No newline at end of file
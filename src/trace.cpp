@@ -0,0 +1,120 @@
+#ifdef SWITCHU_TRACE
+
+#include <chrono>
+#include <cstdio>
+
+#include "log.hpp"
+#include "trace.hpp"
+
+std::atomic<bool> trace_capturing{false};
+
+namespace {
+    // 24 bytes each, allocated on the first capture and kept
+    constexpr uint32_t MAX_EVENTS = 64 * 1024;
+    constexpr uint32_t MAX_THREADS = 16;
+
+    // name is stored last and read first, a slot whose name is still null
+    // was claimed but isn't written yet
+    struct Event {
+        std::atomic<const char*> name;
+        uint64_t start_us;
+        uint32_t duration_us;
+        uint32_t thread;
+    };
+
+    Event* events = nullptr;
+    std::atomic<uint32_t> event_count{0};
+
+    std::atomic<uint32_t> thread_count{0};
+    std::atomic<const char*> thread_names[MAX_THREADS];
+
+    const auto start_time = std::chrono::steady_clock::now();
+
+    uint32_t thread_id() {
+        static thread_local uint32_t id = thread_count.fetch_add(1, std::memory_order_relaxed);
+        return id;
+    }
+}
+
+uint64_t trace_now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+void trace_set_thread_name(const char* name) {
+    uint32_t id = thread_id();
+    if (id < MAX_THREADS) thread_names[id].store(name, std::memory_order_relaxed);
+}
+
+void trace_record(const char* name, uint64_t start_us, uint64_t end_us) {
+    uint32_t index = event_count.fetch_add(1, std::memory_order_relaxed);
+    if (index >= MAX_EVENTS) return;
+    Event& event = events[index];
+    event.start_us = start_us;
+    event.duration_us = (uint32_t)(end_us - start_us);
+    event.thread = thread_id();
+    event.name.store(name, std::memory_order_release);
+}
+
+void trace_start() {
+    if (!events) events = new Event[MAX_EVENTS]();
+
+    // The last capture's slots, so none of them passes for written in this one
+    uint32_t used = event_count.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < used && i < MAX_EVENTS; ++i) events[i].name.store(nullptr, std::memory_order_relaxed);
+    event_count.store(0, std::memory_order_relaxed);
+    trace_capturing.store(true, std::memory_order_release);
+    LOG_INFO(LOG_CAT_MAIN, "Trace capture started");
+}
+
+void trace_stop(const char* path) {
+    if (!trace_capturing.exchange(false)) return;
+
+    uint32_t count = event_count.load();
+    uint32_t written = count < MAX_EVENTS ? count : MAX_EVENTS;
+
+    FILE* out = fopen(path, "w");
+    if (!out) {
+        LOG_ERROR(LOG_CAT_MAIN, "Failed to open %s for writing", path);
+        return;
+    }
+
+    fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    const char* separator = "\n";
+    uint32_t threads = thread_count.load();
+    for (uint32_t i = 0; i < threads && i < MAX_THREADS; ++i) {
+        const char* name = thread_names[i].load(std::memory_order_relaxed);
+        fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                separator, i, name ? name : "worker");
+        separator = ",\n";
+    }
+    uint32_t unfinished = 0;
+    for (uint32_t i = 0; i < written; ++i) {
+        const Event& event = events[i];
+        // A worker still filling it in
+        const char* name = event.name.load(std::memory_order_acquire);
+        if (!name) {
+            unfinished++;
+            continue;
+        }
+        fprintf(out, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%llu,\"dur\":%u}",
+                separator, name, event.thread, (unsigned long long)event.start_us, event.duration_us);
+        separator = ",\n";
+    }
+    fprintf(out, "\n]}\n");
+    fclose(out);
+
+    if (count > MAX_EVENTS) {
+        LOG_WARN(LOG_CAT_MAIN, "Trace buffer full, %u events dropped", count - MAX_EVENTS);
+    }
+    LOG_INFO(LOG_CAT_MAIN, "Wrote %u trace events to %s", written - unfinished, path);
+}
+
+void trace_toggle(const char* path) {
+    if (trace_capturing.load()) {
+        trace_stop(path);
+    } else {
+        trace_start();
+    }
+}
+
+#endif
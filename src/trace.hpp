@@ -0,0 +1,70 @@
+#pragma once
+
+// Scoped timing events, written out in Chrome's trace-event format so a
+// session can be opened in chrome://tracing or Perfetto.
+//
+// Only compiled in with TRACE=1 (SWITCHU_TRACE), otherwise every macro below
+// is empty. When compiled in but not capturing, a scope costs one relaxed
+// load and a branch.
+//
+// Trace builds start capturing at boot. ZL+ZR stops the capture and writes
+// it to TRACE_PATH, pressing them again starts a new one.
+
+#include "platform/platform.hpp"
+
+#define TRACE_PATH SD_CARD_PATH "switchU/trace.json"
+
+#ifdef SWITCHU_TRACE
+
+#include <atomic>
+#include <cstdint>
+
+extern std::atomic<bool> trace_capturing;
+
+void trace_start();
+// Stops capturing and writes every event since trace_start() to path
+void trace_stop(const char* path);
+void trace_toggle(const char* path);
+
+// Names the calling thread in the trace, threads are otherwise numbered
+void trace_set_thread_name(const char* name);
+
+uint64_t trace_now_us();
+// name must outlive the capture, string literals and __func__ do
+void trace_record(const char* name, uint64_t start_us, uint64_t end_us);
+
+class TraceScope {
+public:
+    explicit TraceScope(const char* name) : name(trace_capturing.load(std::memory_order_relaxed) ? name : nullptr) {
+        if (this->name) start_us = trace_now_us();
+    }
+
+    ~TraceScope() {
+        if (name) trace_record(name, start_us, trace_now_us());
+    }
+
+private:
+    const char* name;
+    uint64_t start_us = 0;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#define TRACE_FUNCTION() TRACE_SCOPE(__func__)
+#define TRACE_THREAD_NAME(name) trace_set_thread_name(name)
+#define TRACE_START() trace_start()
+#define TRACE_STOP() trace_stop(TRACE_PATH)
+#define TRACE_TOGGLE() trace_toggle(TRACE_PATH)
+
+#else
+
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_FUNCTION() ((void)0)
+#define TRACE_THREAD_NAME(name) ((void)0)
+#define TRACE_START() ((void)0)
+#define TRACE_STOP() ((void)0)
+#define TRACE_TOGGLE() ((void)0)
+
+#endif
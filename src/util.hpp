@@ -1,12 +1,9 @@
 #pragma once
 
+#include <memory_resource>
 #include <string>
+#include <string_view>
 
-#define ROOT_PATH "fs:"
-#define SD_CARD_PATH "fs:/vol/external01/"
+#include "platform/platform.hpp"
 
-extern std::string ACCOUNT_ID;
-
-void get_user_information();
-
-std::string sanitize_title_for_path(const std::string& title);
+std::pmr::string sanitize_title_for_path(std::string_view title, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
@@ -0,0 +1,217 @@
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+
+#include "log.hpp"
+#include "trace.hpp"
+#include "wuhb.hpp"
+
+namespace {
+    // RomFS header as wuhbtool writes it, every field big endian
+    constexpr uint32_t WUHB_MAGIC = 0x57554842; // "WUHB"
+    constexpr size_t HEADER_SIZE = 0x50;
+    constexpr size_t DIR_ENTRY_SIZE = 0x18;     // parent, sibling, child dir, child file, next hash, name length
+    constexpr size_t FILE_ENTRY_SIZE = 0x20;    // parent, sibling, data offset (64), data size (64), next hash, name length
+    constexpr uint32_t NO_ENTRY = 0xFFFFFFFF;
+
+    // Real bundles have a handful of entries, anything near this is not one
+    constexpr uint64_t MAX_TABLES_SIZE = 1024 * 1024;
+    constexpr uint64_t MAX_META_SIZE = 64 * 1024;
+    constexpr uint64_t MAX_ICON_SIZE = 1024 * 1024;
+
+    uint32_t read_be32(const uint8_t* p) {
+        return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+    }
+
+    uint64_t read_be64(const uint8_t* p) {
+        return ((uint64_t)read_be32(p) << 32) | read_be32(p + 4);
+    }
+
+    bool read_at(FILE* file, uint64_t offset, void* data, size_t size) {
+        if (fseeko(file, (off_t)offset, SEEK_SET) != 0) return false;
+        return fread(data, 1, size, file) == size;
+    }
+
+    // "key=value" lines of the [menu] section
+    void parse_meta_ini(const char* text, size_t size, WuhbMeta& meta) {
+        std::string_view ini(text, size);
+        std::pmr::string short_name(meta.name.get_allocator().resource());
+        bool in_menu = false;
+
+        while (!ini.empty()) {
+            size_t end = ini.find('\n');
+            std::string_view line = ini.substr(0, end);
+            ini.remove_prefix(end == std::string_view::npos ? ini.size() : end + 1);
+
+            while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) line.remove_suffix(1);
+            while (!line.empty() && line.front() == ' ') line.remove_prefix(1);
+            if (line.empty() || line[0] == ';' || line[0] == '#') continue;
+
+            if (line[0] == '[') {
+                in_menu = line == "[menu]";
+                continue;
+            }
+            if (!in_menu) continue;
+
+            size_t equals = line.find('=');
+            if (equals == std::string_view::npos) continue;
+            std::string_view key = line.substr(0, equals);
+            std::string_view value = line.substr(equals + 1);
+
+            if (key == "longname") meta.name = value;
+            else if (key == "shortname") short_name = value;
+            else if (key == "author") meta.author = value;
+        }
+
+        if (meta.name.empty()) meta.name = short_name;
+    }
+}
+
+bool is_wuhb_path(const char* path) {
+    size_t length = strlen(path);
+    return length >= 5 && strcmp(path + length - 5, ".wuhb") == 0;
+}
+
+WuhbFile::WuhbFile(std::pmr::memory_resource* resource) : tables(resource) {
+}
+
+WuhbFile::~WuhbFile() {
+    close();
+}
+
+bool WuhbFile::open(const char* path) {
+    TRACE_FUNCTION();
+    close();
+
+    file = fopen(path, "rb");
+    if (!file) return false;
+
+    // Every read is a seek somewhere else, stdio's buffer would only double them
+    setvbuf(file, nullptr, _IONBF, 0);
+
+    uint8_t header[HEADER_SIZE];
+    if (!read_at(file, 0, header, sizeof(header)) || read_be32(header) != WUHB_MAGIC) {
+        LOG_WARN(LOG_CAT_SCAN, "Not a wuhb bundle: %s", path);
+        close();
+        return false;
+    }
+
+    uint64_t dir_offset = read_be64(header + 0x18);
+    dir_table_size = read_be64(header + 0x20);
+    uint64_t file_offset = read_be64(header + 0x38);
+    file_table_size = read_be64(header + 0x40);
+    data_offset = read_be64(header + 0x48);
+
+    // wuhbtool writes the tables back to back, with the file hash table
+    // between them; one read covers both
+    bool sane = dir_table_size >= DIR_ENTRY_SIZE && dir_table_size <= MAX_TABLES_SIZE && file_table_size <= MAX_TABLES_SIZE &&
+                dir_offset <= UINT32_MAX && file_offset <= UINT32_MAX;
+    tables_offset = std::min(dir_offset, file_offset);
+    uint64_t tables_end = std::max(dir_offset + dir_table_size, file_offset + file_table_size);
+    if (!sane || tables_end - tables_offset > MAX_TABLES_SIZE) {
+        LOG_WARN(LOG_CAT_SCAN, "Bad wuhb tables in %s", path);
+        close();
+        return false;
+    }
+
+    tables.resize(tables_end - tables_offset);
+    if (!read_at(file, tables_offset, tables.data(), tables.size())) {
+        LOG_WARN(LOG_CAT_SCAN, "Truncated wuhb bundle: %s", path);
+        close();
+        return false;
+    }
+    dir_table = dir_offset - tables_offset;
+    file_table = file_offset - tables_offset;
+    return true;
+}
+
+void WuhbFile::close() {
+    if (file) fclose(file);
+    file = nullptr;
+    tables.clear();
+}
+
+uint32_t WuhbFile::find_child_dir(uint32_t dir, const char* name, size_t length) const {
+    const uint8_t* base = tables.data() + dir_table;
+    uint32_t child = read_be32(base + dir + 8);
+
+    // The chains are bounded by the table size in case a bundle loops them
+    for (size_t steps = 0; child != NO_ENTRY && steps < dir_table_size / DIR_ENTRY_SIZE; ++steps) {
+        if ((uint64_t)child + DIR_ENTRY_SIZE > dir_table_size) return NO_ENTRY;
+        const uint8_t* entry = base + child;
+        uint32_t name_length = read_be32(entry + 0x14);
+        if ((uint64_t)child + DIR_ENTRY_SIZE + name_length > dir_table_size) return NO_ENTRY;
+
+        if (name_length == length && memcmp(entry + DIR_ENTRY_SIZE, name, length) == 0) return child;
+        child = read_be32(entry + 4);
+    }
+    return NO_ENTRY;
+}
+
+uint32_t WuhbFile::find_child_file(uint32_t dir, const char* name, size_t length) const {
+    const uint8_t* files = tables.data() + file_table;
+    uint32_t child = read_be32(tables.data() + dir_table + dir + 12);
+
+    for (size_t steps = 0; child != NO_ENTRY && steps < file_table_size / FILE_ENTRY_SIZE; ++steps) {
+        if ((uint64_t)child + FILE_ENTRY_SIZE > file_table_size) return NO_ENTRY;
+        const uint8_t* entry = files + child;
+        uint32_t name_length = read_be32(entry + 0x1C);
+        if ((uint64_t)child + FILE_ENTRY_SIZE + name_length > file_table_size) return NO_ENTRY;
+
+        if (name_length == length && memcmp(entry + FILE_ENTRY_SIZE, name, length) == 0) return child;
+        child = read_be32(entry + 4);
+    }
+    return NO_ENTRY;
+}
+
+bool WuhbFile::find(const char* path, Entry& entry) const {
+    if (!file) return false;
+
+    // Walks down from the root, which is the first directory entry
+    uint32_t dir = 0;
+    const char* part = path;
+    while (const char* slash = strchr(part, '/')) {
+        dir = find_child_dir(dir, part, slash - part);
+        if (dir == NO_ENTRY) return false;
+        part = slash + 1;
+    }
+
+    uint32_t found = find_child_file(dir, part, strlen(part));
+    if (found == NO_ENTRY) return false;
+
+    const uint8_t* record = tables.data() + file_table + found;
+    entry.offset = data_offset + read_be64(record + 8);
+    entry.size = read_be64(record + 16);
+    return true;
+}
+
+bool WuhbFile::read_file(const char* path, std::vector<uint8_t>& data) {
+    Entry entry;
+    if (!find(path, entry)) return false;
+
+    data.resize(entry.size);
+    return read_at(file, entry.offset, data.data(), data.size());
+}
+
+bool WuhbFile::read_meta(WuhbMeta& meta) {
+    TRACE_FUNCTION();
+    Entry entry;
+    if (!find("meta/meta.ini", entry) || entry.size > MAX_META_SIZE) return false;
+
+    std::pmr::vector<char> text(entry.size, tables.get_allocator().resource());
+    if (!read_at(file, entry.offset, text.data(), text.size())) return false;
+    parse_meta_ini(text.data(), text.size(), meta);
+
+    Entry icon;
+    meta.has_icon = find("meta/iconTex.tga", icon);
+    return true;
+}
+
+bool WuhbFile::read_icon(std::vector<uint8_t>& data) {
+    TRACE_FUNCTION();
+    Entry entry;
+    if (!find("meta/iconTex.tga", entry) || entry.size > MAX_ICON_SIZE) return false;
+
+    data.resize(entry.size);
+    return read_at(file, entry.offset, data.data(), data.size());
+}
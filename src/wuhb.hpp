@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+// What a .wuhb bundle says about itself, from its meta/meta.ini
+struct WuhbMeta {
+    std::pmr::string name;          // longname, or shortname if there is none
+    std::pmr::string author;
+    bool has_icon = false;          // the bundle holds a meta/iconTex.tga
+
+    explicit WuhbMeta(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : name(resource), author(resource) {}
+};
+
+// Reads single files out of a .wuhb bundle, a RomFS image as written by
+// wuhbtool. Opening reads the header and the directory and file tables, a
+// few KB at the start; each file asked for is then one more read at its
+// offset. Nothing else in the bundle, the .rpx and content/, is touched.
+class WuhbFile {
+public:
+    explicit WuhbFile(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+    ~WuhbFile();
+
+    WuhbFile(const WuhbFile&) = delete;
+    WuhbFile& operator=(const WuhbFile&) = delete;
+
+    bool open(const char* path);
+    void close();
+
+    // Parses meta/meta.ini, false if the bundle has none
+    bool read_meta(WuhbMeta& meta);
+
+    // meta/iconTex.tga as it is stored, false if the bundle has none
+    bool read_icon(std::vector<uint8_t>& data);
+
+    // Any file by its path inside the bundle, e.g. "meta/meta.ini"
+    bool read_file(const char* path, std::vector<uint8_t>& data);
+
+private:
+    struct Entry {
+        uint64_t offset;    // from the start of the bundle
+        uint64_t size;
+    };
+
+    bool find(const char* path, Entry& entry) const;
+    uint32_t find_child_dir(uint32_t dir, const char* name, size_t length) const;
+    uint32_t find_child_file(uint32_t dir, const char* name, size_t length) const;
+
+    FILE* file = nullptr;
+    std::pmr::vector<uint8_t> tables;   // the directory and file tables, read at once
+    uint64_t tables_offset = 0;
+    uint64_t dir_table = 0;             // offsets into tables
+    uint64_t dir_table_size = 0;
+    uint64_t file_table = 0;
+    uint64_t file_table_size = 0;
+    uint64_t data_offset = 0;
+};
+
+// True for paths ending in .wuhb, which load_icon() and decode_image_scaled()
+// take as "the icon inside this bundle"
+bool is_wuhb_path(const char* path);
@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "asset_pack_format.hpp"
+
+// Packs an assets folder into one file for the launcher, see
+// src/asset_pack.hpp. Runs on the build machine, so it only needs the
+// standard library.
+
+namespace fs = std::filesystem;
+
+static void usage(const char* argv0) {
+    fprintf(stderr,
+            "usage: %s [options] DIR OUT\n"
+            "Packs every file under DIR into OUT.\n"
+            "  --exclude PATH    leave out PATH, a file or a folder ending in '/' (repeatable)\n",
+            argv0);
+}
+
+struct Asset {
+    std::string name;
+    std::vector<char> data;
+};
+
+static bool excluded(const std::string& name, const std::vector<std::string>& excludes) {
+    for (const std::string& exclude : excludes) {
+        bool folder = !exclude.empty() && exclude.back() == '/';
+        if (folder ? name.compare(0, exclude.size(), exclude) == 0 : name == exclude) return true;
+    }
+    return false;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> excludes;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--exclude" && i + 1 < argc) excludes.push_back(argv[++i]);
+        else if (arg.rfind("--", 0) == 0) {
+            usage(argv[0]);
+            return 1;
+        } else paths.push_back(arg);
+    }
+    if (paths.size() != 2) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const fs::path root = paths[0];
+    std::vector<Asset> assets;
+    std::error_code error;
+    for (fs::recursive_directory_iterator it(root, error), end; !error && it != end; it.increment(error)) {
+        if (!it->is_regular_file()) continue;
+        std::string name = it->path().lexically_relative(root).generic_string();
+        if (excluded(name, excludes)) continue;
+        if (name.size() >= (size_t)ASSET_PACK_NAME_SIZE) {
+            fprintf(stderr, "%s: name longer than %d characters\n", name.c_str(), ASSET_PACK_NAME_SIZE - 1);
+            return 1;
+        }
+
+        std::ifstream file(it->path(), std::ios::binary);
+        Asset asset = { name, std::vector<char>(std::istreambuf_iterator<char>(file), {}) };
+        if (!file.good() && !file.eof()) {
+            fprintf(stderr, "%s: couldn't read\n", it->path().c_str());
+            return 1;
+        }
+        assets.push_back(std::move(asset));
+    }
+    if (error) {
+        fprintf(stderr, "%s: %s\n", root.c_str(), error.message().c_str());
+        return 1;
+    }
+
+    // Sorted by strcmp() order, the launcher binary searches the index
+    std::sort(assets.begin(), assets.end(), [](const Asset& a, const Asset& b) {
+        return strcmp(a.name.c_str(), b.name.c_str()) < 0;
+    });
+
+    std::vector<uint8_t> pack(sizeof(AssetPackHeader) + assets.size() * sizeof(AssetPackEntry));
+    AssetPackHeader header = {};
+    memcpy(header.magic, ASSET_PACK_MAGIC, sizeof(header.magic));
+    asset_pack_put32(header.version, ASSET_PACK_VERSION);
+    asset_pack_put32(header.count, assets.size());
+    memcpy(pack.data(), &header, sizeof(header));
+
+    for (size_t i = 0; i < assets.size(); ++i) {
+        pack.resize((pack.size() + ASSET_PACK_ALIGN - 1) / ASSET_PACK_ALIGN * ASSET_PACK_ALIGN);
+
+        AssetPackEntry entry = {};
+        strncpy(entry.name, assets[i].name.c_str(), sizeof(entry.name) - 1);
+        asset_pack_put32(entry.offset, pack.size());
+        asset_pack_put32(entry.size, assets[i].data.size());
+        memcpy(pack.data() + sizeof(AssetPackHeader) + i * sizeof(AssetPackEntry), &entry, sizeof(entry));
+
+        pack.insert(pack.end(), assets[i].data.begin(), assets[i].data.end());
+    }
+
+    FILE* out = fopen(paths[1].c_str(), "wb");
+    if (!out || fwrite(pack.data(), 1, pack.size(), out) != pack.size() || fclose(out) != 0) {
+        fprintf(stderr, "%s: couldn't write\n", paths[1].c_str());
+        return 1;
+    }
+    printf("%s: %zu assets, %zu bytes\n", paths[1].c_str(), assets.size(), pack.size());
+    return 0;
+}
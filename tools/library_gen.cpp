@@ -0,0 +1,508 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <jpeglib.h>
+
+#include "library_gen.hpp"
+#include "platform/mcp_standin.hpp"
+#include "util.hpp"
+
+namespace {
+    const char* title_names[] = {
+        "MARIO KART 8", "Splatoon", "Super Mario Maker", "PIKMIN 3", "Nintendo Land",
+        "SUPER MARIO 3D WORLD", "Captain Toad: Treasure Tracker", "Mario Party 10",
+        "Kirby and the Rainbow Curse", "Minecraft: Wii U Edition", "Wii Sports Club",
+        "The Legend of Zelda: Breath of the Wild", "Xenoblade Chronicles X", "Bayonetta 2",
+    };
+    constexpr int title_name_count = sizeof(title_names) / sizeof(title_names[0]);
+
+    const char* homebrew_names[] = {
+        "homebrew_launcher", "Dumpling", "wiiu-vnc", "retroarch", "ftpiiu", "SaveMii",
+        "WUPInstaller", "Bloopair", "nanddumper", "CHIP8", "Tiramisu", "HBAppStore",
+    };
+    constexpr int homebrew_name_count = sizeof(homebrew_names) / sizeof(homebrew_names[0]);
+
+    // What each app calls itself in its meta.xml or bundle
+    const char* homebrew_titles[homebrew_name_count] = {
+        "Homebrew Launcher", "Dumpling", "Wii U VNC Viewer", "RetroArch", "ftpiiu", "SaveMii",
+        "WUP Installer GX2", "Bloopair", "NAND Dumper", "CHIP-8 Emulator", "Tiramisu", "Homebrew App Store",
+    };
+
+    // Title IDs per device, so titles keep their ID whatever the other counts are
+    constexpr uint32_t mlc_title_base = 0x10100000;
+    constexpr uint32_t usb_title_base = 0x10200000;
+    constexpr uint32_t odd_title_base = 0x10300000;
+
+    struct Title {
+        uint32_t low;
+        const char* device;
+        std::string path;
+        std::string name;
+    };
+
+    bool make_dirs(const std::string& path) {
+        for (size_t pos = 1; pos <= path.size(); ++pos) {
+            if (pos == path.size() || path[pos] == '/') {
+                std::string part = path.substr(0, pos);
+                if (mkdir(part.c_str(), 0755) != 0 && errno != EEXIST) {
+                    fprintf(stderr, "mkdir %s failed: %s\n", part.c_str(), strerror(errno));
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    bool write_file(const std::string& path, const void* data, size_t size) {
+        FILE* file = fopen(path.c_str(), "wb");
+        if (!file) {
+            fprintf(stderr, "Failed to write %s\n", path.c_str());
+            return false;
+        }
+        fwrite(data, 1, size, file);
+        fclose(file);
+        return true;
+    }
+
+    std::string device_title_path(uint32_t low, const char* device, bool on_sd) {
+        char id[9];
+        snprintf(id, sizeof(id), "%08X", low);
+        // MCP paths are at most 55 characters, keep the SD ones short too
+        if (on_sd) return std::string("/vol/external01/fake_titles/") + device + "/" + id;
+        return std::string("/vol/storage_") + device + "01/usr/title/00050000/" + id;
+    }
+
+    // Same shape as a real iconTex.tga: 128x128, 32bpp, uncompressed
+    std::vector<unsigned char> make_tga(int seed) {
+        const int size = 128;
+        std::vector<unsigned char> tga(18 + size * size * 4);
+        tga[2] = 2;
+        tga[12] = size & 0xFF; tga[13] = size >> 8;
+        tga[14] = size & 0xFF; tga[15] = size >> 8;
+        tga[16] = 32;
+        tga[17] = 8 | 0x20; // 8 alpha bits, top-left origin
+        for (int i = 0; i < size * size; ++i) {
+            unsigned char* px = &tga[18 + i * 4];
+            px[0] = (unsigned char)(seed * 37 + i);
+            px[1] = (unsigned char)(seed * 11 + i / size);
+            px[2] = (unsigned char)(seed * 5);
+            px[3] = 0xFF;
+        }
+        return tga;
+    }
+
+    uint32_t crc32(const unsigned char* data, size_t size, uint32_t crc = 0) {
+        crc = ~crc;
+        for (size_t i = 0; i < size; ++i) {
+            crc ^= data[i];
+            for (int bit = 0; bit < 8; ++bit) crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+        return ~crc;
+    }
+
+    void put_be32(std::vector<unsigned char>& out, uint32_t value) {
+        out.push_back(value >> 24); out.push_back(value >> 16);
+        out.push_back(value >> 8); out.push_back(value);
+    }
+
+    void put_chunk(std::vector<unsigned char>& out, const char* type, const std::vector<unsigned char>& data) {
+        put_be32(out, data.size());
+        size_t start = out.size();
+        out.insert(out.end(), type, type + 4);
+        out.insert(out.end(), data.begin(), data.end());
+        put_be32(out, crc32(&out[start], out.size() - start));
+    }
+
+    void put_be64(std::vector<unsigned char>& out, uint64_t value) {
+        put_be32(out, value >> 32);
+        put_be32(out, (uint32_t)value);
+    }
+
+    struct RomfsDir {
+        std::string name;
+        int parent;
+    };
+
+    struct RomfsFile {
+        std::string name;
+        int parent;
+        std::vector<unsigned char> data;
+    };
+
+    // Same as the RomFS readers' hash of an entry's name
+    uint32_t romfs_hash(uint32_t parent, const std::string& name, uint32_t buckets) {
+        uint32_t hash = parent ^ 123456789;
+        for (unsigned char c : name) {
+            hash = (hash >> 5) | (hash << 27);
+            hash ^= c;
+        }
+        return hash % buckets;
+    }
+
+    // A .wuhb as wuhbtool writes it: header, directory hash table and
+    // entries, file hash table and entries, then the file data. dirs[0] is
+    // the root; entries list their children in the order given.
+    std::vector<unsigned char> make_romfs(const std::vector<RomfsDir>& dirs, const std::vector<RomfsFile>& files) {
+        const uint32_t none = 0xFFFFFFFF;
+        auto padded = [](size_t size) { return (uint32_t)((size + 3) & ~3); };
+
+        std::vector<uint32_t> dir_offset, file_offset, data_offset;
+        uint32_t dir_table_size = 0, file_table_size = 0;
+        uint64_t data_size = 0;
+        for (const auto& dir : dirs) {
+            dir_offset.push_back(dir_table_size);
+            dir_table_size += 0x18 + padded(dir.name.size());
+        }
+        for (const auto& file : files) {
+            file_offset.push_back(file_table_size);
+            file_table_size += 0x20 + padded(file.name.size());
+            data_offset.push_back(data_size);
+            data_size = (data_size + file.data.size() + 15) & ~15ull;
+        }
+
+        auto first_dir = [&](int parent, int after) {
+            for (int i = after + 1; i < (int)dirs.size(); ++i) if (i != 0 && dirs[i].parent == parent) return dir_offset[i];
+            return none;
+        };
+        auto first_file = [&](int parent, int after) {
+            for (int i = after + 1; i < (int)files.size(); ++i) if (files[i].parent == parent) return file_offset[i];
+            return none;
+        };
+
+        std::vector<uint32_t> dir_buckets(dirs.size(), none), dir_next(dirs.size(), none);
+        for (size_t i = 0; i < dirs.size(); ++i) {
+            uint32_t bucket = romfs_hash(dir_offset[dirs[i].parent], dirs[i].name, dirs.size());
+            dir_next[i] = dir_buckets[bucket];
+            dir_buckets[bucket] = dir_offset[i];
+        }
+        std::vector<uint32_t> file_buckets(files.size(), none), file_next(files.size(), none);
+        for (size_t i = 0; i < files.size(); ++i) {
+            uint32_t bucket = romfs_hash(dir_offset[files[i].parent], files[i].name, files.size());
+            file_next[i] = file_buckets[bucket];
+            file_buckets[bucket] = file_offset[i];
+        }
+
+        const uint64_t dir_hash_offset = 0x50;
+        const uint64_t dir_table_offset = dir_hash_offset + dir_buckets.size() * 4;
+        const uint64_t file_hash_offset = dir_table_offset + dir_table_size;
+        const uint64_t file_table_offset = file_hash_offset + file_buckets.size() * 4;
+        const uint64_t file_data_offset = (file_table_offset + file_table_size + 15) & ~15ull;
+
+        std::vector<unsigned char> out = { 'W', 'U', 'H', 'B' };
+        put_be32(out, 0x50);
+        put_be64(out, dir_hash_offset); put_be64(out, dir_buckets.size() * 4);
+        put_be64(out, dir_table_offset); put_be64(out, dir_table_size);
+        put_be64(out, file_hash_offset); put_be64(out, file_buckets.size() * 4);
+        put_be64(out, file_table_offset); put_be64(out, file_table_size);
+        put_be64(out, file_data_offset);
+
+        auto put_name = [&](const std::string& name) {
+            out.insert(out.end(), name.begin(), name.end());
+            out.resize(out.size() + padded(name.size()) - name.size(), 0);
+        };
+
+        for (uint32_t bucket : dir_buckets) put_be32(out, bucket);
+        for (size_t i = 0; i < dirs.size(); ++i) {
+            put_be32(out, dir_offset[dirs[i].parent]);
+            put_be32(out, i == 0 ? none : first_dir(dirs[i].parent, i));
+            put_be32(out, first_dir(i, 0));
+            put_be32(out, first_file(i, -1));
+            put_be32(out, dir_next[i]);
+            put_be32(out, dirs[i].name.size());
+            put_name(dirs[i].name);
+        }
+
+        for (uint32_t bucket : file_buckets) put_be32(out, bucket);
+        for (size_t i = 0; i < files.size(); ++i) {
+            put_be32(out, dir_offset[files[i].parent]);
+            put_be32(out, first_file(files[i].parent, i));
+            put_be64(out, data_offset[i]);
+            put_be64(out, files[i].data.size());
+            put_be32(out, file_next[i]);
+            put_be32(out, files[i].name.size());
+            put_name(files[i].name);
+        }
+
+        for (size_t i = 0; i < files.size(); ++i) {
+            out.resize(file_data_offset + data_offset[i], 0);
+            out.insert(out.end(), files[i].data.begin(), files[i].data.end());
+        }
+        return out;
+    }
+
+    // RGBA PNG the size of the icons in custom_icons/, with the image data in
+    // stored (uncompressed) deflate blocks so no zlib is needed
+    std::vector<unsigned char> make_png(int seed) {
+        const int size = 256;
+        const size_t row_size = 1 + size * 4;
+
+        std::vector<unsigned char> raw(row_size * size);
+        for (int y = 0; y < size; ++y) {
+            unsigned char* row = &raw[y * row_size];
+            row[0] = 0; // no filter
+            for (int x = 0; x < size; ++x) {
+                row[1 + x * 4] = (unsigned char)(seed * 23 + x);
+                row[2 + x * 4] = (unsigned char)(seed * 7 + y);
+                row[3 + x * 4] = (unsigned char)(seed * 3);
+                row[4 + x * 4] = 0xFF;
+            }
+        }
+
+        std::vector<unsigned char> zlib = { 0x78, 0x01 };
+        for (size_t pos = 0; pos < raw.size(); pos += 0xFFFF) {
+            size_t len = std::min<size_t>(0xFFFF, raw.size() - pos);
+            zlib.push_back(pos + len == raw.size() ? 1 : 0);
+            zlib.push_back(len & 0xFF); zlib.push_back(len >> 8);
+            zlib.push_back(~len & 0xFF); zlib.push_back((~len >> 8) & 0xFF);
+            zlib.insert(zlib.end(), raw.begin() + pos, raw.begin() + pos + len);
+        }
+        uint32_t a = 1, b = 0;
+        for (unsigned char c : raw) {
+            a = (a + c) % 65521;
+            b = (b + a) % 65521;
+        }
+        put_be32(zlib, (b << 16) | a);
+
+        std::vector<unsigned char> header;
+        put_be32(header, size);
+        put_be32(header, size);
+        header.insert(header.end(), { 8, 6, 0, 0, 0 }); // 8 bit RGBA
+
+        std::vector<unsigned char> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        put_chunk(png, "IHDR", header);
+        put_chunk(png, "IDAT", zlib);
+        put_chunk(png, "IEND", {});
+        return png;
+    }
+
+    // Baseline JPEG of a gradient, about the size a real capture compresses to
+    std::vector<unsigned char> make_jpeg(int seed, int width, int height) {
+        jpeg_compress_struct info;
+        jpeg_error_mgr error;
+        info.err = jpeg_std_error(&error);
+        jpeg_create_compress(&info);
+
+        unsigned char* buffer = nullptr;
+        unsigned long size = 0;
+        jpeg_mem_dest(&info, &buffer, &size);
+        info.image_width = width;
+        info.image_height = height;
+        info.input_components = 3;
+        info.in_color_space = JCS_RGB;
+        jpeg_set_defaults(&info);
+        jpeg_set_quality(&info, 90, TRUE);
+        jpeg_start_compress(&info, TRUE);
+
+        std::vector<unsigned char> row(width * 3);
+        JSAMPROW rows[1] = { row.data() };
+        while (info.next_scanline < info.image_height) {
+            int y = info.next_scanline;
+            for (int x = 0; x < width; ++x) {
+                row[x * 3 + 0] = (unsigned char)(seed * 23 + x / 4);
+                row[x * 3 + 1] = (unsigned char)(seed * 7 + y / 3);
+                row[x * 3 + 2] = (unsigned char)(seed * 3 + (x ^ y) / 8);
+            }
+            jpeg_write_scanlines(&info, rows, 1);
+        }
+        jpeg_finish_compress(&info);
+        jpeg_destroy_compress(&info);
+
+        std::vector<unsigned char> jpeg(buffer, buffer + size);
+        free(buffer);
+        return jpeg;
+    }
+
+    // Laid out like the Aroma screenshot plugin: a folder per title, files
+    // named after when they were taken, TV and GamePad captures. Every tenth
+    // one is a PNG.
+    bool write_screenshot(const std::string& sd, int i) {
+        std::string dir = sd + "wiiu/screenshots/" + title_names[(i / 20) % title_name_count];
+        if (!make_dirs(dir)) return false;
+
+        int day = 1 + i / 1440 % 28, minute = i % 1440;
+        bool drc = i % 3 == 2;
+        char name[64];
+        snprintf(name, sizeof(name), "/2024-05-%02d_%02d-%02d-00_%s.%s", day, minute / 60, minute % 60,
+                 drc ? "DRC" : "TV", i % 10 == 9 ? "png" : "jpg");
+
+        std::vector<unsigned char> data = i % 10 == 9 ? make_png(i) : make_jpeg(i, drc ? 854 : 1280, drc ? 480 : 720);
+        return write_file(dir + name, data.data(), data.size());
+    }
+
+    bool write_title(const std::string& fs, const Title& title, int seed) {
+        std::string dir = fs + title.path + "/meta";
+        if (!make_dirs(dir) || !make_dirs(fs + title.path + "/code") || !make_dirs(fs + title.path + "/content")) return false;
+
+        char meta[2048];
+        int len = snprintf(meta, sizeof(meta),
+            "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+            "<menu type=\"complex\" access=\"777\">\n"
+            "  <version type=\"unsignedInt\" length=\"4\">33</version>\n"
+            "  <product_code type=\"string\" length=\"32\">WUP-P-A%03X</product_code>\n"
+            "  <company_code type=\"string\" length=\"8\">0001</company_code>\n"
+            "  <title_id type=\"hexBinary\" length=\"8\">00050000%08X</title_id>\n"
+            "  <title_version type=\"unsignedInt\" length=\"4\">0</title_version>\n"
+            "  <region type=\"hexBinary\" length=\"4\">00000004</region>\n"
+            "  <longname_ja type=\"string\" length=\"512\">%s</longname_ja>\n"
+            "  <longname_en type=\"string\" length=\"512\">%s</longname_en>\n"
+            "  <longname_fr type=\"string\" length=\"512\">%s</longname_fr>\n"
+            "  <shortname_en type=\"string\" length=\"256\">%s</shortname_en>\n"
+            "  <publisher_en type=\"string\" length=\"256\">Nintendo</publisher_en>\n"
+            "</menu>\n",
+            seed & 0xFFF, title.low,
+            title.name.c_str(), title.name.c_str(), title.name.c_str(),
+            title_names[seed % title_name_count]);
+        if (!write_file(dir + "/meta.xml", meta, len)) return false;
+
+        std::vector<unsigned char> tga = make_tga(seed);
+        return write_file(dir + "/iconTex.tga", tga.data(), tga.size());
+    }
+
+    // Bundle with the entries wuhbtool writes for an app: its .rpx, meta.ini
+    // and the icon
+    std::vector<unsigned char> make_wuhb(const std::string& name, const std::string& title, int seed) {
+        std::string ini = "[menu]\nlongname=" + title + "\nshortname=" + title + "\nauthor=switchU\n";
+        std::vector<RomfsDir> dirs = { { "", 0 }, { "code", 0 }, { "meta", 0 } };
+        std::vector<RomfsFile> files = {
+            { name + ".rpx", 1, { 0x7F, 'E', 'L', 'F' } },
+            { "meta.ini", 2, std::vector<unsigned char>(ini.begin(), ini.end()) },
+            { "iconTex.tga", 2, make_tga(seed) },
+        };
+        return make_romfs(dirs, files);
+    }
+
+    // Mix of the layouts the scan has to deal with: a .wuhb carrying its own
+    // name and icon, a plain .rpx with meta.xml and icon.png next to it, both
+    // (the .wuhb wins), the odd .rpx without an icon, data files before the
+    // binary, and the odd folder with nothing to launch that the scan skips
+    bool write_homebrew(const std::string& sd, int i) {
+        std::string name = homebrew_names[i % homebrew_name_count];
+        std::string title = homebrew_titles[i % homebrew_name_count];
+        if (i >= homebrew_name_count) {
+            name += "_" + std::to_string(i / homebrew_name_count);
+            title += " " + std::to_string(i / homebrew_name_count);
+        }
+        std::string dir = sd + "wiiu/apps/" + name;
+        if (!make_dirs(dir)) return false;
+
+        if (i % 13 == 12) {
+            return write_file(dir + "/readme.txt", "\n", 1);
+        }
+        if (i % 7 == 3) {
+            if (!write_file(dir + "/config.ini", "\n", 1) || !write_file(dir + "/data.bin", "\0", 1)) return false;
+        }
+
+        bool wuhb = i % 2 == 0 || i % 5 == 4;
+        bool rpx = i % 2 == 1;
+        if (wuhb) {
+            std::vector<unsigned char> bundle = make_wuhb(name, title, i);
+            if (!write_file(dir + "/" + name + ".wuhb", bundle.data(), bundle.size())) return false;
+        }
+        if (!rpx) return true;
+        if (!write_file(dir + "/" + name + ".rpx", "\x7F" "ELF", 4)) return false;
+
+        char meta[512];
+        int len = snprintf(meta, sizeof(meta),
+            "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+            "<app version=\"1\">\n"
+            "  <name>%s</name>\n"
+            "  <coder>switchU</coder>\n"
+            "  <version>1.%d</version>\n"
+            "  <short_description>Generated app</short_description>\n"
+            "</app>\n",
+            title.c_str(), i);
+        if (!write_file(dir + "/meta.xml", meta, len)) return false;
+
+        if (i % 11 == 7) return true;
+        std::vector<unsigned char> png = make_png(i);
+        return write_file(dir + "/icon.png", png.data(), png.size());
+    }
+
+    bool write_custom_icon(const std::string& sd, const std::string& folder, int seed) {
+        std::string dir = sd + "switchU/custom_icons/" + folder;
+        if (!make_dirs(dir)) return false;
+        std::vector<unsigned char> png = make_png(seed);
+        return write_file(dir + "/icon.png", png.data(), png.size());
+    }
+
+    bool write_mcp_list(const std::string& sd, const std::vector<Title>& titles) {
+        std::string path = sd + "switchU/mcp_titles.txt";
+        FILE* file = fopen(path.c_str(), "w");
+        if (!file) {
+            fprintf(stderr, "Failed to write %s\n", path.c_str());
+            return false;
+        }
+        for (const auto& title : titles) {
+            fprintf(file, "00050000%08X %08X %s %s\n", title.low, MCP_STANDIN_APP_TYPE_GAME,
+                    title.device, title.path.c_str());
+        }
+        fclose(file);
+        return true;
+    }
+}
+
+namespace LibraryGen {
+    bool generate(const std::string& root, const Options& options) {
+        std::string fs = root + "/" ROOT_PATH;
+        std::string sd = root + "/" SD_CARD_PATH;
+
+        if (!make_dirs(sd + "switchU/fonts") || !make_dirs(sd + "switchU/custom_icons") || !make_dirs(sd + "wiiu/apps")) {
+            return false;
+        }
+        if (!options.assets_dir.empty()) symlink(options.assets_dir.c_str(), (sd + "switchU/assets").c_str());
+        if (!options.font.empty()) symlink(options.font.c_str(), (sd + "switchU/fonts/font.ttf").c_str());
+
+        // The disc title goes first, then mlc and usb
+        std::vector<Title> titles;
+        if (options.disc) {
+            titles.push_back({ odd_title_base, "odd", device_title_path(odd_title_base, "odd", options.titles_on_sd), "" });
+        }
+        for (int i = 0; i < options.titles; ++i) {
+            titles.push_back({ mlc_title_base + i, "mlc", device_title_path(mlc_title_base + i, "mlc", options.titles_on_sd), "" });
+        }
+        for (int i = 0; i < options.usb_titles; ++i) {
+            titles.push_back({ usb_title_base + i, "usb", device_title_path(usb_title_base + i, "usb", options.titles_on_sd), "" });
+        }
+
+        int custom_icons = options.custom_icons;
+        for (size_t i = 0; i < titles.size(); ++i) {
+            titles[i].name = std::string(title_names[i % title_name_count]) + " " + std::to_string(i);
+            if (!write_title(fs, titles[i], i)) return false;
+            if (custom_icons > 0) {
+                if (!write_custom_icon(sd, std::string(sanitize_title_for_path(titles[i].name)), i)) return false;
+                custom_icons--;
+            }
+        }
+
+        int homebrew = options.homebrew < 0 ? options.titles / 10 + 1 : options.homebrew;
+        for (int i = 0; i < homebrew; ++i) {
+            if (!write_homebrew(sd, i)) return false;
+        }
+
+        for (int i = 0; i < options.screenshots; ++i) {
+            if (!write_screenshot(sd, i)) return false;
+        }
+
+        if (options.mcp_list && !write_mcp_list(sd, titles)) return false;
+        return true;
+    }
+
+    std::string title_path(int i, const Options& options) {
+        return ROOT_PATH + device_title_path(mlc_title_base + i, "mlc", options.titles_on_sd);
+    }
+
+    std::string meta_path(int i, const Options& options) {
+        return title_path(i, options) + "/meta/meta.xml";
+    }
+
+    std::string icon_path(int i, const Options& options) {
+        return title_path(i, options) + "/meta/iconTex.tga";
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+
+// Writes a synthetic title library in the console filesystem layout the
+// launcher reads (see platform/platform.hpp), for testing and benchmarking
+// the scan without a console full of games.
+namespace LibraryGen {
+    struct Options {
+        int titles = 100;           // installed titles on mlc
+        int usb_titles = 0;         // installed titles on usb
+        bool disc = false;          // one more title in the disc drive
+        int homebrew = -1;          // apps in wiiu/apps, -1 is titles / 10 + 1
+        int custom_icons = 0;       // titles and apps that also get a custom icon
+        int screenshots = 0;        // captures in wiiu/screenshots for the album
+        bool titles_on_sd = false;  // keep title folders under the SD card so the tree can be copied to a real one
+        bool mcp_list = true;       // write a title list for the MCP stand-in
+        std::string assets_dir;     // SwitchU assets/ folder to link, none if empty
+        std::string font;           // TTF font to link as fonts/font.ttf, none if empty
+    };
+
+    // root is the directory that holds fs/, it is created if missing
+    bool generate(const std::string& root, const Options& options);
+
+    // Paths of the i-th mlc title's files, relative to root
+    std::string title_path(int i, const Options& options);
+    std::string meta_path(int i, const Options& options);
+    std::string icon_path(int i, const Options& options);
+}
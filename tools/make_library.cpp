@@ -0,0 +1,76 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "library_gen.hpp"
+
+// Builds a fake console filesystem with a synthetic title library, for
+// running SwitchU-linux or the scan against a library of any size.
+
+static void usage(const char* argv0) {
+    fprintf(stderr,
+            "usage: %s [options] DIR\n"
+            "Writes a console filesystem under DIR/fs for SwitchU-linux to run in.\n"
+            "  --titles N        installed titles on mlc (default 100)\n"
+            "  --usb N           installed titles on usb (default 0)\n"
+            "  --disc            put one more title in the disc drive\n"
+            "  --homebrew N      apps in wiiu/apps (default titles / 10 + 1)\n"
+            "  --custom-icons N  give the first N titles a custom icon (default 0)\n"
+            "  --screenshots N   captures in wiiu/screenshots for the album (default 0)\n"
+            "  --on-sd           keep the titles on the SD card, to copy DIR/fs/vol/external01\n"
+            "                    to a real one and scan them on a console\n"
+            "  --no-mcp-list     don't write switchU/mcp_titles.txt, titles are then found by\n"
+            "                    walking the storage folders (Linux only)\n"
+            "  --assets DIR      SwitchU assets folder to link (e.g. copytosd/switchU/assets)\n"
+            "  --font FILE       TTF font to link as the UI font\n",
+            argv0);
+}
+
+int main(int argc, char* argv[]) {
+    LibraryGen::Options options;
+    std::string root;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--titles" && has_value) options.titles = atoi(argv[++i]);
+        else if (arg == "--usb" && has_value) options.usb_titles = atoi(argv[++i]);
+        else if (arg == "--disc") options.disc = true;
+        else if (arg == "--homebrew" && has_value) options.homebrew = atoi(argv[++i]);
+        else if (arg == "--custom-icons" && has_value) options.custom_icons = atoi(argv[++i]);
+        else if (arg == "--screenshots" && has_value) options.screenshots = atoi(argv[++i]);
+        else if (arg == "--on-sd") options.titles_on_sd = true;
+        else if (arg == "--no-mcp-list") options.mcp_list = false;
+        else if (arg == "--assets" && has_value) options.assets_dir = argv[++i];
+        else if (arg == "--font" && has_value) options.font = argv[++i];
+        else if (root.empty() && arg[0] != '-') root = arg;
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (root.empty()) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    // Links have to point somewhere that still resolves from inside DIR
+    auto absolute = [](std::string& path) {
+        if (path.empty() || path[0] == '/') return;
+        char* resolved = realpath(path.c_str(), nullptr);
+        if (resolved) {
+            path = resolved;
+            free(resolved);
+        }
+    };
+    absolute(options.assets_dir);
+    absolute(options.font);
+
+    if (!LibraryGen::generate(root, options)) {
+        return 1;
+    }
+
+    printf("Wrote %d titles to %s/fs\n", options.titles + options.usb_titles + (options.disc ? 1 : 0), root.c_str());
+    return 0;
+}